@@ -0,0 +1,178 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/common.h"
+#include "common/logging/text_formatter.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/scope_exit.h"
+
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/arm/arm_interface.h"
+
+// Exercises the CoreTiming event queue with thousands of concurrently pending events, the way
+// kernel timers and thread wakeups use it: Scheduling in bulk, cancelling through handles, and
+// periodic events rescheduling themselves from their callback. Events must fire ordered by time,
+// and in scheduling order for the same time.
+
+using Clock = std::chrono::high_resolution_clock;
+
+/// Bookkeeping of the events scheduled by a benchmark, to check the order they fire in
+struct EventLog {
+    std::vector<s64> scheduled_time;    ///< Indexed by the userdata of the event
+    std::vector<bool> cancelled;
+    s64 last_time = -1;
+    u64 last_userdata = 0;
+    u64 num_fired = 0;
+    bool in_order = true;
+};
+
+static EventLog event_log;
+static int one_shot_event_type;
+static int periodic_event_type;
+static s64 periodic_interval;
+static u64 periodic_fires_left;
+
+static double MicrosecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static void OneShotCallback(u64 userdata, int cycles_late) {
+    const s64 time = static_cast<s64>(CoreTiming::GetTicks()) - cycles_late;
+    if (event_log.cancelled[userdata] || time != event_log.scheduled_time[userdata] ||
+        time < event_log.last_time ||
+        (time == event_log.last_time && userdata < event_log.last_userdata)) {
+        event_log.in_order = false;
+    }
+
+    event_log.last_time = time;
+    event_log.last_userdata = userdata;
+    ++event_log.num_fired;
+}
+
+static void PeriodicCallback(u64 userdata, int cycles_late) {
+    ++event_log.num_fired;
+    if (periodic_fires_left > 0) {
+        --periodic_fires_left;
+        CoreTiming::ScheduleEvent(periodic_interval - cycles_late, periodic_event_type, userdata);
+    }
+}
+
+/// Fires all pending events by idling the CPU up to each of them
+static void RunUntilIdle(u64 num_expected) {
+    while (event_log.num_fired < num_expected) {
+        CoreTiming::Idle();
+        CoreTiming::Advance();
+    }
+}
+
+/// Schedules events at random times, cancels every other one and fires the rest
+static bool BenchmarkOneShot(unsigned num_events) {
+    std::mt19937 random(1234);
+    // A small range makes sure that plenty of events share the same time
+    std::uniform_int_distribution<s64> time_distribution(1, num_events / 4 + 1);
+
+    event_log = EventLog();
+    event_log.scheduled_time.resize(num_events);
+    event_log.cancelled.resize(num_events, false);
+    std::vector<CoreTiming::EventHandle> handles(num_events);
+
+    auto start = Clock::now();
+    for (unsigned i = 0; i < num_events; ++i) {
+        const s64 cycles = time_distribution(random);
+        event_log.scheduled_time[i] = CoreTiming::GetTicks() + cycles;
+        handles[i] = CoreTiming::ScheduleEvent(cycles, one_shot_event_type, i);
+    }
+    const double schedule_us = MicrosecondsSince(start);
+
+    start = Clock::now();
+    for (unsigned i = 0; i < num_events; i += 2) {
+        CoreTiming::CancelEvent(handles[i]);
+        event_log.cancelled[i] = true;
+    }
+    const double cancel_us = MicrosecondsSince(start);
+
+    // Cancelling again must be a no-op, the handles are stale now
+    for (unsigned i = 0; i < num_events; i += 2)
+        CoreTiming::CancelEvent(handles[i]);
+
+    start = Clock::now();
+    RunUntilIdle(num_events / 2);
+    const double fire_us = MicrosecondsSince(start);
+
+    LOG_INFO(Frontend, "%u one-shot events: schedule %.1f ns, cancel %.1f ns, fire %.1f ns per event",
+             num_events, schedule_us * 1000.0 / num_events, cancel_us * 2000.0 / num_events,
+             fire_us * 2000.0 / num_events);
+
+    if (!event_log.in_order || CoreTiming::IsScheduled(one_shot_event_type)) {
+        LOG_ERROR(Frontend, "One-shot events fired out of order or were left over");
+        return false;
+    }
+    return true;
+}
+
+/// Keeps `num_timers` periodic events pending, each rescheduling itself when it fires
+static bool BenchmarkPeriodic(unsigned num_timers, u64 num_fires) {
+    event_log = EventLog();
+    periodic_interval = 1000;
+    periodic_fires_left = num_fires - num_timers;
+
+    for (unsigned i = 0; i < num_timers; ++i)
+        CoreTiming::ScheduleEvent(periodic_interval + i, periodic_event_type, i);
+
+    auto start = Clock::now();
+    RunUntilIdle(num_fires);
+    const double fire_us = MicrosecondsSince(start);
+
+    LOG_INFO(Frontend, "%u periodic events: %.1f ns per fire and reschedule (%llu fires)",
+             num_timers, fire_us * 1000.0 / num_fires, static_cast<unsigned long long>(num_fires));
+
+    if (CoreTiming::IsScheduled(periodic_event_type)) {
+        LOG_ERROR(Frontend, "Periodic events were left over");
+        return false;
+    }
+    return true;
+}
+
+/// Application entry point
+int __cdecl main(int argc, char** argv) {
+    std::shared_ptr<Log::Logger> logger = Log::InitGlobalLogger();
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(&log_filter);
+    std::thread logging_thread(Log::TextLoggingLoop, logger, &log_filter);
+    SCOPE_EXIT({
+        Log::SetGlobalFilter(nullptr);
+        logger->Close();
+        logging_thread.join();
+    });
+
+    const unsigned max_events = (argc >= 2) ? std::strtoul(argv[1], nullptr, 0) : 10000;
+
+    // CoreTiming keeps the time in the down count of the application core
+    Core::Init();
+    CoreTiming::Init();
+    SCOPE_EXIT({
+        CoreTiming::Shutdown();
+        Core::Shutdown();
+    });
+
+    one_shot_event_type = CoreTiming::RegisterEvent("OneShotBenchmark", OneShotCallback);
+    periodic_event_type = CoreTiming::RegisterEvent("PeriodicBenchmark", PeriodicCallback);
+
+    bool success = true;
+    for (unsigned num_events = 100; num_events <= max_events; num_events *= 10) {
+        success &= BenchmarkOneShot(num_events);
+        success &= BenchmarkPeriodic(num_events, 100 * static_cast<u64>(num_events));
+    }
+
+    return success ? 0 : -1;
+}
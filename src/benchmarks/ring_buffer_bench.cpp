@@ -0,0 +1,123 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/common.h"
+#include "common/concurrent_ring_buffer.h"
+#include "common/lockfree_ring_buffer.h"
+#include "common/logging/text_formatter.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/scope_exit.h"
+
+// Compares the lock-free ring buffer used by the logger against the mutex based
+// ConcurrentRingBuffer it replaced. Producers push numbered items as fast as they can while a
+// single consumer pops them in batches and checks that every producer's items arrive in order.
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Item {
+    u32 producer;
+    u32 sequence;
+};
+
+static const size_t BUFFER_CAPACITY = 1024;
+static const size_t POP_BATCH_SIZE = 64;
+
+using MutexBuffer = Common::ConcurrentRingBuffer<Item, BUFFER_CAPACITY>;
+using SpscBuffer = Common::LockFreeRingBuffer<Item, BUFFER_CAPACITY,
+                                              Common::RingBufferProducers::Single>;
+using MpscBuffer = Common::LockFreeRingBuffer<Item, BUFFER_CAPACITY,
+                                              Common::RingBufferProducers::Multiple>;
+
+/**
+ * Pushes `items_per_producer` items from each of `num_producers` threads through a new buffer.
+ * @return Throughput in items per second, or a negative value if items arrived out of order
+ */
+template <typename Buffer>
+static double RunBenchmark(unsigned num_producers, u32 items_per_producer) {
+    // The buffers are too large for the stack
+    std::unique_ptr<Buffer> buffer(new Buffer);
+    std::vector<u32> next_sequence(num_producers, 0);
+    bool in_order = true;
+
+    const auto start = Clock::now();
+
+    std::vector<std::thread> producers;
+    for (unsigned producer = 0; producer < num_producers; ++producer) {
+        producers.emplace_back([&buffer, producer, items_per_producer] {
+            for (u32 sequence = 0; sequence < items_per_producer; ++sequence) {
+                Item item = { producer, sequence };
+                buffer->Push(item);
+            }
+        });
+    }
+
+    std::array<Item, POP_BATCH_SIZE> batch;
+    u64 remaining = static_cast<u64>(num_producers) * items_per_producer;
+    while (remaining > 0) {
+        size_t num_items = buffer->BlockingPop(batch.data(), batch.size());
+        for (size_t i = 0; i < num_items; ++i) {
+            const Item& item = batch[i];
+            if (item.sequence != next_sequence[item.producer]++)
+                in_order = false;
+        }
+        remaining -= num_items;
+    }
+
+    const auto end = Clock::now();
+    for (auto& thread : producers)
+        thread.join();
+
+    if (!in_order)
+        return -1.0;
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    return num_producers * items_per_producer / seconds;
+}
+
+template <typename Buffer>
+static bool Report(const char* name, unsigned num_producers, u32 items_per_producer) {
+    double items_per_second = RunBenchmark<Buffer>(num_producers, items_per_producer);
+    if (items_per_second < 0.0) {
+        LOG_ERROR(Frontend, "%s, %u producer(s): items arrived out of order", name, num_producers);
+        return false;
+    }
+
+    LOG_INFO(Frontend, "%s, %u producer(s): %.2fM items/s", name, num_producers,
+             items_per_second / 1e6);
+    return true;
+}
+
+/// Application entry point
+int __cdecl main(int argc, char** argv) {
+    std::shared_ptr<Log::Logger> logger = Log::InitGlobalLogger();
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(&log_filter);
+    std::thread logging_thread(Log::TextLoggingLoop, logger, &log_filter);
+    SCOPE_EXIT({
+        Log::SetGlobalFilter(nullptr);
+        logger->Close();
+        logging_thread.join();
+    });
+
+    const u32 items_per_producer = (argc >= 2) ? std::strtoul(argv[1], nullptr, 0) : 200000;
+    const unsigned max_producers = 4;
+
+    bool success = true;
+    // ConcurrentRingBuffer only wakes up one waiting writer per pop, so several producers blocked
+    // on a full buffer can hang indefinitely. It is only measured with a single producer.
+    success &= Report<MutexBuffer>("ConcurrentRingBuffer", 1, items_per_producer);
+    success &= Report<SpscBuffer>("LockFreeRingBuffer (SPSC)", 1, items_per_producer);
+    for (unsigned num_producers = 1; num_producers <= max_producers; num_producers *= 2)
+        success &= Report<MpscBuffer>("LockFreeRingBuffer (MPSC)", num_producers, items_per_producer);
+
+    return success ? 0 : -1;
+}
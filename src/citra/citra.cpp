@@ -6,6 +6,7 @@
 
 #include "common/common.h"
 #include "common/logging/text_formatter.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/scope_exit.h"
@@ -14,6 +15,7 @@
 #include "core/system.h"
 #include "core/core.h"
 #include "core/loader/loader.h"
+#include "core/savestate.h"
 
 #include "citra/config.h"
 #include "citra/emu_window/emu_window_glfw.h"
@@ -22,8 +24,22 @@
 int __cdecl main(int argc, char **argv) {
     std::shared_ptr<Log::Logger> logger = Log::InitGlobalLogger();
     Log::Filter log_filter(Log::Level::Debug);
-    std::thread logging_thread(Log::TextLoggingLoop, logger, &log_filter);
+    Log::SetGlobalFilter(&log_filter);
+
+    // The output is chosen by the config, messages logged until then wait in the log buffer
+    Config config;
+    log_filter.ParseFilterString(Settings::values.log_filter);
+
+    std::thread logging_thread;
+    std::shared_ptr<Log::BinaryLogWriter> binary_log;
+    if (Settings::values.log_binary)
+        binary_log = Log::OpenDefaultBinaryLog();
+    if (binary_log != nullptr)
+        logging_thread = std::thread(Log::BinaryLoggingLoop, logger, &log_filter, binary_log);
+    else
+        logging_thread = std::thread(Log::TextLoggingLoop, logger, &log_filter);
     SCOPE_EXIT({
+        Log::SetGlobalFilter(nullptr);
         logger->Close();
         logging_thread.join();
     });
@@ -33,9 +49,6 @@ int __cdecl main(int argc, char **argv) {
         return -1;
     }
 
-    Config config;
-    log_filter.ParseFilterString(Settings::values.log_filter);
-
     std::string boot_filename = argv[1];
     EmuWindow_GLFW* emu_window = new EmuWindow_GLFW;
 
@@ -47,6 +60,12 @@ int __cdecl main(int argc, char **argv) {
         return -1;
     }
 
+    // An optional savestate to continue from, e.g. a checkpoint of a long test scenario
+    if (argc >= 3 && !SaveState::Load(argv[2])) {
+        LOG_CRITICAL(Frontend, "Failed to load savestate %s", argv[2]);
+        return -1;
+    }
+
     while (emu_window->IsOpen()) {
         Core::RunLoop();
     }
@@ -59,6 +59,14 @@ void Config::ReadValues() {
     // Core
     Settings::values.gpu_refresh_rate = glfw_config->GetInteger("Core", "gpu_refresh_rate", 30);
     Settings::values.frame_skip = glfw_config->GetInteger("Core", "frame_skip", 0);
+    Settings::values.use_auto_frame_skip = glfw_config->GetBoolean("Core", "use_auto_frame_skip", false);
+    Settings::values.max_auto_frame_skip = glfw_config->GetInteger("Core", "max_auto_frame_skip", 4);
+    Settings::values.skip_idle_loops = glfw_config->GetBoolean("Core", "skip_idle_loops", true);
+    Settings::values.speed_limit = glfw_config->GetInteger("Core", "speed_limit", 100);
+    Settings::values.use_multi_core = glfw_config->GetBoolean("Core", "use_multi_core", false);
+    Settings::values.use_async_fs = glfw_config->GetBoolean("Core", "use_async_fs", false);
+    Settings::values.checkpoint_interval = glfw_config->GetInteger("Core", "checkpoint_interval", 0);
+    Settings::values.max_checkpoints = glfw_config->GetInteger("Core", "max_checkpoints", 30);
 
     // Data Storage
     Settings::values.use_virtual_sd = glfw_config->GetBoolean("Data Storage", "use_virtual_sd", true);
@@ -68,6 +76,8 @@ void Config::ReadValues() {
 
     // Miscellaneous
     Settings::values.log_filter = glfw_config->Get("Miscellaneous", "log_filter", "*:Info");
+    Settings::values.log_binary = glfw_config->GetBoolean("Miscellaneous", "log_binary", false);
+    Settings::values.dump_gpu_data = glfw_config->GetBoolean("Miscellaneous", "dump_gpu_data", false);
 }
 
 void Config::Reload() {
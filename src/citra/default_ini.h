@@ -29,6 +29,14 @@ pad_sright =
 [Core]
 gpu_refresh_rate = ## 30 (default)
 frame_skip = ## 0: No frameskip (default), 1 : 2x frameskip, 2 : 4x frameskip, etc.
+use_auto_frame_skip = ## 0: Use frame_skip (default), 1: Skip frames automatically to maintain full speed
+max_auto_frame_skip = ## Maximum number of frames skipped per rendered frame in automatic mode, 4 (default)
+skip_idle_loops = ## 0: Always emulate busy-wait loops, 1: Fast-forward to the next event when the CPU spins in an idle loop (default)
+speed_limit = ## Emulation speed limit in percent of real time, 100 (default). 0: Unlimited
+use_multi_core = ## Run the application and system ARM11 cores on separate host threads. Experimental. 0 (default): Off, 1: On
+use_async_fs = ## Perform FS file reads and writes on I/O worker threads while the requesting thread waits. Experimental. 0 (default): Off, 1: On
+checkpoint_interval = ## Interval between automatic in-memory checkpoints which can be rewound to, in milliseconds of emulated time. 0 (default): Disabled
+max_checkpoints = ## Number of checkpoints kept for rewinding, the oldest ones are dropped. 30 (default)
 
 [Data Storage]
 use_virtual_sd =
@@ -38,6 +46,8 @@ region_value = ## 0 : Japan, 1 : Usa (default), 2 : Europe, 3 : Australia, 4 : C
 
 [Miscellaneous]
 log_filter = *:Info  ## Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
+log_binary = ## Write log messages to rotating binary files in the logs directory instead of the console, decode them with citra-logcat. 0 (default): Off, 1: On
+dump_gpu_data = ## Dump each distinct shader, texture and mesh drawn by the emulated GPU to the working directory once, for debugging the renderer. Slow. 0 (default): Off, 1: On
 )";
 
 }
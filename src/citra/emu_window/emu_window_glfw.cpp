@@ -8,6 +8,7 @@
 
 #include "video_core/video_core.h"
 
+#include "core/savestate.h"
 #include "core/settings.h"
 
 #include "citra/emu_window/emu_window_glfw.h"
@@ -21,6 +22,18 @@ void EmuWindow_GLFW::OnKeyEvent(GLFWwindow* win, int key, int scancode, int acti
 
     int keyboard_id = GetEmuWindow(win)->keyboard_id;
 
+    // F5 saves and F7 loads the state of the running application, F8 rewinds to a checkpoint
+    if (action == GLFW_PRESS && key == GLFW_KEY_F5) {
+        SaveState::RequestSave(SaveState::GetDefaultPath());
+        return;
+    } else if (action == GLFW_PRESS && key == GLFW_KEY_F7) {
+        SaveState::RequestLoad(SaveState::GetDefaultPath());
+        return;
+    } else if (action == GLFW_PRESS && key == GLFW_KEY_F8) {
+        SaveState::RequestRewind();
+        return;
+    }
+
     if (action == GLFW_PRESS) {
         EmuWindow::KeyPressed({key, keyboard_id});
     } else if (action == GLFW_RELEASE) {
@@ -73,10 +86,11 @@ EmuWindow_GLFW::EmuWindow_GLFW() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    std::string window_title = Common::StringFromFormat("Citra | %s-%s", Common::g_scm_branch, Common::g_scm_desc);
+    window_title = Common::StringFromFormat("Citra | %s-%s", Common::g_scm_branch, Common::g_scm_desc);
     m_render_window = glfwCreateWindow(VideoCore::kScreenTopWidth,
         (VideoCore::kScreenTopHeight + VideoCore::kScreenBottomHeight),
         window_title.c_str(), nullptr, nullptr);
+    last_title_update = std::chrono::steady_clock::now();
 
     if (m_render_window == nullptr) {
         LOG_CRITICAL(Frontend, "Failed to create GLFW window! Exiting...");
@@ -114,6 +128,15 @@ void EmuWindow_GLFW::SwapBuffers() {
 /// Polls window events
 void EmuWindow_GLFW::PollEvents() {
     glfwPollEvents();
+
+    // Show the frame statistics in the title bar, refreshed about once per second
+    auto now = std::chrono::steady_clock::now();
+    if (VideoCore::g_renderer != nullptr && now - last_title_update >= std::chrono::seconds(1)) {
+        last_title_update = now;
+        std::string title = window_title + " | " +
+                            VideoCore::g_renderer->GetFrameStats().GetResults().GetSummary();
+        glfwSetWindowTitle(m_render_window, title.c_str());
+    }
 }
 
 /// Makes the GLFW OpenGL context current for the caller thread
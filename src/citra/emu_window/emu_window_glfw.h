@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <string>
+
 #include "common/emu_window.h"
 
 struct GLFWwindow;
@@ -43,6 +46,9 @@ private:
 
     GLFWwindow* m_render_window; ///< Internal GLFW render window
 
+    std::string window_title; ///< Title without the frame statistics
+    std::chrono::steady_clock::time_point last_title_update; ///< When the title was last refreshed
+
     /// Device id of keyboard for use with KeyMap
     int keyboard_id;
 };
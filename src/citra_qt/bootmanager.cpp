@@ -1,3 +1,6 @@
+#include <future>
+#include <memory>
+
 #include <QHBoxLayout>
 #include <QKeyEvent>
 #include <QApplication>
@@ -71,7 +74,6 @@ void EmuThread::run()
             was_active = false;
         }
     }
-    render_window->moveContext();
 
     Core::Stop();
 }
@@ -159,7 +161,6 @@ GRenderWindow::GRenderWindow(QWidget* parent) : QWidget(parent), emu_thread(this
     layout->addWidget(child);
     layout->setMargin(0);
     setLayout(layout);
-    connect(&emu_thread, SIGNAL(started()), this, SLOT(moveContext()));
 
     OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
 
@@ -173,16 +174,6 @@ GRenderWindow::GRenderWindow(QWidget* parent) : QWidget(parent), emu_thread(this
 #endif
 }
 
-void GRenderWindow::moveContext()
-{
-    DoneCurrent();
-    // We need to move GL context to the swapping thread in Qt5
-#if QT_VERSION > QT_VERSION_CHECK(5, 0, 0)
-    // If the thread started running, move the GL Context to the new thread. Otherwise, move it back.
-    child->context()->moveToThread((QThread::currentThread() == qApp->thread()) ? &emu_thread : qApp->thread());
-#endif
-}
-
 GRenderWindow::~GRenderWindow()
 {
     if (emu_thread.isRunning())
@@ -210,6 +201,35 @@ void GRenderWindow::MakeCurrent()
 void GRenderWindow::DoneCurrent()
 {
     child->doneCurrent();
+#if QT_VERSION > QT_VERSION_CHECK(5, 0, 0)
+    // Hand the context back to the GUI thread once the render thread is done with it
+    if (QThread::currentThread() != qApp->thread())
+        child->context()->moveToThread(qApp->thread());
+#endif
+}
+
+std::thread GRenderWindow::StartRenderThread(std::function<void()> func)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5, 0, 0)
+    // In Qt5, only the thread owning the GL context may move it, so the new thread waits for the
+    // calling thread to hand it over. This happens once, without involving the event loop.
+    auto new_thread = std::make_shared<std::promise<QThread*>>();
+    std::future<QThread*> new_thread_started = new_thread->get_future();
+    std::promise<void> context_moved;
+    std::shared_future<void> context_ready = context_moved.get_future().share();
+
+    std::thread thread([func, new_thread, context_ready] {
+        new_thread->set_value(QThread::currentThread());
+        context_ready.wait();
+        func();
+    });
+
+    child->context()->moveToThread(new_thread_started.get());
+    context_moved.set_value();
+    return thread;
+#else
+    return std::thread(std::move(func));
+#endif
 }
 
 void GRenderWindow::PollEvents() {
@@ -109,6 +109,7 @@ public:
     void SwapBuffers() override;
     void MakeCurrent() override;
     void DoneCurrent() override;
+    std::thread StartRenderThread(std::function<void()> func) override;
     void PollEvents() override;
 
     void BackupGeometry();
@@ -127,9 +128,6 @@ public:
 
     void OnFramebufferSizeChanged();
 
-public slots:
-    void moveContext();  // overridden
-
 private:
     void OnMinimalClientAreaChangeRequest(const std::pair<unsigned,unsigned>& minimal_size) override;
 
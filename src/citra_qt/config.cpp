@@ -45,6 +45,14 @@ void Config::ReadValues() {
     qt_config->beginGroup("Core");
     Settings::values.gpu_refresh_rate = qt_config->value("gpu_refresh_rate", 30).toInt();
     Settings::values.frame_skip = qt_config->value("frame_skip", 0).toInt();
+    Settings::values.use_auto_frame_skip = qt_config->value("use_auto_frame_skip", false).toBool();
+    Settings::values.max_auto_frame_skip = qt_config->value("max_auto_frame_skip", 4).toInt();
+    Settings::values.skip_idle_loops = qt_config->value("skip_idle_loops", true).toBool();
+    Settings::values.speed_limit = qt_config->value("speed_limit", 100).toInt();
+    Settings::values.use_multi_core = qt_config->value("use_multi_core", false).toBool();
+    Settings::values.use_async_fs = qt_config->value("use_async_fs", false).toBool();
+    Settings::values.checkpoint_interval = qt_config->value("checkpoint_interval", 0).toInt();
+    Settings::values.max_checkpoints = qt_config->value("max_checkpoints", 30).toInt();
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
@@ -57,6 +65,8 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Miscellaneous");
     Settings::values.log_filter = qt_config->value("log_filter", "*:Info").toString().toStdString();
+    Settings::values.log_binary = qt_config->value("log_binary", false).toBool();
+    Settings::values.dump_gpu_data = qt_config->value("dump_gpu_data", false).toBool();
     qt_config->endGroup();
 }
 
@@ -84,6 +94,14 @@ void Config::SaveValues() {
     qt_config->beginGroup("Core");
     qt_config->setValue("gpu_refresh_rate", Settings::values.gpu_refresh_rate);
     qt_config->setValue("frame_skip", Settings::values.frame_skip);
+    qt_config->setValue("use_auto_frame_skip", Settings::values.use_auto_frame_skip);
+    qt_config->setValue("max_auto_frame_skip", Settings::values.max_auto_frame_skip);
+    qt_config->setValue("skip_idle_loops", Settings::values.skip_idle_loops);
+    qt_config->setValue("speed_limit", Settings::values.speed_limit);
+    qt_config->setValue("use_multi_core", Settings::values.use_multi_core);
+    qt_config->setValue("use_async_fs", Settings::values.use_async_fs);
+    qt_config->setValue("checkpoint_interval", Settings::values.checkpoint_interval);
+    qt_config->setValue("max_checkpoints", Settings::values.max_checkpoints);
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
@@ -96,6 +114,8 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Miscellaneous");
     qt_config->setValue("log_filter", QString::fromStdString(Settings::values.log_filter));
+    qt_config->setValue("log_binary", Settings::values.log_binary);
+    qt_config->setValue("dump_gpu_data", Settings::values.dump_gpu_data);
     qt_config->endGroup();
 }
 
@@ -10,11 +10,14 @@
 #include <QTreeView>
 #include <QSpinBox>
 #include <QComboBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
 
 #include "video_core/pica.h"
 #include "video_core/math.h"
 
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/debug_utils/pica_trace_file.h"
 
 #include "graphics_cmdlists.h"
 
@@ -309,11 +312,20 @@ GPUCommandListWidget::GPUCommandListWidget(QWidget* parent) : QDockWidget(tr("Pi
     connect(this, SIGNAL(TracingFinished(const Pica::DebugUtils::PicaTrace&)),
             model, SLOT(OnPicaTraceFinished(const Pica::DebugUtils::PicaTrace&)));
 
+    toggle_recording = new QPushButton(tr("Record to File..."));
+
+    connect(toggle_recording, SIGNAL(clicked()), this, SLOT(OnToggleRecording()));
+
     command_info_widget = new QWidget;
 
     QVBoxLayout* main_layout = new QVBoxLayout;
     main_layout->addWidget(list_widget);
-    main_layout->addWidget(toggle_tracing);
+    {
+        QHBoxLayout* sub_layout = new QHBoxLayout;
+        sub_layout->addWidget(toggle_tracing);
+        sub_layout->addWidget(toggle_recording);
+        main_layout->addLayout(sub_layout);
+    }
     main_layout->addWidget(command_info_widget);
     main_widget->setLayout(main_layout);
 
@@ -330,3 +342,17 @@ void GPUCommandListWidget::OnToggleTracing() {
         toggle_tracing->setText(tr("Start Tracing"));
     }
 }
+
+void GPUCommandListWidget::OnToggleRecording() {
+    if (!Pica::DebugUtils::IsPicaTraceRecording()) {
+        QString filename = QFileDialog::getSaveFileName(this, tr("Record PICA Trace"), QString(),
+                                                        tr("PICA trace (*.ptrace)"));
+        if (filename.isEmpty() || !Pica::DebugUtils::StartPicaTraceRecording(filename.toStdString()))
+            return;
+
+        toggle_recording->setText(tr("Stop Recording"));
+    } else {
+        Pica::DebugUtils::StopPicaTraceRecording();
+        toggle_recording->setText(tr("Record to File..."));
+    }
+}
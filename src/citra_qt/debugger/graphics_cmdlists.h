@@ -45,6 +45,7 @@ public:
 
 public slots:
     void OnToggleTracing();
+    void OnToggleRecording();
     void OnCommandDoubleClicked(const QModelIndex&);
 
     void SetCommandInfo(const QModelIndex&);
@@ -58,6 +59,7 @@ private:
     QTreeView* list_widget;
     QWidget* command_info_widget;
     QPushButton* toggle_tracing;
+    QPushButton* toggle_recording;
 };
 
 class TextureInfoDockWidget : public QDockWidget {
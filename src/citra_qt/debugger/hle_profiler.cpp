@@ -0,0 +1,123 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QStandardItemModel>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+#include "hle_profiler.h"
+
+#include "core/hle/profiler.h"
+
+HLEProfilerWidget::HLEProfilerWidget(QWidget* parent) : QDockWidget(tr("HLE Profiler"), parent)
+{
+    setObjectName("HLEProfiler");
+
+    profile_model = new QStandardItemModel(this);
+    profile_model->setColumnCount(6);
+    profile_model->setHeaderData(0, Qt::Horizontal, tr("Function"));
+    profile_model->setHeaderData(1, Qt::Horizontal, tr("Calls"));
+    profile_model->setHeaderData(2, Qt::Horizontal, tr("Total (ms)"));
+    profile_model->setHeaderData(3, Qt::Horizontal, tr("Average (us)"));
+    profile_model->setHeaderData(4, Qt::Horizontal, tr("Max (us)"));
+    profile_model->setHeaderData(5, Qt::Horizontal, tr("Emulated Ticks"));
+
+    QTreeView* tree_view = new QTreeView;
+    tree_view->setModel(profile_model);
+    tree_view->setSortingEnabled(true);
+    tree_view->setFont(QFont("monospace"));
+
+    QCheckBox* enable_checkbox = new QCheckBox(tr("Enable"));
+    enable_checkbox->setChecked(HLE::Profiler::IsEnabled());
+    connect(enable_checkbox, SIGNAL(toggled(bool)), this, SLOT(OnToggleEnabled(bool)));
+
+    QPushButton* refresh_button = new QPushButton(tr("Refresh"));
+    connect(refresh_button, SIGNAL(clicked()), this, SLOT(Refresh()));
+
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    connect(reset_button, SIGNAL(clicked()), this, SLOT(OnReset()));
+
+    QPushButton* dump_button = new QPushButton(tr("Dump to Log"));
+    connect(dump_button, SIGNAL(clicked()), this, SLOT(OnDumpToLog()));
+
+    QWidget* main_widget = new QWidget;
+    QVBoxLayout* main_layout = new QVBoxLayout;
+    {
+        QHBoxLayout* sub_layout = new QHBoxLayout;
+        sub_layout->addWidget(enable_checkbox);
+        sub_layout->addStretch();
+        sub_layout->addWidget(refresh_button);
+        sub_layout->addWidget(reset_button);
+        sub_layout->addWidget(dump_button);
+        main_layout->addLayout(sub_layout);
+    }
+    main_layout->addWidget(tree_view);
+    main_widget->setLayout(main_layout);
+
+    setWidget(main_widget);
+}
+
+/// Creates a row of items showing the given statistics
+static QList<QStandardItem*> CreateRow(const QString& name, const HLE::Profiler::CallStats& stats)
+{
+    QList<QStandardItem*> row;
+    row.append(new QStandardItem(name));
+
+    // Store numbers as data rather than text, so that the columns sort numerically
+    auto AddNumber = [&row](double value) {
+        QStandardItem* item = new QStandardItem;
+        item->setData(value, Qt::DisplayRole);
+        row.append(item);
+    };
+    AddNumber(static_cast<double>(stats.calls));
+    AddNumber(stats.total_host_ns / 1000000.0);
+    AddNumber(stats.total_host_ns / 1000.0 / stats.calls);
+    AddNumber(stats.max_host_ns / 1000.0);
+    AddNumber(static_cast<double>(stats.total_ticks));
+    return row;
+}
+
+void HLEProfilerWidget::OnDebugModeEntered()
+{
+    Refresh();
+}
+
+void HLEProfilerWidget::Refresh()
+{
+    profile_model->removeRows(0, profile_model->rowCount());
+
+    QStandardItem* svcs_root = new QStandardItem(tr("SVCs"));
+    for (const auto& svc : HLE::Profiler::GetSVCStats()) {
+        QString name = QString("0x%1 %2").arg(svc.svc_id, 2, 16, QLatin1Char('0')).arg(QString::fromStdString(svc.name));
+        svcs_root->appendRow(CreateRow(name, svc.stats));
+    }
+    profile_model->appendRow(svcs_root);
+
+    QStandardItem* services_root = new QStandardItem(tr("Service Commands"));
+    for (const auto& call : HLE::Profiler::GetServiceCallStats()) {
+        QString name = QString("%1 0x%2").arg(QString::fromStdString(call.port_name))
+                                         .arg(call.command_id, 4, 16, QLatin1Char('0'));
+        services_root->appendRow(CreateRow(name, call.stats));
+    }
+    profile_model->appendRow(services_root);
+}
+
+void HLEProfilerWidget::OnToggleEnabled(bool enabled)
+{
+    HLE::Profiler::SetEnabled(enabled);
+}
+
+void HLEProfilerWidget::OnReset()
+{
+    HLE::Profiler::Reset();
+    Refresh();
+}
+
+void HLEProfilerWidget::OnDumpToLog()
+{
+    HLE::Profiler::LogStats();
+}
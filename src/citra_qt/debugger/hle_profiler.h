@@ -0,0 +1,30 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+
+class QStandardItemModel;
+
+/// Shows how much time is spent in each SVC and service command
+class HLEProfilerWidget : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    HLEProfilerWidget(QWidget* parent = 0);
+
+public slots:
+    void OnDebugModeEntered();
+    void Refresh();
+
+private slots:
+    void OnToggleEnabled(bool enabled);
+    void OnReset();
+    void OnDumpToLog();
+
+private:
+    QStandardItemModel* profile_model;
+};
@@ -0,0 +1,66 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include <QHeaderView>
+#include <QPushButton>
+#include <QStandardItemModel>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+#include "idle_loops.h"
+
+#include "core/arm/dyncom/arm_dyncom_interpreter.h"
+
+IdleLoopsWidget::IdleLoopsWidget(QWidget* parent) : QDockWidget(tr("Idle Loops"), parent)
+{
+    setObjectName("IdleLoops");
+
+    idle_loops_model = new QStandardItemModel(this);
+    idle_loops_model->setColumnCount(3);
+    idle_loops_model->setHeaderData(0, Qt::Horizontal, tr("Address"));
+    idle_loops_model->setHeaderData(1, Qt::Horizontal, tr("Hits"));
+    idle_loops_model->setHeaderData(2, Qt::Horizontal, tr("Skipped Cycles"));
+
+    QTreeView* tree_view = new QTreeView;
+    tree_view->setModel(idle_loops_model);
+    tree_view->setRootIsDecorated(false);
+    tree_view->setFont(QFont("monospace"));
+
+    QPushButton* refresh_button = new QPushButton(tr("Refresh"));
+    connect(refresh_button, SIGNAL(clicked()), this, SLOT(Refresh()));
+
+    QWidget* main_widget = new QWidget;
+    QVBoxLayout* main_layout = new QVBoxLayout;
+    main_layout->addWidget(tree_view);
+    main_layout->addWidget(refresh_button);
+    main_widget->setLayout(main_layout);
+
+    setWidget(main_widget);
+}
+
+void IdleLoopsWidget::OnDebugModeEntered()
+{
+    Refresh();
+}
+
+void IdleLoopsWidget::Refresh()
+{
+    std::vector<IdleLoopStats> stats = GetIdleLoopStats();
+
+    // Show the loops which saved the most emulation time first
+    std::sort(stats.begin(), stats.end(), [](const IdleLoopStats& a, const IdleLoopStats& b) {
+        return a.skipped_cycles > b.skipped_cycles;
+    });
+
+    idle_loops_model->removeRows(0, idle_loops_model->rowCount());
+    for (const auto& loop : stats) {
+        QList<QStandardItem*> row;
+        row.append(new QStandardItem(QString("0x%1").arg(loop.address, 8, 16, QLatin1Char('0'))));
+        row.append(new QStandardItem(QString::number(loop.hits)));
+        row.append(new QStandardItem(QString::number(loop.skipped_cycles)));
+        idle_loops_model->appendRow(row);
+    }
+}
@@ -0,0 +1,25 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+
+class QStandardItemModel;
+
+/// Lists the guest idle loops the CPU core fast-forwarded over
+class IdleLoopsWidget : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    IdleLoopsWidget(QWidget* parent = 0);
+
+public slots:
+    void OnDebugModeEntered();
+    void Refresh();
+
+private:
+    QStandardItemModel* idle_loops_model;
+};
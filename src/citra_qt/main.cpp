@@ -7,11 +7,14 @@
 #include <QtGui>
 #include <QDesktopWidget>
 #include <QFileDialog>
+#include <QLabel>
+#include <QTimer>
 #include "qhexedit.h"
 #include "main.h"
 
 #include "common/common.h"
 #include "common/logging/text_formatter.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/log.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
@@ -29,6 +32,8 @@
 #include "debugger/disassembler.h"
 #include "debugger/registers.h"
 #include "debugger/callstack.h"
+#include "debugger/hle_profiler.h"
+#include "debugger/idle_loops.h"
 #include "debugger/ramview.h"
 #include "debugger/graphics.h"
 #include "debugger/graphics_breakpoints.h"
@@ -40,7 +45,9 @@
 #include "core/system.h"
 #include "core/core.h"
 #include "core/loader/loader.h"
+#include "core/savestate.h"
 #include "core/arm/disassembler/load_symbol_map.h"
+#include "video_core/video_core.h"
 #include "citra_qt/config.h"
 
 #include "version.h"
@@ -54,6 +61,11 @@ GMainWindow::GMainWindow()
     ui.setupUi(this);
     statusBar()->hide();
 
+    frame_stats_label = new QLabel;
+    statusBar()->addPermanentWidget(frame_stats_label);
+    frame_stats_timer = new QTimer(this);
+    connect(frame_stats_timer, SIGNAL(timeout()), this, SLOT(UpdateFrameStats()));
+
     render_window = new GRenderWindow;
     render_window->hide();
 
@@ -69,6 +81,14 @@ GMainWindow::GMainWindow()
     addDockWidget(Qt::RightDockWidgetArea, callstackWidget);
     callstackWidget->hide();
 
+    idleLoopsWidget = new IdleLoopsWidget(this);
+    addDockWidget(Qt::RightDockWidgetArea, idleLoopsWidget);
+    idleLoopsWidget->hide();
+
+    hleProfilerWidget = new HLEProfilerWidget(this);
+    addDockWidget(Qt::RightDockWidgetArea, hleProfilerWidget);
+    hleProfilerWidget->hide();
+
     graphicsWidget = new GPUCommandStreamWidget(this);
     addDockWidget(Qt::RightDockWidgetArea, graphicsWidget);
     graphicsWidget ->hide();
@@ -93,6 +113,8 @@ GMainWindow::GMainWindow()
     debug_menu->addAction(disasmWidget->toggleViewAction());
     debug_menu->addAction(registersWidget->toggleViewAction());
     debug_menu->addAction(callstackWidget->toggleViewAction());
+    debug_menu->addAction(idleLoopsWidget->toggleViewAction());
+    debug_menu->addAction(hleProfilerWidget->toggleViewAction());
     debug_menu->addAction(graphicsWidget->toggleViewAction());
     debug_menu->addAction(graphicsCommandsWidget->toggleViewAction());
     debug_menu->addAction(graphicsBreakpointsWidget->toggleViewAction());
@@ -136,6 +158,8 @@ GMainWindow::GMainWindow()
     connect(&render_window->GetEmuThread(), SIGNAL(DebugModeEntered()), disasmWidget, SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
     connect(&render_window->GetEmuThread(), SIGNAL(DebugModeEntered()), registersWidget, SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
     connect(&render_window->GetEmuThread(), SIGNAL(DebugModeEntered()), callstackWidget, SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
+    connect(&render_window->GetEmuThread(), SIGNAL(DebugModeEntered()), idleLoopsWidget, SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
+    connect(&render_window->GetEmuThread(), SIGNAL(DebugModeEntered()), hleProfilerWidget, SLOT(OnDebugModeEntered()), Qt::BlockingQueuedConnection);
     
     connect(&render_window->GetEmuThread(), SIGNAL(DebugModeLeft()), disasmWidget, SLOT(OnDebugModeLeft()), Qt::BlockingQueuedConnection);
     connect(&render_window->GetEmuThread(), SIGNAL(DebugModeLeft()), registersWidget, SLOT(OnDebugModeLeft()), Qt::BlockingQueuedConnection);
@@ -144,10 +168,16 @@ GMainWindow::GMainWindow()
     // Setup hotkeys
     RegisterHotkey("Main Window", "Load File", QKeySequence::Open);
     RegisterHotkey("Main Window", "Start Emulation");
+    RegisterHotkey("Main Window", "Save State", QKeySequence(Qt::Key_F5));
+    RegisterHotkey("Main Window", "Load State", QKeySequence(Qt::Key_F7));
+    RegisterHotkey("Main Window", "Rewind", QKeySequence(Qt::Key_F8));
     LoadHotkeys(settings);
 
     connect(GetHotkey("Main Window", "Load File", this), SIGNAL(activated()), this, SLOT(OnMenuLoadFile()));
     connect(GetHotkey("Main Window", "Start Emulation", this), SIGNAL(activated()), this, SLOT(OnStartGame()));
+    connect(GetHotkey("Main Window", "Save State", this), SIGNAL(activated()), this, SLOT(OnSaveState()));
+    connect(GetHotkey("Main Window", "Load State", this), SIGNAL(activated()), this, SLOT(OnLoadState()));
+    connect(GetHotkey("Main Window", "Rewind", this), SIGNAL(activated()), this, SLOT(OnRewind()));
 
     std::string window_title = Common::StringFromFormat("Citra | %s-%s", Common::g_scm_branch, Common::g_scm_desc);
     setWindowTitle(window_title.c_str());
@@ -209,6 +239,9 @@ void GMainWindow::BootGame(std::string filename)
 
     render_window->show();
     OnStartGame();
+
+    statusBar()->show();
+    frame_stats_timer->start(1000);
 }
 
 void GMainWindow::OnMenuLoadFile()
@@ -252,6 +285,31 @@ void GMainWindow::OnStopGame()
     ui.action_Stop->setEnabled(false);
 }
 
+void GMainWindow::UpdateFrameStats()
+{
+    if (VideoCore::g_renderer == nullptr)
+        return;
+
+    std::string summary = VideoCore::g_renderer->GetFrameStats().GetResults().GetSummary();
+    frame_stats_label->setText(QString::fromStdString(summary));
+}
+
+void GMainWindow::OnSaveState()
+{
+    // Handled by the emulation thread, between two iterations of its loop
+    SaveState::RequestSave(SaveState::GetDefaultPath());
+}
+
+void GMainWindow::OnLoadState()
+{
+    SaveState::RequestLoad(SaveState::GetDefaultPath());
+}
+
+void GMainWindow::OnRewind()
+{
+    SaveState::RequestRewind();
+}
+
 void GMainWindow::OnOpenHotkeysDialog()
 {
     GHotkeysDialog dialog(this);
@@ -310,19 +368,30 @@ int __cdecl main(int argc, char* argv[])
 {
     std::shared_ptr<Log::Logger> logger = Log::InitGlobalLogger();
     Log::Filter log_filter(Log::Level::Info);
-    std::thread logging_thread(Log::TextLoggingLoop, logger, &log_filter);
-    SCOPE_EXIT({
-        logger->Close();
-        logging_thread.join();
-    });
+    Log::SetGlobalFilter(&log_filter);
 
     QApplication::setAttribute(Qt::AA_X11InitThreads);
     QApplication app(argc, argv);
 
     GMainWindow main_window;
-    // After settings have been loaded by GMainWindow, apply the filter
+    // After settings have been loaded by GMainWindow, apply the filter and start the log output.
+    // Messages logged until then wait in the log buffer.
     log_filter.ParseFilterString(Settings::values.log_filter);
 
+    std::thread logging_thread;
+    std::shared_ptr<Log::BinaryLogWriter> binary_log;
+    if (Settings::values.log_binary)
+        binary_log = Log::OpenDefaultBinaryLog();
+    if (binary_log != nullptr)
+        logging_thread = std::thread(Log::BinaryLoggingLoop, logger, &log_filter, binary_log);
+    else
+        logging_thread = std::thread(Log::TextLoggingLoop, logger, &log_filter);
+    SCOPE_EXIT({
+        Log::SetGlobalFilter(nullptr);
+        logger->Close();
+        logging_thread.join();
+    });
+
     main_window.show();
     return app.exec();
 }
@@ -9,11 +9,15 @@
 
 #include "ui_main.h"
 
+class QLabel;
+class QTimer;
 class GImageInfo;
 class GRenderWindow;
 class DisassemblerWidget;
 class RegistersWidget;
 class CallstackWidget;
+class IdleLoopsWidget;
+class HLEProfilerWidget;
 class GPUCommandStreamWidget;
 class GPUCommandListWidget;
 
@@ -42,21 +46,30 @@ private slots:
     void OnStartGame();
     void OnPauseGame();
     void OnStopGame();
+    void OnSaveState();
+    void OnLoadState();
+    void OnRewind();
     void OnMenuLoadFile();
     void OnMenuLoadSymbolMap();
     void OnOpenHotkeysDialog();
     void OnConfigure();
     void OnDisplayTitleBars(bool);
     void ToggleWindowMode();
+    void UpdateFrameStats();
 
 private:
     Ui::MainWindow ui;
 
     GRenderWindow* render_window;
 
+    QLabel* frame_stats_label;
+    QTimer* frame_stats_timer;
+
     DisassemblerWidget* disasmWidget;
     RegistersWidget* registersWidget;
     CallstackWidget* callstackWidget;
+    IdleLoopsWidget* idleLoopsWidget;
+    HLEProfilerWidget* hleProfilerWidget;
     GPUCommandStreamWidget* graphicsWidget;
     GPUCommandListWidget* graphicsCommandsWidget;
 };
@@ -35,6 +35,14 @@ template<> struct CompileTimeAssert<true> {};
 #define CONCAT2(x, y) DO_CONCAT2(x, y)
 #define DO_CONCAT2(x, y) x ## y
 
+/// Declares a thread-local variable of trivial type, since not all supported compilers implement
+/// the thread_local keyword yet.
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 // helper macro to properly align structure members.
 // Calling INSERT_PADDING_BYTES will add a new member variable with a name like "pad121",
 // depending on the current source line to make sure variable names are unique.
@@ -64,6 +64,7 @@
 
 // Files in the directory returned by GetUserPath(D_LOGS_IDX)
 #define MAIN_LOG "emu.log"
+#define BINARY_LOG "citra_log.bin"
 
 // Files in the directory returned by GetUserPath(D_SYSCONF_IDX)
 #define SYSCONF "SYSCONF"
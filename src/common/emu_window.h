@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <functional>
+#include <thread>
+
 #include "common/common.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
@@ -50,6 +53,18 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Starts the thread which renders to the window from then on. Frontends whose graphics context
+     * is bound to a specific thread hand it over before `func` runs, so `func` can make it current
+     * right away. Must be called on the thread which currently owns the context, without it being
+     * current.
+     * @param func Function to run on the new thread
+     * @return The new thread
+     */
+    virtual std::thread StartRenderThread(std::function<void()> func) {
+        return std::thread(std::move(func));
+    }
+
     virtual void ReloadSetKeymaps() = 0;
 
     /// Signals a key press action to the HID module
@@ -15,8 +15,10 @@
 #include <direct.h>        // getcwd
 #include <tchar.h>
 #else
+#include <sys/mman.h>
 #include <sys/param.h>
 #include <dirent.h>
+#include <unistd.h>
 #endif
 
 #if defined(__APPLE__)
@@ -26,6 +28,7 @@
 #endif
 
 #include <algorithm>
+#include <cerrno>
 #include <sys/stat.h>
 
 #ifndef S_ISDIR
@@ -937,4 +940,146 @@ bool IOFile::Resize(u64 size)
     return m_good;
 }
 
+size_t IOFile::ReadAt(void* data, size_t length, u64 offset)
+{
+    if (!IsOpen())
+        return 0;
+
+    u8* dest = static_cast<u8*>(data);
+    size_t total_read = 0;
+    while (total_read < length) {
+        const u64 position = offset + total_read;
+#ifdef _WIN32
+        HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        const DWORD chunk_size = static_cast<DWORD>(std::min<size_t>(length - total_read, 0x40000000));
+        DWORD bytes_read = 0;
+        if (!ReadFile(file_handle, dest + total_read, chunk_size, &bytes_read, &overlapped) || bytes_read == 0)
+            break;
+#else
+        const ssize_t bytes_read = pread(fileno(m_file), dest + total_read, length - total_read,
+                                         static_cast<off_t>(position));
+        if (bytes_read < 0 && errno == EINTR)
+            continue;
+        if (bytes_read <= 0)
+            break;
+#endif
+        total_read += bytes_read;
+    }
+    return total_read;
+}
+
+size_t IOFile::WriteAt(const void* data, size_t length, u64 offset)
+{
+    if (!IsOpen()) {
+        m_good = false;
+        return 0;
+    }
+
+    const u8* src = static_cast<const u8*>(data);
+    size_t total_written = 0;
+    while (total_written < length) {
+        const u64 position = offset + total_written;
+#ifdef _WIN32
+        HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        const DWORD chunk_size = static_cast<DWORD>(std::min<size_t>(length - total_written, 0x40000000));
+        DWORD bytes_written = 0;
+        if (!WriteFile(file_handle, src + total_written, chunk_size, &bytes_written, &overlapped) || bytes_written == 0)
+            break;
+#else
+        const ssize_t bytes_written = pwrite(fileno(m_file), src + total_written, length - total_written,
+                                             static_cast<off_t>(position));
+        if (bytes_written < 0 && errno == EINTR)
+            continue;
+        if (bytes_written <= 0)
+            break;
+#endif
+        total_written += bytes_written;
+    }
+
+    if (total_written != length)
+        m_good = false;
+
+    return total_written;
+}
+
+MappedFileView::~MappedFileView()
+{
+    Unmap();
+}
+
+bool MappedFileView::Map(IOFile& file, u64 offset, u64 size, bool writable)
+{
+    Unmap();
+
+    if (!file.IsOpen() || size == 0 || offset + size > file.GetSize())
+        return false;
+
+    // Mappings have to start at a multiple of the allocation granularity
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    const u64 granularity = system_info.dwAllocationGranularity;
+#else
+    const u64 granularity = sysconf(_SC_PAGESIZE);
+#endif
+    const u64 mapping_offset = offset - offset % granularity;
+    const u64 mapping_size = size + (offset - mapping_offset);
+    if (mapping_size != static_cast<size_t>(mapping_size))
+        return false; // Doesn't fit into the address space
+
+#ifdef _WIN32
+    HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.GetHandle())));
+    HANDLE mapping_handle = CreateFileMapping(file_handle, nullptr,
+                                              writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr)
+        return false;
+
+    // The view keeps the mapping object alive
+    void* mapping = MapViewOfFile(mapping_handle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, static_cast<DWORD>(mapping_offset >> 32),
+                                  static_cast<DWORD>(mapping_offset), static_cast<SIZE_T>(mapping_size));
+    CloseHandle(mapping_handle);
+    if (mapping == nullptr)
+        return false;
+#else
+    void* mapping = mmap(nullptr, static_cast<size_t>(mapping_size),
+                         writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                         fileno(file.GetHandle()), static_cast<off_t>(mapping_offset));
+    if (mapping == MAP_FAILED)
+        return false;
+#endif
+
+    m_mapping = mapping;
+    m_mapping_size = static_cast<size_t>(mapping_size);
+    m_data = static_cast<u8*>(mapping) + (offset - mapping_offset);
+    m_size = size;
+    m_writable = writable;
+    return true;
+}
+
+void MappedFileView::Unmap()
+{
+    if (m_mapping == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapping);
+#else
+    munmap(m_mapping, m_mapping_size);
+#endif
+
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+
 } // namespace
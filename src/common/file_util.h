@@ -204,6 +204,20 @@ public:
         return WriteArray(reinterpret_cast<const char*>(data), length);
     }
 
+    /**
+     * Reads from the given file offset straight into the destination buffer, bypassing the stdio
+     * buffer. Doesn't touch the error state, so it may be called from several threads at once.
+     * Must not be mixed with buffered writes which haven't been flushed yet.
+     * @return Number of bytes read, which is less than length at the end of the file
+     */
+    size_t ReadAt(void* data, size_t length, u64 offset);
+
+    /**
+     * Writes to the given file offset, bypassing the stdio buffer.
+     * @return Number of bytes written
+     */
+    size_t WriteAt(const void* data, size_t length, u64 offset);
+
     bool IsOpen() { return nullptr != m_file; }
 
     // m_good is set to false when a read, write or other function fails
@@ -232,6 +246,44 @@ private:
     IOFile& operator=(IOFile& other);
 };
 
+/**
+ * Memory mapping of a range of a file, read-only unless requested otherwise. The OS only reads in
+ * pages of the file as they are accessed, and may drop them again under memory pressure, so even
+ * large files can be mapped without delay. The mapping stays valid after the file is closed.
+ * Writes to a writable mapping end up in the file even if the process terminates abnormally.
+ */
+class MappedFileView : public NonCopyable
+{
+public:
+    MappedFileView() {}
+    ~MappedFileView();
+
+    /**
+     * Maps a range of an open file, replacing any previous mapping
+     * @param file File to map
+     * @param offset Offset of the range in the file
+     * @param size Size of the range in bytes
+     * @param writable Whether the mapping may be written to, the file must be opened for writing
+     * @return True on success
+     */
+    bool Map(IOFile& file, u64 offset, u64 size, bool writable = false);
+
+    void Unmap();
+
+    bool IsMapped() const { return m_data != nullptr; }
+    const u8* GetData() const { return m_data; }
+    /// Returns the mapped data if the mapping is writable, nullptr otherwise
+    u8* GetWritableData() const { return m_writable ? m_data : nullptr; }
+    u64 GetSize() const { return m_size; }
+
+private:
+    void* m_mapping = nullptr;  ///< Start of the mapping, aligned to the mapping granularity
+    size_t m_mapping_size = 0;
+    u8* m_data = nullptr;       ///< Start of the requested range within the mapping
+    u64 m_size = 0;
+    bool m_writable = false;
+};
+
 }  // namespace
 
 // To deal with Windows being dumb at unicode:
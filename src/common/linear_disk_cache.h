@@ -5,15 +5,15 @@
 #pragma once
 
 #include "common/common.h"
+#include "common/file_util.h"
+#include "common/scm_rev.h"
+#include <cstring>
 #include <fstream>
 
-// defined in Version.cpp
-extern const char *scm_rev_git_str;
-
 // On disk format:
 //header{
 // u32 'DCAC';
-// u32 version;  // svn_rev
+// char version[40];  // git revision
 // u16 sizeof(key_type);
 // u16 sizeof(value_type);
 //}
@@ -173,7 +173,9 @@ private:
             , key_t_size(sizeof(K))
             , value_t_size(sizeof(V))
         {
-            memcpy(ver, scm_rev_git_str, 40);
+            // The revision string might be shorter than a full hash in builds outside of git
+            memset(ver, 0, sizeof(ver));
+            strncpy(ver, Common::g_scm_rev, sizeof(ver));
         }
 
         const u32 id;
@@ -0,0 +1,260 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "common/common.h" // for NonCopyable
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Whether a LockFreeRingBuffer may be pushed to from several threads at once.
+enum class RingBufferProducers {
+    Single,
+    Multiple,
+};
+
+/// What pushing to a full LockFreeRingBuffer does.
+enum class RingBufferFullPolicy {
+    Block, ///< Wait for the consumer to make room
+    Drop,  ///< Discard the new item and count it as dropped, never blocks the producer
+};
+
+/**
+ * A lock-free, bounded SPSC/MPSC (Single/Multiple-Producer Single-Consumer) ring buffer. Unlike
+ * ConcurrentRingBuffer, producers never take a lock: They claim a slot with a single atomic
+ * operation and publish it by bumping the slot's sequence number. Only one thread may pop at a
+ * time. Consumers popping from an empty buffer sleep until a producer wakes them up, or poll with
+ * the non-blocking Pop.
+ *
+ * @tparam T Type of the items, which is moved in and out of the buffer
+ * @tparam Capacity Maximum number of items in the buffer, must be a power of two
+ */
+template <typename T, size_t Capacity,
+          RingBufferProducers Producers = RingBufferProducers::Multiple,
+          RingBufferFullPolicy FullPolicy = RingBufferFullPolicy::Block>
+class LockFreeRingBuffer : private NonCopyable {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    /// Value returned by the popping functions when the queue has been closed.
+    static const size_t QUEUE_CLOSED = -1;
+
+    LockFreeRingBuffer() : closed(false), consumer_sleeping(false), dropped(0) {
+        write_index.value.store(0, std::memory_order_relaxed);
+        read_index.value = 0;
+        for (size_t i = 0; i < Capacity; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~LockFreeRingBuffer() {
+        // If for whatever reason the queue wasn't completely drained, destroy the left over items.
+        size_t index = read_index.value;
+        while (slots[index & INDEX_MASK].sequence.load(std::memory_order_acquire) == index + 1) {
+            slots[index & INDEX_MASK].Item()->~T();
+            ++index;
+        }
+    }
+
+    /**
+     * Pushes a value to the queue. If the queue is full, this method either blocks or drops the
+     * value, depending on the FullPolicy. Does nothing if the queue is closed.
+     * @return True if the value was added to the queue
+     */
+    bool Push(T val) {
+        while (!closed.load(std::memory_order_relaxed)) {
+            if (TryPush(val))
+                return true;
+
+            if (FullPolicy == RingBufferFullPolicy::Drop) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    /**
+     * Pushes a value to the queue if there is room for it, without blocking and without counting
+     * it as dropped otherwise.
+     * @return True if the value was added to the queue, `val` is left untouched if not
+     */
+    bool TryPush(T& val) {
+        size_t index = write_index.value.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[index & INDEX_MASK];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(sequence - index);
+
+            if (diff < 0) {
+                // The consumer hasn't freed this slot yet since the last round: The queue is full
+                return false;
+            } else if (diff > 0) {
+                // Another producer claimed the slot in the meantime
+                index = write_index.value.load(std::memory_order_relaxed);
+            } else if (Producers == RingBufferProducers::Single) {
+                write_index.value.store(index + 1, std::memory_order_relaxed);
+                break;
+            } else if (write_index.value.compare_exchange_weak(index, index + 1,
+                                                               std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        new (slot->Item()) T(std::move(val));
+        slot->sequence.store(index + 1, std::memory_order_release);
+
+        // Only pay for waking up the consumer if it's actually asleep. This pairs with the fence in
+        // WaitForItems, so that either the consumer sees the new item or we see it sleeping.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(wakeup_mutex);
+            wakeup.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * Pops up to `dest_len` items from the queue, storing them in `dest`. This function will not
+     * block, and might return 0 values if there are no elements in the queue when it is called.
+     * Only one thread may pop from the queue at a time.
+     *
+     * @return The number of elements stored in `dest`. If the queue has been closed, returns
+     *          `QUEUE_CLOSED`.
+     */
+    size_t Pop(T* dest, size_t dest_len) {
+        if (closed.load(std::memory_order_acquire) && !CanRead())
+            return QUEUE_CLOSED;
+        return PopInternal(dest, dest_len);
+    }
+
+    /**
+     * Pops up to `dest_len` items from the queue, storing them in `dest`. This function will block
+     * if there are no elements in the queue when it is called. Only one thread may pop from the
+     * queue at a time.
+     *
+     * @return The number of elements stored in `dest`. If the queue has been closed, returns
+     *         `QUEUE_CLOSED`.
+     */
+    size_t BlockingPop(T* dest, size_t dest_len) {
+        while (true) {
+            size_t popped = Pop(dest, dest_len);
+            if (popped != 0)
+                return popped;
+            WaitForItems();
+        }
+    }
+
+    /**
+     * Closes the queue. After calling this method, `Push` operations won't have any effect, and
+     * `Pop` and `BlockingPop` will start returning `QUEUE_CLOSED` once the queue is drained. This
+     * is intended to allow a graceful shutdown of the consumer.
+     */
+    void Close() {
+        closed.store(true, std::memory_order_release);
+        // We need to wake up the reader if it is waiting for an item that will never come.
+        std::lock_guard<std::mutex> lock(wakeup_mutex);
+        wakeup.notify_all();
+    }
+
+    /// Returns true if `Close()` has been called.
+    bool IsClosed() const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+    /// Returns the number of items which were dropped because the queue was full.
+    u64 GetDroppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const size_t INDEX_MASK = Capacity - 1;
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot {
+        /**
+         * Equals the write index which may fill the slot next when it is free, and that index + 1
+         * while it holds an item which is ready to be read.
+         */
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+        T* Item() {
+            return static_cast<T*>(static_cast<void*>(&storage));
+        }
+    };
+
+    /// Pads a value to its own cache line, so that producer and consumer don't contend on it.
+    template <typename V>
+    struct CacheLinePadded {
+        char padding_before[CACHE_LINE_SIZE];
+        V value;
+        char padding_after[CACHE_LINE_SIZE];
+    };
+
+    size_t PopInternal(T* dest, size_t dest_len) {
+        // Only the consumer modifies the read index, so it's only published once for the batch
+        size_t index = read_index.value;
+        size_t output_count = 0;
+        while (output_count < dest_len) {
+            Slot& slot = slots[index & INDEX_MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+                break;
+
+            T* item = slot.Item();
+            dest[output_count++] = std::move(*item);
+            item->~T();
+
+            // Hand the slot back to the producers for the next round
+            slot.sequence.store(index + Capacity, std::memory_order_release);
+            ++index;
+        }
+        read_index.value = index;
+        return output_count;
+    }
+
+    bool CanRead() const {
+        size_t index = read_index.value;
+        return slots[index & INDEX_MASK].sequence.load(std::memory_order_acquire) == index + 1;
+    }
+
+    /// Puts the consumer to sleep until an item may be available or the queue was closed.
+    void WaitForItems() {
+        std::unique_lock<std::mutex> lock(wakeup_mutex);
+        consumer_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!CanRead() && !closed.load(std::memory_order_acquire)) {
+            // The timeout is only a safety net, producers wake us up as soon as they push
+            wakeup.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        consumer_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    CacheLinePadded<std::atomic<size_t>> write_index;
+    CacheLinePadded<size_t> read_index;
+
+    Slot slots[Capacity];
+
+    std::atomic<bool> closed;
+    std::atomic<bool> consumer_sleeping;
+    std::atomic<u64> dropped;
+
+    /// Only used to put the consumer to sleep when the queue is empty
+    std::mutex wakeup_mutex;
+    std::condition_variable wakeup;
+};
+
+} // namespace
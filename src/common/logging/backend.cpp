@@ -3,16 +3,22 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 #include "common/assert.h"
 
 #include "common/logging/backend.h"
+#include "common/logging/filter.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 
 namespace Log {
 
 static std::shared_ptr<Logger> global_logger;
+static const Filter* global_filter = nullptr;
 
 /// Macro listing all log classes. Code should define CLS and SUB as desired before invoking this.
 #define ALL_LOG_CLASSES() \
@@ -51,7 +57,7 @@ static std::shared_ptr<Logger> global_logger;
         SUB(Render, OpenGL) \
         CLS(Loader)
 
-Logger::Logger() {
+Logger::Logger() : consumer_started(false) {
     // Register logging classes so that they can be queried at runtime
     size_t parent_class;
     all_classes.reserve((size_t)Class::Count);
@@ -97,11 +103,21 @@ const char* Logger::GetLevelName(Level log_level) {
 #undef LVL
 }
 
-void Logger::LogMessage(Entry entry) {
-    ring_buffer.Push(std::move(entry));
+void Logger::LogMessage(const Entry& entry) {
+    if (consumer_started.load(std::memory_order_acquire)) {
+        ring_buffer.Push(entry);
+        return;
+    }
+
+    // Messages logged during startup (e.g. while loading the config) wait in the buffer until the
+    // outputter starts. Don't drop them if there are more than fit.
+    Entry copy = entry;
+    if (!ring_buffer.TryPush(copy))
+        PrintMessage(entry);
 }
 
 size_t Logger::GetEntries(Entry* out_buffer, size_t buffer_len) {
+    consumer_started.store(true, std::memory_order_release);
     return ring_buffer.BlockingPop(out_buffer, buffer_len);
 }
 
@@ -110,6 +126,248 @@ std::shared_ptr<Logger> InitGlobalLogger() {
     return global_logger;
 }
 
+namespace {
+
+/// Type of the argument consumed by a conversion specification, as passed through varargs.
+enum class ArgType {
+    None,       ///< `%%`, or a malformed specification
+    Int,        ///< Also used for char and short, which are promoted to int
+    Long,
+    LongLong,
+    SizeT,
+    IntMax,
+    PtrDiff,
+    Double,     ///< Also used for float, which is promoted to double
+    LongDouble,
+    Pointer,    ///< `%p`, and the arguments of `%n` and `%ls`, which are never dereferenced
+    String,
+};
+
+/// A parsed printf conversion specification.
+struct FormatSpec {
+    const char* end; ///< Points past the conversion character
+    ArgType type;
+    /// Number of `*` widths or precisions, each of which consumes an int argument before the value
+    int num_stars;
+    char conversion;
+};
+
+/**
+ * Parses a printf conversion specification.
+ * @param spec Points to the '%' starting the specification
+ */
+FormatSpec ParseFormatSpec(const char* spec) {
+    FormatSpec result;
+    result.num_stars = 0;
+
+    const char* p = spec + 1;
+    while (*p != '\0' && std::strchr("-+ #0", *p) != nullptr)
+        ++p;
+    // Width and precision
+    for (int i = 0; i < 2; ++i) {
+        if (i == 1) {
+            if (*p != '.')
+                break;
+            ++p;
+        }
+        if (*p == '*') {
+            ++result.num_stars;
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9')
+            ++p;
+    }
+
+    char length = '\0';
+    if ((p[0] == 'h' && p[1] == 'h') || (p[0] == 'l' && p[1] == 'l')) {
+        length = (p[0] == 'l') ? 'q' : 'h';
+        p += 2;
+    } else if (*p != '\0' && std::strchr("hlqzjtL", *p) != nullptr) {
+        length = *p++;
+    }
+
+    result.conversion = *p;
+    switch (*p) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        switch (length) {
+        case 'l': result.type = ArgType::Long; break;
+        case 'q': result.type = ArgType::LongLong; break;
+        case 'z': result.type = ArgType::SizeT; break;
+        case 'j': result.type = ArgType::IntMax; break;
+        case 't': result.type = ArgType::PtrDiff; break;
+        default:  result.type = ArgType::Int; break;
+        }
+        break;
+    case 'c':
+        result.type = ArgType::Int;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        result.type = (length == 'L') ? ArgType::LongDouble : ArgType::Double;
+        break;
+    case 's':
+        result.type = (length == 'l') ? ArgType::Pointer : ArgType::String;
+        break;
+    case 'p': case 'n':
+        result.type = ArgType::Pointer;
+        break;
+    default:
+        // `%%`, or an unknown conversion which can't be formatted safely
+        result.type = ArgType::None;
+        result.num_stars = 0;
+        break;
+    }
+
+    result.end = (*p != '\0') ? p + 1 : p;
+    return result;
+}
+
+/// Appends arguments to the packed argument buffer of an entry, until it runs out of space.
+class ArgumentPacker {
+public:
+    explicit ArgumentPacker(Entry& entry) : entry(entry) {
+        entry.args_size = 0;
+        entry.args_truncated = false;
+    }
+
+    template <typename T>
+    bool Pack(T value) {
+        return PackBytes(&value, sizeof(T));
+    }
+
+    bool PackString(const char* str) {
+        if (str == nullptr)
+            str = "(null)";
+
+        // Strings are stored null terminated, cut off to whatever space is left. A cut off string is
+        // the last argument packed, since the message is cut off there.
+        size_t length = std::strlen(str);
+        size_t space_left = Entry::MAX_ARGS_SIZE - entry.args_size;
+        if (space_left == 0) {
+            entry.args_truncated = true;
+            return false;
+        }
+        bool cut_off = length >= space_left;
+        if (cut_off)
+            length = space_left - 1;
+
+        std::memcpy(&entry.args[entry.args_size], str, length);
+        entry.args[entry.args_size + length] = '\0';
+        entry.args_size += static_cast<u16>(length + 1);
+
+        if (cut_off) {
+            entry.args_truncated = true;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool PackBytes(const void* data, size_t size) {
+        if (entry.args_size + size > Entry::MAX_ARGS_SIZE) {
+            entry.args_truncated = true;
+            return false;
+        }
+        std::memcpy(&entry.args[entry.args_size], data, size);
+        entry.args_size += static_cast<u16>(size);
+        return true;
+    }
+
+    Entry& entry;
+};
+
+/// Reads back the arguments packed by ArgumentPacker, in the same order.
+class ArgumentReader {
+public:
+    explicit ArgumentReader(const Entry& entry) : entry(entry) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (offset + sizeof(T) > entry.args_size)
+            return false;
+        std::memcpy(&value, &entry.args[offset], sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool ReadString(const char*& str) {
+        if (offset >= entry.args_size)
+            return false;
+        str = reinterpret_cast<const char*>(&entry.args[offset]);
+        offset += std::strlen(str) + 1;
+        return true;
+    }
+
+    /// Returns whether all packed arguments have been read
+    bool AtEnd() const {
+        return offset >= entry.args_size;
+    }
+
+private:
+    const Entry& entry;
+    size_t offset = 0;
+};
+
+/// Packs the value of a conversion specification, consuming it from `args`.
+bool PackArgument(ArgumentPacker& packer, ArgType type, va_list& args) {
+    switch (type) {
+    case ArgType::None:       return true;
+    case ArgType::Int:        return packer.Pack(va_arg(args, int));
+    case ArgType::Long:       return packer.Pack(va_arg(args, long));
+    case ArgType::LongLong:   return packer.Pack(va_arg(args, long long));
+    case ArgType::SizeT:      return packer.Pack(va_arg(args, size_t));
+    case ArgType::IntMax:     return packer.Pack(va_arg(args, intmax_t));
+    case ArgType::PtrDiff:    return packer.Pack(va_arg(args, ptrdiff_t));
+    case ArgType::Double:     return packer.Pack(va_arg(args, double));
+    case ArgType::LongDouble: return packer.Pack(va_arg(args, long double));
+    case ArgType::Pointer:    return packer.Pack(va_arg(args, void*));
+    case ArgType::String:     return packer.PackString(va_arg(args, const char*));
+    }
+    return false;
+}
+
+/// Formats a single value with the given conversion specification, passing along `*` arguments.
+template <typename T>
+int FormatValue(char* out, size_t out_len, const char* spec, const int* stars, int num_stars,
+                T value) {
+    switch (num_stars) {
+    case 0:  return snprintf(out, out_len, spec, value);
+    case 1:  return snprintf(out, out_len, spec, stars[0], value);
+    default: return snprintf(out, out_len, spec, stars[0], stars[1], value);
+    }
+}
+
+/// Unpacks and formats the value of a conversion specification.
+bool FormatArgument(ArgumentReader& reader, ArgType type, char* out, size_t out_len,
+                    const char* spec, const int* stars, int num_stars, int& written) {
+#define FORMAT_AS(T) \
+    { T value; if (!reader.Read(value)) return false; \
+      written = FormatValue(out, out_len, spec, stars, num_stars, value); return true; }
+
+    switch (type) {
+    case ArgType::None:       written = snprintf(out, out_len, "%s", spec); return true;
+    case ArgType::Int:        FORMAT_AS(int)
+    case ArgType::Long:       FORMAT_AS(long)
+    case ArgType::LongLong:   FORMAT_AS(long long)
+    case ArgType::SizeT:      FORMAT_AS(size_t)
+    case ArgType::IntMax:     FORMAT_AS(intmax_t)
+    case ArgType::PtrDiff:    FORMAT_AS(ptrdiff_t)
+    case ArgType::Double:     FORMAT_AS(double)
+    case ArgType::LongDouble: FORMAT_AS(long double)
+    case ArgType::Pointer:    FORMAT_AS(void*)
+    case ArgType::String: {
+        const char* value;
+        if (!reader.ReadString(value))
+            return false;
+        written = FormatValue(out, out_len, spec, stars, num_stars, value);
+        return true;
+    }
+    }
+    return false;
+#undef FORMAT_AS
+}
+
+} // anonymous namespace
+
 Entry CreateEntry(Class log_class, Level log_level,
                         const char* filename, unsigned int line_nr, const char* function,
                         const char* format, va_list args) {
@@ -118,25 +376,117 @@ Entry CreateEntry(Class log_class, Level log_level,
 
     static steady_clock::time_point time_origin = steady_clock::now();
 
-    std::array<char, 4 * 1024> formatting_buffer;
-
     Entry entry;
     entry.timestamp = duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
     entry.log_class = log_class;
     entry.log_level = log_level;
+    entry.filename = filename;
+    entry.line_nr = line_nr;
+    entry.function = function;
+    entry.format = format;
+
+    // Walk the format string only to find out which arguments to copy, formatting happens later
+    ArgumentPacker packer(entry);
+    va_list args_copy;
+    va_copy(args_copy, args);
+    for (const char* p = std::strchr(format, '%'); p != nullptr; p = std::strchr(p, '%')) {
+        FormatSpec spec = ParseFormatSpec(p);
+        bool packed = true;
+        for (int i = 0; i < spec.num_stars && packed; ++i)
+            packed = packer.Pack(va_arg(args_copy, int));
+        if (!packed || !PackArgument(packer, spec.type, args_copy))
+            break;
+        p = spec.end;
+    }
+    va_end(args_copy);
+
+    return entry;
+}
+
+size_t FormatEntryMessage(const Entry& entry, char* out_text, size_t text_len) {
+    if (text_len == 0)
+        return 0;
+
+    size_t length = 0;
+    auto append = [&](const char* text, size_t text_length) {
+        text_length = std::min(text_length, text_len - 1 - length);
+        std::memcpy(out_text + length, text, text_length);
+        length += text_length;
+    };
+
+    ArgumentReader reader(entry);
+    const char* p = entry.format;
+    while (*p != '\0' && length < text_len - 1) {
+        const char* spec_start = std::strchr(p, '%');
+        if (spec_start == nullptr) {
+            append(p, std::strlen(p));
+            break;
+        }
+        append(p, spec_start - p);
+
+        FormatSpec spec = ParseFormatSpec(spec_start);
+        p = spec.end;
+        if (spec.conversion == '%') {
+            append("%", 1);
+            continue;
+        }
+
+        std::array<char, 32> spec_text;
+        size_t spec_length = std::min<size_t>(spec.end - spec_start, spec_text.size() - 1);
+        std::memcpy(spec_text.data(), spec_start, spec_length);
+        spec_text[spec_length] = '\0';
 
-    snprintf(formatting_buffer.data(), formatting_buffer.size(), "%s:%s:%u", filename, function, line_nr);
-    entry.location = std::string(formatting_buffer.data());
+        int stars[2];
+        bool available = true;
+        for (int i = 0; i < spec.num_stars && available; ++i)
+            available = reader.Read(stars[i]);
 
-    vsnprintf(formatting_buffer.data(), formatting_buffer.size(), format, args);
-    entry.message = std::string(formatting_buffer.data());
+        int written = 0;
+        if (spec.conversion == 'n') {
+            // Never write through a pointer which has been logged, just skip the argument
+            void* ignored;
+            available = available && reader.Read(ignored);
+        } else if (spec.type == ArgType::Pointer && spec.conversion == 's') {
+            void* ignored;
+            available = available && reader.Read(ignored);
+            append("(wide string)", 13);
+        } else if (available) {
+            available = FormatArgument(reader, spec.type, out_text + length, text_len - length,
+                                       spec_text.data(), stars, spec.num_stars, written);
+        }
 
-    return std::move(entry);
+        if (!available) {
+            append("...", 3);
+            break;
+        }
+        if (written > 0)
+            length += std::min<size_t>(written, text_len - 1 - length);
+
+        // The argument just formatted was the last one which (partially) fit
+        if (entry.args_truncated && reader.AtEnd()) {
+            append("...", 3);
+            break;
+        }
+    }
+
+    out_text[length] = '\0';
+    return length;
+}
+
+void SetGlobalFilter(const Filter* filter) {
+    global_filter = filter;
+}
+
+bool IsLogEnabled(Class log_class, Level log_level) {
+    return global_filter == nullptr || global_filter->CheckMessage(log_class, log_level);
 }
 
 void LogMessage(Class log_class, Level log_level,
                 const char* filename, unsigned int line_nr, const char* function,
                 const char* format, ...) {
+    if (!IsLogEnabled(log_class, log_level))
+        return;
+
     va_list args;
     va_start(args, format);
     Entry entry = CreateEntry(log_class, log_level,
@@ -144,7 +494,7 @@ void LogMessage(Class log_class, Level log_level,
     va_end(args);
 
     if (global_logger != nullptr && !global_logger->IsClosed()) {
-        global_logger->LogMessage(std::move(entry));
+        global_logger->LogMessage(entry);
     } else {
         // Fall back to directly printing to stderr
         PrintMessage(entry);
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdarg>
 #include <memory>
 #include <vector>
 
-#include "common/concurrent_ring_buffer.h"
+#include "common/lockfree_ring_buffer.h"
 
 #include "common/logging/log.h"
 
@@ -17,34 +19,34 @@ namespace Log {
 /**
  * A log entry. Log entries are store in a structured format to permit more varied output
  * formatting on different frontends, as well as facilitating filtering and aggregation.
+ *
+ * Entries have a fixed size and don't own any heap memory, so that logging doesn't allocate on the
+ * emulation threads. The message isn't formatted when it is logged: Only the arguments to the
+ * format string are packed into `args`, and the text is produced by `FormatEntryMessage` on the
+ * thread consuming the entries.
  */
 struct Entry {
+    /**
+     * Maximum number of bytes of packed format arguments, including copies of string arguments.
+     * Large enough for preformatted strings like dumps of IPC command buffers.
+     */
+    static const size_t MAX_ARGS_SIZE = 1024;
+
     std::chrono::microseconds timestamp;
     Class log_class;
     Level log_level;
-    std::string location;
-    std::string message;
-
-    Entry() = default;
-
-    // TODO(yuriks) Use defaulted move constructors once MSVC supports them
-#define MOVE(member) member(std::move(o.member))
-    Entry(Entry&& o)
-        : MOVE(timestamp), MOVE(log_class), MOVE(log_level),
-        MOVE(location), MOVE(message)
-    {}
-#undef MOVE
-
-    Entry& operator=(const Entry&& o) {
-#define MOVE(member) member = std::move(o.member)
-        MOVE(timestamp);
-        MOVE(log_class);
-        MOVE(log_level);
-        MOVE(location);
-        MOVE(message);
-#undef MOVE
-        return *this;
-    }
+    /**
+     * Set if not all arguments fit into `args`, either because one was missing or the last string
+     * argument was cut off. The formatted message ends with "..." at that point.
+     */
+    bool args_truncated;
+    u16 args_size;
+    unsigned int line_nr;
+    // These all point to string literals supplied by the logging macros
+    const char* filename;
+    const char* function;
+    const char* format;
+    std::array<u8, MAX_ARGS_SIZE> args;
 };
 
 struct ClassInfo {
@@ -66,7 +68,9 @@ struct ClassInfo {
  */
 class Logger {
 private:
-    using Buffer = Common::ConcurrentRingBuffer<Entry, 16 * 1024 / sizeof(Entry)>;
+    /// Messages are dropped rather than stalling the emulation when the outputter falls behind
+    using Buffer = Common::LockFreeRingBuffer<Entry, 256, Common::RingBufferProducers::Multiple,
+                                              Common::RingBufferFullPolicy::Drop>;
 
 public:
     static const size_t QUEUE_CLOSED = Buffer::QUEUE_CLOSED;
@@ -92,10 +96,15 @@ public:
     static const char* GetLevelName(Level log_level);
 
     /**
-     * Appends a messages to the log buffer.
+     * Appends a messages to the log buffer. Never blocks, if the buffer is full the message is
+     * dropped instead. Until the first call to GetEntries, messages which don't fit are printed
+     * directly, since nothing would ever make room for them.
      * @note This function is thread safe.
      */
-    void LogMessage(Entry entry);
+    void LogMessage(const Entry& entry);
+
+    /// Returns the number of messages which were dropped because the log buffer was full.
+    u64 GetDroppedCount() const { return ring_buffer.GetDroppedCount(); }
 
     /**
      * Retrieves a batch of messages from the log buffer, blocking until they are available.
@@ -121,14 +130,31 @@ public:
 
 private:
     Buffer ring_buffer;
+    std::atomic<bool> consumer_started;
     std::vector<ClassInfo> all_classes;
 };
 
-/// Creates a log entry by formatting the given source location, and message.
+class Filter;
+
+/**
+ * Creates a log entry from the given source location and message. The arguments are only packed
+ * into the entry, the message is formatted later by `FormatEntryMessage`.
+ */
 Entry CreateEntry(Class log_class, Level log_level,
                         const char* filename, unsigned int line_nr, const char* function,
                         const char* format, va_list args);
+/**
+ * Formats the message of a log entry into the provided text buffer.
+ * @return The length of the formatted message, not including the null terminator
+ */
+size_t FormatEntryMessage(const Entry& entry, char* out_text, size_t text_len);
 /// Initializes the default Logger.
 std::shared_ptr<Logger> InitGlobalLogger();
+/**
+ * Sets the filter which is checked before a message is recorded, so that filtered out messages
+ * are dropped without doing any work on the logging thread. Pass nullptr to record all messages.
+ * The filter has to outlive any logging, or be unset before it is destroyed.
+ */
+void SetGlobalFilter(const Filter* filter);
 
 }
@@ -0,0 +1,329 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "common/common_paths.h"
+
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/logging/text_formatter.h"
+
+namespace Log {
+
+namespace {
+
+const u32 LOG_FILE_VERSION = 1;
+
+struct FileHeader {
+    char magic[4];
+    u32 version;
+    // Packed arguments are stored in their native representation, so they can only be decoded by
+    // a build using the same type sizes
+    u8 long_size;
+    u8 pointer_size;
+    u8 long_double_size;
+    u8 size_t_size;
+    u32 reserved;
+};
+static_assert(sizeof(FileHeader) == 16, "FileHeader has incorrect size");
+
+enum class RecordType : u8 {
+    End = 0,    ///< Never written, marks the unused (zero-filled) space at the end of a file
+    String = 1, ///< Defines the string with the next id, followed by the text without terminator
+    Entry = 2,  ///< A log entry, followed by the packed arguments
+};
+
+struct RecordHeader {
+    RecordType type;
+    u8 reserved;
+    u16 size; ///< Total size of the record, including this header
+};
+static_assert(sizeof(RecordHeader) == 4, "RecordHeader has incorrect size");
+
+struct EntryRecord {
+    u64 timestamp;
+    u32 filename_id;
+    u32 function_id;
+    u32 format_id;
+    u32 line_nr;
+    u8 log_class;
+    u8 log_level;
+    u8 args_truncated;
+    u8 reserved;
+    u16 args_size;
+    u16 reserved2;
+};
+static_assert(sizeof(EntryRecord) == 32, "EntryRecord has incorrect size");
+
+const size_t MAX_RECORD_SIZE = 0xFFFF;
+
+const u64 DEFAULT_FILE_SIZE = 16 * 1024 * 1024;
+const unsigned DEFAULT_NUM_FILES = 4;
+
+FileHeader MakeFileHeader() {
+    FileHeader header = {};
+    std::memcpy(header.magic, "CLOG", sizeof(header.magic));
+    header.version = LOG_FILE_VERSION;
+    header.long_size = sizeof(long);
+    header.pointer_size = sizeof(void*);
+    header.long_double_size = sizeof(long double);
+    header.size_t_size = sizeof(size_t);
+    return header;
+}
+
+/// Returns the length of a string as it is stored in a string record
+size_t StoredStringLength(const char* str) {
+    size_t length = std::strlen(str);
+    const size_t max_length = MAX_RECORD_SIZE - sizeof(RecordHeader) - sizeof(u32);
+    return length < max_length ? length : max_length;
+}
+
+} // anonymous namespace
+
+BinaryLogWriter::BinaryLogWriter(const std::string& path, u64 max_file_size, unsigned num_files)
+    : path(path), max_file_size(max_file_size), num_files(num_files) {
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    CloseFile();
+}
+
+bool BinaryLogWriter::Open() {
+    FileUtil::CreateFullPath(path);
+    if (FileUtil::Exists(path))
+        RotateFiles();
+    return OpenFile();
+}
+
+void BinaryLogWriter::Write(const Entry& entry) {
+    if (!IsOpen())
+        return;
+
+    // Make sure the strings and the entry end up in the same file, ids are only valid within one
+    size_t entry_size = sizeof(RecordHeader) + sizeof(EntryRecord) + entry.args_size;
+    size_t needed = entry_size;
+    for (const char* str : { entry.filename, entry.function, entry.format }) {
+        if (string_ids.find(str) == string_ids.end())
+            needed += sizeof(RecordHeader) + sizeof(u32) + StoredStringLength(str);
+    }
+    if (write_offset + needed > max_file_size) {
+        CloseFile();
+        RotateFiles();
+        if (!OpenFile() || write_offset + needed > max_file_size)
+            return;
+    }
+
+    EntryRecord record = {};
+    record.timestamp = entry.timestamp.count();
+    record.filename_id = InternString(entry.filename);
+    record.function_id = InternString(entry.function);
+    record.format_id = InternString(entry.format);
+    record.line_nr = entry.line_nr;
+    record.log_class = static_cast<u8>(entry.log_class);
+    record.log_level = static_cast<u8>(entry.log_level);
+    record.args_truncated = entry.args_truncated;
+    record.args_size = entry.args_size;
+
+    RecordHeader header = {};
+    header.type = RecordType::Entry;
+    header.size = static_cast<u16>(entry_size);
+
+    u8* dest = view.GetWritableData() + write_offset;
+    std::memcpy(dest, &header, sizeof(header));
+    std::memcpy(dest + sizeof(header), &record, sizeof(record));
+    std::memcpy(dest + sizeof(header) + sizeof(record), entry.args.data(), entry.args_size);
+    write_offset += entry_size;
+}
+
+u32 BinaryLogWriter::InternString(const char* str) {
+    auto it = string_ids.find(str);
+    if (it != string_ids.end())
+        return it->second;
+
+    const u32 id = static_cast<u32>(string_ids.size());
+    const size_t length = StoredStringLength(str);
+
+    RecordHeader header = {};
+    header.type = RecordType::String;
+    header.size = static_cast<u16>(sizeof(RecordHeader) + sizeof(u32) + length);
+
+    u8* dest = view.GetWritableData() + write_offset;
+    std::memcpy(dest, &header, sizeof(header));
+    std::memcpy(dest + sizeof(header), &id, sizeof(id));
+    std::memcpy(dest + sizeof(header) + sizeof(id), str, length);
+    write_offset += header.size;
+
+    string_ids.emplace(str, id);
+    return id;
+}
+
+bool BinaryLogWriter::OpenFile() {
+    // The file is created at its maximum size, the unused part at the end is cut off when it's
+    // closed. If we crash before that, the zero-filled space reads as an end marker.
+    if (!file.Open(path, "w+b") || !file.Resize(max_file_size) ||
+        !view.Map(file, 0, max_file_size, true)) {
+        fprintf(stderr, "Failed to create binary log file %s\n", path.c_str());
+        view.Unmap();
+        file.Close();
+        return false;
+    }
+
+    const FileHeader header = MakeFileHeader();
+    std::memcpy(view.GetWritableData(), &header, sizeof(header));
+    write_offset = sizeof(header);
+    string_ids.clear();
+    return true;
+}
+
+void BinaryLogWriter::CloseFile() {
+    if (!IsOpen())
+        return;
+
+    view.Unmap();
+    file.Resize(write_offset);
+    file.Close();
+}
+
+void BinaryLogWriter::RotateFiles() {
+    if (num_files <= 1) {
+        FileUtil::Delete(path);
+        return;
+    }
+
+    if (FileUtil::Exists(GetRotatedPath(num_files - 1)))
+        FileUtil::Delete(GetRotatedPath(num_files - 1));
+    for (unsigned i = num_files - 1; i > 0; --i) {
+        if (FileUtil::Exists(GetRotatedPath(i - 1)))
+            FileUtil::Rename(GetRotatedPath(i - 1), GetRotatedPath(i));
+    }
+}
+
+std::string BinaryLogWriter::GetRotatedPath(unsigned index) const {
+    if (index == 0)
+        return path;
+    return path + "." + std::to_string(index);
+}
+
+bool BinaryLogReader::Open(const std::string& path) {
+    if (!file.Open(path, "rb"))
+        return false;
+
+    const u64 size = file.GetSize();
+    if (size < sizeof(FileHeader) || !view.Map(file, 0, size))
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, view.GetData(), sizeof(header));
+    const FileHeader expected = MakeFileHeader();
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version) {
+        fprintf(stderr, "%s is not a binary log file\n", path.c_str());
+        return false;
+    }
+    if (header.long_size != expected.long_size || header.pointer_size != expected.pointer_size ||
+        header.long_double_size != expected.long_double_size ||
+        header.size_t_size != expected.size_t_size) {
+        fprintf(stderr, "%s was written by a build for a different platform\n", path.c_str());
+        return false;
+    }
+
+    read_offset = sizeof(header);
+    strings.clear();
+    return true;
+}
+
+bool BinaryLogReader::ReadEntry(Entry& entry) {
+    while (read_offset + sizeof(RecordHeader) <= view.GetSize()) {
+        const u8* data = view.GetData() + read_offset;
+
+        RecordHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.type == RecordType::End || header.size < sizeof(RecordHeader) ||
+            read_offset + header.size > view.GetSize())
+            return false;
+        read_offset += header.size;
+
+        const u8* payload = data + sizeof(header);
+        const size_t payload_size = header.size - sizeof(header);
+
+        if (header.type == RecordType::String && payload_size >= sizeof(u32)) {
+            strings.emplace_back(reinterpret_cast<const char*>(payload + sizeof(u32)),
+                                 payload_size - sizeof(u32));
+        } else if (header.type == RecordType::Entry && payload_size >= sizeof(EntryRecord)) {
+            EntryRecord record;
+            std::memcpy(&record, payload, sizeof(record));
+            if (record.args_size > Entry::MAX_ARGS_SIZE ||
+                record.args_size > payload_size - sizeof(record) ||
+                record.log_class >= static_cast<u8>(Class::Count) ||
+                record.log_level >= static_cast<u8>(Level::Count))
+                return false;
+
+            entry.timestamp = std::chrono::microseconds(record.timestamp);
+            entry.log_class = static_cast<Class>(record.log_class);
+            entry.log_level = static_cast<Level>(record.log_level);
+            entry.args_truncated = record.args_truncated != 0;
+            entry.args_size = record.args_size;
+            entry.line_nr = record.line_nr;
+            entry.filename = GetString(record.filename_id);
+            entry.function = GetString(record.function_id);
+            entry.format = GetString(record.format_id);
+            std::memcpy(entry.args.data(), payload + sizeof(record), record.args_size);
+            return true;
+        }
+        // Skip unknown records, so that new record types can be added without breaking readers
+    }
+    return false;
+}
+
+const char* BinaryLogReader::GetString(u32 id) const {
+    return id < strings.size() ? strings[id].c_str() : "<unknown>";
+}
+
+std::shared_ptr<BinaryLogWriter> OpenDefaultBinaryLog() {
+    auto writer = std::make_shared<BinaryLogWriter>(FileUtil::GetUserPath(D_LOGS_IDX) + BINARY_LOG,
+                                                    DEFAULT_FILE_SIZE, DEFAULT_NUM_FILES);
+    if (!writer->Open())
+        return nullptr;
+    return writer;
+}
+
+void BinaryLoggingLoop(std::shared_ptr<Logger> logger, const Filter* filter,
+                       std::shared_ptr<BinaryLogWriter> writer) {
+    // Entries are fairly large, so keep the batch off the stack
+    std::vector<Entry> entry_buffer(256);
+    u64 reported_dropped = 0;
+
+    while (true) {
+        size_t num_entries = logger->GetEntries(entry_buffer.data(), entry_buffer.size());
+        if (num_entries == Logger::QUEUE_CLOSED) {
+            break;
+        }
+
+        u64 dropped = logger->GetDroppedCount();
+        if (dropped != reported_dropped) {
+            // This goes through the buffer as well and shows up in the next batch
+            LOG_WARNING(Log, "%llu log messages were dropped",
+                        static_cast<unsigned long long>(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+
+        for (size_t i = 0; i < num_entries; ++i) {
+            const Entry& entry = entry_buffer[i];
+            if (!filter->CheckMessage(entry.log_class, entry.log_level))
+                continue;
+
+            writer->Write(entry);
+            if (entry.log_level >= Level::Error)
+                PrintColoredMessage(entry);
+        }
+    }
+}
+
+}
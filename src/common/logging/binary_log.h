@@ -0,0 +1,112 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Log {
+
+class Logger;
+struct Entry;
+class Filter;
+
+/**
+ * Writes log entries as compact binary records into memory-mapped files. Messages are stored
+ * unformatted: Format strings and source locations are written once per file and referenced by id
+ * afterwards, followed by the packed arguments of the entry. When the current file is full it is
+ * rotated, keeping a bounded number of older files around, so that long runs use a bounded amount
+ * of disk space.
+ *
+ * Since the files are memory-mapped, records which were written before a crash still end up on
+ * disk. The files can be decoded with citra-logcat.
+ */
+class BinaryLogWriter : NonCopyable {
+public:
+    /**
+     * @param path Path of the current log file. Older files get ".1", ".2", etc. appended.
+     * @param max_file_size Size at which a log file gets rotated
+     * @param num_files Number of files to keep, including the current one
+     */
+    BinaryLogWriter(const std::string& path, u64 max_file_size, unsigned num_files);
+    ~BinaryLogWriter();
+
+    /// Opens the log file, rotating away the one of a previous run. Returns true on success.
+    bool Open();
+
+    bool IsOpen() const { return view.IsMapped(); }
+
+    /// Appends an entry to the log, rotating the file if needed
+    void Write(const Entry& entry);
+
+private:
+    /// Returns the id of a string written to the current file, writing it first if needed
+    u32 InternString(const char* str);
+
+    bool OpenFile();
+    void CloseFile();
+    void RotateFiles();
+    std::string GetRotatedPath(unsigned index) const;
+
+    std::string path;
+    u64 max_file_size;
+    unsigned num_files;
+
+    FileUtil::IOFile file;
+    FileUtil::MappedFileView view;
+    u64 write_offset = 0;
+
+    /// Ids of the strings already written to the current file, keyed by their address
+    std::unordered_map<const char*, u32> string_ids;
+};
+
+/// Reads back the entries of a log file written by BinaryLogWriter.
+class BinaryLogReader : NonCopyable {
+public:
+    /**
+     * Opens a log file for reading.
+     * @return True on success. Files written by a build with a different ABI can't be read.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Reads the next entry from the file. The string pointers in the entry stay valid as long as
+     * the reader exists.
+     * @return False at the end of the file
+     */
+    bool ReadEntry(Entry& entry);
+
+private:
+    const char* GetString(u32 id) const;
+
+    FileUtil::IOFile file;
+    FileUtil::MappedFileView view;
+    u64 read_offset = 0;
+
+    /// Strings defined so far, indexed by id. A deque keeps the pointers to them stable.
+    std::deque<std::string> strings;
+};
+
+/**
+ * Opens a binary log in the user's log directory, with files of up to 16MB of which the 4 most
+ * recent ones are kept.
+ * @return The opened log, or nullptr on failure
+ */
+std::shared_ptr<BinaryLogWriter> OpenDefaultBinaryLog();
+
+/**
+ * Logging loop that repeatedly reads messages from the provided logger and writes them into a
+ * binary log. Errors are additionally printed to the console.
+ */
+void BinaryLoggingLoop(std::shared_ptr<Logger> logger, const Filter* filter,
+                       std::shared_ptr<BinaryLogWriter> writer);
+
+}
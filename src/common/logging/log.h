@@ -76,7 +76,7 @@ enum class Class : ClassType {
 
 /**
  * Logs a message to the global logger. This proxy exists to avoid exposing the details of the
- * Logger class, including the ConcurrentRingBuffer template, to all files that desire to log
+ * Logger class, including the LockFreeRingBuffer template, to all files that desire to log
  * messages, reducing unecessary recompilations.
  */
 void LogMessage(Class log_class, Level log_level,
@@ -90,6 +90,12 @@ void LogMessage(Class log_class, Level log_level,
 #endif
     ;
 
+/**
+ * Returns true if a message of the given class and level passes the global filter. Callers which
+ * need to do expensive work to build the message arguments can check this first.
+ */
+bool IsLogEnabled(Class log_class, Level log_level);
+
 } // namespace Log
 
 #define LOG_GENERIC(log_class, log_level, ...) \
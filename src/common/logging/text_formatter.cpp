@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstdio>
+#include <vector>
 
 #ifdef _WIN32
 #   define WIN32_LEAN_AND_MEAN
@@ -49,9 +50,12 @@ void FormatLogMessage(const Entry& entry, char* out_text, size_t text_len) {
     const char* class_name = Logger::GetLogClassName(entry.log_class);
     const char* level_name = Logger::GetLevelName(entry.log_level);
 
-    snprintf(out_text, text_len, "[%4u.%06u] %s <%s> %s: %s",
+    std::array<char, 4 * 1024> message;
+    FormatEntryMessage(entry, message.data(), message.size());
+
+    snprintf(out_text, text_len, "[%4u.%06u] %s <%s> %s:%s:%u: %s",
         time_seconds, time_fractional, class_name, level_name,
-        TrimSourcePath(entry.location.c_str()), entry.message.c_str());
+        TrimSourcePath(entry.filename), entry.function, entry.line_nr, message.data());
 }
 
 void PrintMessage(const Entry& entry) {
@@ -117,13 +121,23 @@ void PrintColoredMessage(const Entry& entry) {
 }
 
 void TextLoggingLoop(std::shared_ptr<Logger> logger, const Filter* filter) {
-    std::array<Entry, 256> entry_buffer;
+    // Entries are fairly large, so keep the batch off the stack
+    std::vector<Entry> entry_buffer(256);
+    u64 reported_dropped = 0;
 
     while (true) {
         size_t num_entries = logger->GetEntries(entry_buffer.data(), entry_buffer.size());
         if (num_entries == Logger::QUEUE_CLOSED) {
             break;
         }
+
+        u64 dropped = logger->GetDroppedCount();
+        if (dropped != reported_dropped) {
+            // This goes through the buffer as well and shows up in the next batch
+            LOG_WARNING(Log, "%llu log messages were dropped",
+                        static_cast<unsigned long long>(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
         for (size_t i = 0; i < num_entries; ++i) {
             const Entry& entry = entry_buffer[i];
             if (filter->CheckMessage(entry.log_class, entry.log_level)) {
@@ -0,0 +1,63 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t num_threads, const std::string& name) : name(name) {
+    for (size_t i = 0; i < num_threads; ++i)
+        workers.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::Push(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::WaitForIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && running_tasks == 0; });
+}
+
+void ThreadPool::WorkerLoop() {
+    SetCurrentThreadName(name.c_str());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+        // Drain the queue before stopping, so that nobody waits for a task which never runs
+        if (tasks.empty())
+            return;
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        ++running_tasks;
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        if (--running_tasks == 0 && tasks.empty())
+            idle.notify_all();
+    }
+}
+
+} // namespace
@@ -0,0 +1,55 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common.h" // for NonCopyable
+
+namespace Common {
+
+/**
+ * A fixed number of worker threads executing tasks in the order they were pushed. Meant for work
+ * which would otherwise block the emulation thread, like host file I/O.
+ */
+class ThreadPool : private NonCopyable {
+public:
+    /**
+     * Starts the worker threads.
+     * @param num_threads Number of worker threads
+     * @param name Name given to the worker threads, for debugging purposes
+     */
+    ThreadPool(size_t num_threads, const std::string& name);
+
+    /// Waits for all pending tasks to finish and stops the worker threads.
+    ~ThreadPool();
+
+    /// Queues a task to be run on one of the worker threads.
+    void Push(std::function<void()> task);
+
+    /// Blocks until all queued tasks have finished running.
+    void WaitForIdle();
+
+private:
+    void WorkerLoop();
+
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> tasks;
+    size_t running_tasks = 0;
+    bool stopping = false;
+
+    std::string name;
+    std::vector<std::thread> workers;
+};
+
+} // namespace
@@ -54,6 +54,18 @@ struct ThreadQueueList {
         return T();
     }
 
+    T get_first_better(Priority priority) const {
+        const Queue *cur = first;
+        const Queue *stop = &queues[priority];
+        while (cur < stop) {
+            if (!cur->data.empty())
+                return cur->data.front();
+            cur = cur->next_nonempty;
+        }
+
+        return T();
+    }
+
     T pop_first_better(Priority priority) {
         Queue *cur = first;
         Queue *stop = &queues[priority];
@@ -103,6 +115,11 @@ struct ThreadQueueList {
         return cur->data.empty();
     }
 
+    /// Returns the elements queued at a priority level, front first.
+    const std::deque<T>& get_queue(Priority priority) const {
+        return queues[priority].data;
+    }
+
     void prepare(Priority priority) {
         Queue* cur = &queues[priority];
         if (cur->next_nonempty == UnlinkedTag())
@@ -5,10 +5,17 @@
 #pragma once
 
 #include "common/common.h"
+#include <chrono>
 #include <string>
 
 namespace Common
 {
+/// Returns the host time passed since the given point in time, in microseconds
+inline u64 MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 class Timer
 {
 public:
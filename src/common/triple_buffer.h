@@ -0,0 +1,111 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#include "common/common.h" // for NonCopyable
+
+namespace Common {
+
+/**
+ * A SPSC (Single-Producer Single-Consumer) mailbox built from three buffers. The producer always
+ * owns one buffer it can fill without ever waiting for the consumer, the consumer always owns the
+ * buffer it is currently reading, and the third buffer holds the most recently published data.
+ * If the producer publishes faster than the consumer reads, older data is dropped in favor of the
+ * latest ("latest wins").
+ */
+template <typename T>
+class TripleBuffer : private NonCopyable {
+public:
+    TripleBuffer() {}
+
+    /**
+     * Returns the buffer owned by the producer. Its contents are whatever was stored in it the last
+     * time it was used, which allows producers to skip updating data that didn't change.
+     */
+    T& GetWriteBuffer() {
+        return buffers[write_index];
+    }
+
+    /**
+     * Publishes the producer's buffer to the consumer and hands the producer a new buffer.
+     * @return True if the previously published buffer had not been consumed yet and got dropped
+     */
+    bool Publish() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::swap(write_index, ready_index);
+        const bool dropped = has_new_data;
+        has_new_data = true;
+
+        lock.unlock();
+        reader.notify_one();
+        return dropped;
+    }
+
+    /**
+     * Waits until new data has been published and hands the latest published buffer to the
+     * consumer. The returned buffer stays valid until the next call to this function.
+     * @return Pointer to the published buffer, or nullptr if the mailbox has been closed
+     */
+    T* WaitForRead() {
+        std::unique_lock<std::mutex> lock(mutex);
+        reader.wait(lock, [&]{ return has_new_data || closed; });
+        if (closed)
+            return nullptr;
+
+        std::swap(read_index, ready_index);
+        has_new_data = false;
+        return &buffers[read_index];
+    }
+
+    /// Closes the mailbox, waking up and returning nullptr to any waiting consumer.
+    void Close() {
+        std::unique_lock<std::mutex> lock(mutex);
+        closed = true;
+
+        lock.unlock();
+        reader.notify_all();
+    }
+
+    /**
+     * Calls func on each of the buffers. Only allowed while neither the producer nor the consumer
+     * is accessing the mailbox.
+     */
+    template <typename Func>
+    void ForEach(Func func) {
+        for (T& buffer : buffers)
+            func(buffer);
+    }
+
+    /// Reopens a closed mailbox, discarding any published but unconsumed data.
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = false;
+        has_new_data = false;
+    }
+
+private:
+    std::array<T, 3> buffers;
+
+    size_t write_index = 0; ///< Buffer owned by the producer
+    size_t ready_index = 1; ///< Most recently published buffer
+    size_t read_index = 2;  ///< Buffer owned by the consumer
+
+    /// True if ready_index refers to data the consumer hasn't seen yet
+    bool has_new_data = false;
+    /// True if the mailbox has been closed
+    bool closed = false;
+
+    /// Mutex protecting the buffer indices. Buffer contents are protected by ownership.
+    std::mutex mutex;
+    /// Signaled when new data has been published or the mailbox has been closed.
+    std::condition_variable reader;
+};
+
+} // namespace
@@ -7,6 +7,8 @@
 #include "common/common.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Core {
     struct ThreadContext;
 }
@@ -109,6 +111,13 @@ public:
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
 
+    /**
+     * Saves or loads the state of the core, for savestates. Must not be called while the core is
+     * executing.
+     * @param p Serializer to save the state to or load it from
+     */
+    virtual void DoState(PointerWrap& p) = 0;
+
     /// Getter for num_instructions
     u64 GetNumInstructions() {
         return num_instructions;
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
+
 #include "core/arm/skyeye_common/armemu.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
 
@@ -75,7 +77,9 @@ u64 ARM_DynCom::GetTicks() const {
 
 void ARM_DynCom::AddTicks(u64 ticks) {
     down_count -= ticks;
-    if (down_count < 0)
+
+    // Only the application core drives CoreTiming, the system core just follows it in lockstep
+    if (down_count < 0 && this == Core::g_app_core)
         CoreTiming::Advance();
 }
 
@@ -87,6 +91,23 @@ void ARM_DynCom::ExecuteInstructions(int num_instructions) {
     // instructions may actually be executed than specified.
     unsigned ticks_executed = InterpreterMainLoop(state.get());
     AddTicks(ticks_executed);
+
+    // The interpreter stops early when the guest spins in a loop which can't make progress until
+    // the next scheduled event happens. Fast-forward to that event instead of emulating the loop.
+    if (state->IdleLoopDetected) {
+        state->IdleLoopDetected = false;
+
+        // The system core can't skip ahead on its own, it just ends its slice early
+        if (this != Core::g_app_core)
+            return;
+
+        const u64 idle_ticks_before = CoreTiming::GetIdleTicks();
+        CoreTiming::Idle();
+        RecordIdleLoopSkip(state->Reg[15], CoreTiming::GetIdleTicks() - idle_ticks_before);
+
+        if (down_count < 0)
+            CoreTiming::Advance();
+    }
 }
 
 void ARM_DynCom::ResetContext(Core::ThreadContext& context, u32 stack_top, u32 entry_point, u32 arg) {
@@ -101,34 +122,71 @@ void ARM_DynCom::ResetContext(Core::ThreadContext& context, u32 stack_top, u32 e
 
 void ARM_DynCom::SaveContext(Core::ThreadContext& ctx) {
     memcpy(ctx.cpu_registers, state->Reg, sizeof(ctx.cpu_registers));
-    memcpy(ctx.fpu_registers, state->ExtReg, sizeof(ctx.fpu_registers));
 
     ctx.sp = state->Reg[13];
     ctx.lr = state->Reg[14];
     ctx.pc = state->Reg[15];
     ctx.cpsr = state->Cpsr;
 
-    ctx.fpscr = state->VFP[1];
-    ctx.fpexc = state->VFP[2];
-
     ctx.mode = state->NextInstr;
+
+    // VFP registers are only written back once another thread needs them (see LoadContext). If
+    // this thread's VFP registers are loaded, its context becomes the owner of the registers.
+    if (state->VFPContextPending == nullptr)
+        state->VFPContextOwner = &ctx;
 }
 
 void ARM_DynCom::LoadContext(const Core::ThreadContext& ctx) {
     memcpy(state->Reg, ctx.cpu_registers, sizeof(ctx.cpu_registers));
-    memcpy(state->ExtReg, ctx.fpu_registers, sizeof(ctx.fpu_registers));
 
     state->Reg[13] = ctx.sp;
     state->Reg[14] = ctx.lr;
     state->Reg[15] = ctx.pc;
     state->Cpsr = ctx.cpsr;
 
-    state->VFP[1] = ctx.fpscr;
-    state->VFP[2] = ctx.fpexc;
-
     state->NextInstr = ctx.mode;
+
+    // Most threads never touch the VFP, so its registers are switched lazily: unless they
+    // already belong to this context, they are exchanged right before the next VFP instruction.
+    state->VFPContextPending = (&ctx == state->VFPContextOwner) ? nullptr : &ctx;
 }
 
 void ARM_DynCom::PrepareReschedule() {
     state->NumInstrsToExecute = 0;
 }
+
+void ARM_DynCom::DoState(PointerWrap& p) {
+    // The lazily switched VFP registers refer to thread contexts by address, which can't be saved.
+    // Settle them first, so that the VFP registers belong to the running thread.
+    if (p.GetMode() != PointerWrap::MODE_READ && state->VFPContextPending != nullptr)
+        VFPLoadPendingContext(state.get());
+
+    p.Do(down_count);
+
+    // Everything from Reg up to the end of ExtReg is laid out contiguously
+    const size_t ordered_size = reinterpret_cast<u8*>(state->ExtReg + VFP_REG_NUM) -
+                                reinterpret_cast<u8*>(state->Reg);
+    p.DoVoid(state->Reg, static_cast<int>(ordered_size));
+    p.DoArray(&state->RegBank[0][0], 7 * 16);
+
+    p.Do(state->NFlag);
+    p.Do(state->ZFlag);
+    p.Do(state->CFlag);
+    p.Do(state->VFlag);
+    p.Do(state->IFFlags);
+    p.Do(state->shifter_carry_out);
+    p.Do(state->GEFlag);
+    p.Do(state->EFlag);
+    p.Do(state->AFlag);
+    p.Do(state->QFlag);
+    p.Do(state->TFlag);
+    p.Do(state->NextInstr);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // Any reservation made before the state was saved is gone
+        state->exclusive_tag = 0xFFFFFFFF;
+        state->IdleLoopDetected = false;
+        state->VFPContextOwner = nullptr;
+        state->VFPContextPending = nullptr;
+    }
+}
@@ -31,6 +31,7 @@ public:
     void LoadContext(const Core::ThreadContext& ctx) override;
 
     void PrepareReschedule() override;
+    void DoState(PointerWrap& p) override;
     void ExecuteInstructions(int num_instructions) override;
 
 private:
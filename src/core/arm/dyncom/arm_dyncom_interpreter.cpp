@@ -5,12 +5,16 @@
 #define CITRA_IGNORE_EXIT(x)
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <mutex>
 #include <unordered_map>
 
 #include "common/logging/log.h"
 
+#include "core/core.h"
 #include "core/mem_map.h"
+#include "core/settings.h"
 #include "core/hle/hle.h"
 #include "core/arm/disassembler/arm_disasm.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
@@ -48,6 +52,19 @@ typedef unsigned int (*shtop_fp_t)(ARMul_State* cpu, unsigned int sht_oper);
 // support LDR/STREXD.
 static const ARMword RESERVATION_GRANULE_MASK = 0xFFFFFFF8;
 
+// Global exclusive monitor shared by all cores. Each entry is the version of the reservation
+// granules hashing to it, which is odd while a store-exclusive to one of them is in progress. A
+// store-exclusive only succeeds if the version is still the one observed by the matching
+// load-exclusive, i.e. if no other core stored exclusively to the granule in between. Hash
+// collisions merely cause spurious failures, which the architecture allows for. With a single
+// core, the local monitor is all there is, so the global one is skipped.
+static const size_t GLOBAL_MONITOR_SIZE = 4096;
+static std::atomic<u32> global_monitor[GLOBAL_MONITOR_SIZE];
+
+static std::atomic<u32>& global_monitor_entry(ARMword addr) {
+    return global_monitor[(addr / (~RESERVATION_GRANULE_MASK + 1)) % GLOBAL_MONITOR_SIZE];
+}
+
 // Exclusive memory access
 static int exclusive_detect(ARMul_State* state, ARMword addr) {
     if(state->exclusive_tag == (addr & RESERVATION_GRANULE_MASK))
@@ -58,13 +75,40 @@ static int exclusive_detect(ARMul_State* state, ARMword addr) {
 
 static void add_exclusive_addr(ARMul_State* state, ARMword addr){
     state->exclusive_tag = addr & RESERVATION_GRANULE_MASK;
-    return;
+    if (!Core::IsMultiCore())
+        return;
+
+    // Wait for store-exclusives of other cores to finish, so that the load observes their data
+    std::atomic<u32>& entry = global_monitor_entry(addr);
+    u32 version;
+    while ((version = entry.load(std::memory_order_acquire)) & 1)
+        ;
+    state->exclusive_version = version;
 }
 
 static void remove_exclusive(ARMul_State* state, ARMword addr){
     state->exclusive_tag = 0xFFFFFFFF;
 }
 
+// Claims the reservation granule in the global monitor before a store-exclusive writes to it.
+// Returns false if another core has stored exclusively to it since the load-exclusive.
+static bool claim_exclusive(ARMul_State* state, ARMword addr) {
+    if (!Core::IsMultiCore())
+        return true;
+
+    u32 expected = state->exclusive_version;
+    return global_monitor_entry(addr).compare_exchange_strong(expected, expected + 1,
+                                                              std::memory_order_acquire);
+}
+
+// Releases the reservation granule once the store-exclusive has written to it.
+static void release_exclusive(ARMul_State* state, ARMword addr) {
+    if (!Core::IsMultiCore())
+        return;
+
+    global_monitor_entry(addr).store(state->exclusive_version + 2, std::memory_order_release);
+}
+
 static unsigned int DPO(Immediate)(ARMul_State* cpu, unsigned int sht_oper) {
     unsigned int immed_8 = BITS(sht_oper, 0, 7);
     unsigned int rotate_imm = BITS(sht_oper, 8, 11);
@@ -3481,18 +3525,28 @@ const transop_fp_t arm_instruction_trans[] = {
     INTERPRETER_TRANSLATE(blx_1_thumb)
 };
 
-typedef std::unordered_map<u32, int> bb_map;
-static bb_map CreamCache;
+struct BasicBlock {
+    int start;      ///< Offset of the translated block in inst_buf
+    bool idle_loop; ///< True if the block is a loop which can't make progress on its own
+};
+
+typedef std::unordered_map<u32, BasicBlock> bb_map;
+
+// Each core looks up blocks in its own map, so that lookups don't need any locking. Translated
+// blocks are never modified, but inst_buf is shared, so translation itself is serialized.
+static bb_map CreamCache[Core::NUM_CORES];
+static std::mutex translation_mutex;
 
-static void insert_bb(unsigned int addr, int start) {
-    CreamCache[addr] = start;
+static void insert_bb(bb_map& cream_cache, unsigned int addr, int start, bool idle_loop) {
+    cream_cache[addr] = { start, idle_loop };
 }
 
-static int find_bb(unsigned int addr, int& start) {
+static int find_bb(const bb_map& cream_cache, unsigned int addr, int& start, bool& idle_loop) {
     int ret = -1;
-    bb_map::const_iterator it = CreamCache.find(addr);
-    if (it != CreamCache.end()) {
-        start = static_cast<int>(it->second);
+    bb_map::const_iterator it = cream_cache.find(addr);
+    if (it != cream_cache.end()) {
+        start = it->second.start;
+        idle_loop = it->second.idle_loop;
         ret = 0;
     } else {
         ret = -1;
@@ -3500,6 +3554,195 @@ static int find_bb(unsigned int addr, int& start) {
     return ret;
 }
 
+// Idle loop detection
+//
+// Games often busy-wait on a memory location, e.g. for a flag set by an interrupt handler. Since
+// nothing but a scheduled event can change memory while such a loop runs, executing it is a waste
+// of host time. A basic block is considered an idle loop if it directly branches back to its own
+// start and only consists of loads (without writeback) and data processing instructions, such
+// that neither a register nor a condition flag is carried over from one iteration to the next.
+// Every iteration then computes the same values from the same memory contents.
+
+/// Maximum number of instructions in a basic block considered for idle loop detection
+static const int kMaxIdleLoopLength = 8;
+
+// Pseudo registers standing for the condition flags in the idle loop dataflow masks
+static const u32 kIdleLoopFlagN = 1 << 16;
+static const u32 kIdleLoopFlagZ = 1 << 17;
+static const u32 kIdleLoopFlagC = 1 << 18;
+static const u32 kIdleLoopFlagV = 1 << 19;
+static const u32 kIdleLoopFlagsNZCV = kIdleLoopFlagN | kIdleLoopFlagZ | kIdleLoopFlagC | kIdleLoopFlagV;
+
+/// Tracks the register and flag dataflow of a basic block during translation to detect idle loops
+struct IdleLoopDetector {
+    bool candidate = true;
+    u32 defined = 0;  ///< Registers certainly written by the block so far
+    u32 modified = 0; ///< Registers possibly written by the block so far
+    u32 live_in = 0;  ///< Registers possibly read before being written by the block
+
+    /**
+     * Adds the operands of an instruction to the dataflow
+     * @param reads Mask of registers read
+     * @param writes Mask of registers always written
+     * @param partial_writes Mask of registers which might keep their previous value
+     */
+    void AddRegisters(u32 reads, u32 writes, u32 partial_writes) {
+        live_in |= reads & ~defined;
+        defined |= writes;
+        modified |= writes | partial_writes;
+    }
+
+    bool IsIdleLoop() const {
+        return candidate && (live_in & modified) == 0;
+    }
+};
+
+/// Returns the mask of condition flags read by an ARM condition code
+static u32 GetConditionFlags(u32 cond) {
+    switch (cond >> 1) {
+    case 0: return kIdleLoopFlagZ;                                   // EQ, NE
+    case 1: return kIdleLoopFlagC;                                   // CS, CC
+    case 2: return kIdleLoopFlagN;                                   // MI, PL
+    case 3: return kIdleLoopFlagV;                                   // VS, VC
+    case 4: return kIdleLoopFlagC | kIdleLoopFlagZ;                  // HI, LS
+    case 5: return kIdleLoopFlagN | kIdleLoopFlagV;                  // GE, LT
+    case 6: return kIdleLoopFlagN | kIdleLoopFlagZ | kIdleLoopFlagV; // GT, LE
+    default: return 0;                                               // AL
+    }
+}
+
+/**
+ * Determines the registers and condition flags accessed by an instruction allowed in an idle loop
+ * @param inst ARM instruction (Thumb instructions need to be translated first)
+ * @param reads Set to the mask of registers and flags read by the instruction
+ * @param writes Set to the mask of registers and flags always written by the instruction
+ * @param partial_writes Set to the mask of registers and flags the instruction might leave alone
+ * @return False if the instruction may not appear in an idle loop
+ */
+static bool GetIdleLoopOperands(u32 inst, u32& reads, u32& writes, u32& partial_writes) {
+    const u32 cond = BITS(inst, 28, 31);
+    const u32 rn = BITS(inst, 16, 19);
+    const u32 rd = BITS(inst, 12, 15);
+    const u32 rm = BITS(inst, 0, 3);
+
+    if (cond == 0xF)
+        return false;
+
+    partial_writes = 0;
+    if (BITS(inst, 26, 27) == 1) {
+        // LDR, LDRB; no stores, no writeback, no media instructions
+        const bool register_offset = BIT(inst, 25) != 0;
+        if (!BIT(inst, 20) || !BIT(inst, 24) || BIT(inst, 21) || rd == 15 || (register_offset && BIT(inst, 4)))
+            return false;
+
+        reads = (1 << rn) | (register_offset ? (1 << rm) : 0);
+        writes = 1 << rd;
+    } else if (BITS(inst, 25, 27) == 0 && BIT(inst, 7) && BIT(inst, 4)) {
+        // LDRH, LDRSB, LDRSH; no multiplies, swaps, stores or writeback
+        if (BITS(inst, 5, 6) == 0 || !BIT(inst, 20) || !BIT(inst, 24) || BIT(inst, 21) || rd == 15)
+            return false;
+
+        reads = (1 << rn) | (BIT(inst, 22) ? 0 : (1 << rm));
+        writes = 1 << rd;
+    } else if (BITS(inst, 26, 27) == 0) {
+        // Data processing
+        const u32 opcode = BITS(inst, 21, 24);
+        const bool is_test = (opcode >= 8 && opcode <= 11);
+        const bool immediate = BIT(inst, 25) != 0;
+
+        // Test opcodes without the S bit encode miscellaneous instructions like MSR or BX
+        if ((is_test && !BIT(inst, 20)) || (!is_test && rd == 15))
+            return false;
+
+        reads = 0;
+        if (opcode != 13 && opcode != 15) // MOV and MVN don't use Rn
+            reads |= 1 << rn;
+        if (!immediate) {
+            reads |= 1 << rm;
+            if (BIT(inst, 4))
+                reads |= 1 << BITS(inst, 8, 11);
+        }
+        writes = is_test ? 0 : (1 << rd);
+
+        // ADC, SBC and RSC consume the carry flag, and so does an RRX shift
+        const bool rrx = !immediate && BITS(inst, 4, 11) == 0x6;
+        if ((opcode >= 5 && opcode <= 7) || rrx)
+            reads |= kIdleLoopFlagC;
+
+        if (BIT(inst, 20)) {
+            const bool arithmetic = (opcode >= 2 && opcode <= 7) || opcode == 10 || opcode == 11;
+            if (arithmetic) {
+                writes |= kIdleLoopFlagsNZCV;
+            } else {
+                // Logical operations keep V, and C unless the shifter produces a carry
+                writes |= kIdleLoopFlagN | kIdleLoopFlagZ;
+                partial_writes |= kIdleLoopFlagC;
+            }
+        }
+    } else {
+        return false;
+    }
+
+    // A conditional instruction reads the flags, and might keep the previous value of everything
+    // it writes
+    reads |= GetConditionFlags(cond);
+    if (cond != 0xE) {
+        partial_writes |= writes;
+        writes = 0;
+    }
+
+    return true;
+}
+
+/// Returns true if the given ARM instruction at addr is a B (without link) to target
+static bool IsDirectBranchTo(u32 inst, u32 addr, u32 target) {
+    if (BITS(inst, 28, 31) == 0xF || BITS(inst, 24, 27) != 0xA)
+        return false;
+
+    const s32 offset = static_cast<s32>(inst << 8) >> 6;
+    return addr + 8 + offset == target;
+}
+
+/// Returns true if the given Thumb instruction at addr is a B (conditional or not) to target
+static bool IsThumbDirectBranchTo(u32 tinstr, u32 addr, u32 target) {
+    s32 offset;
+    if ((tinstr & 0xF000) == 0xD000 && BITS(tinstr, 8, 11) < 0xE)
+        offset = static_cast<s32>(tinstr << 24) >> 23;
+    else if ((tinstr & 0xF800) == 0xE000)
+        offset = static_cast<s32>(tinstr << 21) >> 20;
+    else
+        return false;
+
+    return addr + 4 + offset == target;
+}
+
+static std::mutex idle_loop_stats_mutex;
+static std::unordered_map<u32, IdleLoopStats> idle_loop_stats;
+
+void RecordIdleLoopSkip(u32 address, u64 cycles) {
+    std::lock_guard<std::mutex> lock(idle_loop_stats_mutex);
+    IdleLoopStats& stats = idle_loop_stats[address];
+    stats.address = address;
+    stats.hits++;
+    stats.skipped_cycles += cycles;
+}
+
+std::vector<IdleLoopStats> GetIdleLoopStats() {
+    std::lock_guard<std::mutex> lock(idle_loop_stats_mutex);
+    std::vector<IdleLoopStats> result;
+    result.reserve(idle_loop_stats.size());
+    for (const auto& entry : idle_loop_stats)
+        result.push_back(entry.second);
+    return result;
+}
+
+void InterpreterClearCache() {
+    std::lock_guard<std::mutex> lock(translation_mutex);
+    for (auto& cream_cache : CreamCache)
+        cream_cache.clear();
+    top = 0;
+}
+
 enum {
     FETCH_SUCCESS,
     FETCH_FAILURE
@@ -3568,11 +3811,13 @@ typedef struct instruction_set_encoding_item ISEITEM;
 
 extern const ISEITEM arm_instruction[];
 
-static int InterpreterTranslate(ARMul_State* cpu, int& bb_start, addr_t addr) {
+static int InterpreterTranslate(ARMul_State* cpu, bb_map& cream_cache, int& bb_start, bool& idle_loop, addr_t addr) {
     // Decode instruction, get index
     // Allocate memory and init InsCream
     // Go on next, until terminal instruction
     // Save start addr of basicblock in CreamCache
+    std::lock_guard<std::mutex> lock(translation_mutex);
+
     ARM_INST_PTR inst_base = nullptr;
     unsigned int inst, inst_size = 4;
     int idx;
@@ -3586,11 +3831,15 @@ static int InterpreterTranslate(ARMul_State* cpu, int& bb_start, addr_t addr) {
 
     addr_t phys_addr = addr;
     addr_t pc_start = cpu->Reg[15];
+    IdleLoopDetector idle_loop_detector;
 
     while(ret == NON_BRANCH) {
         inst = Memory::Read32(phys_addr & 0xFFFFFFFC);
 
         size++;
+        if (size > kMaxIdleLoopLength)
+            idle_loop_detector.candidate = false;
+
         // If we are in thumb instruction, we will translate one thumb to one corresponding arm instruction
         if (cpu->TFlag) {
             uint32_t arm_inst;
@@ -3599,6 +3848,11 @@ static int InterpreterTranslate(ARMul_State* cpu, int& bb_start, addr_t addr) {
 
             // We have translated the branch instruction of thumb in thumb decoder
             if(state == t_branch){
+                u32 tinstr = ((phys_addr & 0x3) != 0) ? (inst >> 16) : (inst & 0xFFFF);
+                if (!IsThumbDirectBranchTo(tinstr, phys_addr, pc_start))
+                    idle_loop_detector.candidate = false;
+                else if ((tinstr & 0xF000) == 0xD000)
+                    idle_loop_detector.AddRegisters(GetConditionFlags(BITS(tinstr, 8, 11)), 0, 0);
                 goto translated;
             }
             inst = arm_inst;
@@ -3612,15 +3866,27 @@ static int InterpreterTranslate(ARMul_State* cpu, int& bb_start, addr_t addr) {
             CITRA_IGNORE_EXIT(-1);
         }
         inst_base = arm_instruction_trans[idx](inst, idx);
+
+        if (idle_loop_detector.candidate) {
+            u32 reads, writes, partial_writes;
+            if (inst_base->br == NON_BRANCH && GetIdleLoopOperands(inst, reads, writes, partial_writes))
+                idle_loop_detector.AddRegisters(reads, writes, partial_writes);
+            else if (inst_base->br == NON_BRANCH || cpu->TFlag || !IsDirectBranchTo(inst, phys_addr, pc_start))
+                idle_loop_detector.candidate = false;
+            else
+                idle_loop_detector.AddRegisters(GetConditionFlags(BITS(inst, 28, 31)), 0, 0);
+        }
 translated:
         phys_addr += inst_size;
 
         if ((phys_addr & 0xfff) == 0) {
             inst_base->br = END_OF_PAGE;
+            idle_loop_detector.candidate = false;
         }
         ret = inst_base->br;
     };
-    insert_bb(pc_start, bb_start);
+    idle_loop = idle_loop_detector.IsIdleLoop();
+    insert_bb(cream_cache, pc_start, bb_start, idle_loop);
     return KEEP_GOING;
 }
 
@@ -3932,6 +4198,9 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
     unsigned int num_instrs = 0;
 
     int ptr;
+    bool idle_loop = false;
+    u32 last_block_addr = 0xFFFFFFFF;
+    bb_map& cream_cache = CreamCache[Core::GetCurrentCoreId()];
 
     LOAD_NZCVT;
     DISPATCH:
@@ -3949,10 +4218,19 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
 
         phys_addr = cpu->Reg[15];
 
-        if (find_bb(cpu->Reg[15], ptr) == -1)
-            if (InterpreterTranslate(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+        if (find_bb(cream_cache, cpu->Reg[15], ptr, idle_loop) == -1)
+            if (InterpreterTranslate(cpu, cream_cache, ptr, idle_loop, cpu->Reg[15]) == FETCH_EXCEPTION)
                 goto END;
 
+        // Re-entering an idle loop from itself means that a full iteration went by without any
+        // effect. The loop will keep spinning until an event happens, so stop here and let the
+        // caller fast-forward to it.
+        if (idle_loop && cpu->Reg[15] == last_block_addr && Settings::values.skip_idle_loops) {
+            cpu->IdleLoopDetected = true;
+            goto END;
+        }
+        last_block_addr = cpu->Reg[15];
+
         inst_base = (arm_inst *)&inst_buf[ptr];
         GOTO_NEXT_INST;
     }
@@ -6145,11 +6423,13 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
             generic_arm_inst* inst_cream = (generic_arm_inst*)inst_base->component;
             unsigned int write_addr = cpu->Reg[inst_cream->Rn];
 
-            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1)) {
+            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1) &&
+                claim_exclusive(cpu, write_addr)) {
                 remove_exclusive(cpu, write_addr);
                 cpu->exclusive_state = 0;
 
                 Memory::Write32(write_addr, cpu->Reg[inst_cream->Rm]);
+                release_exclusive(cpu, write_addr);
                 RD = 0;
             } else {
                 // Failed to write due to mutex access
@@ -6167,11 +6447,13 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
             generic_arm_inst* inst_cream = (generic_arm_inst*)inst_base->component;
             unsigned int write_addr = cpu->Reg[inst_cream->Rn];
 
-            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1)) {
+            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1) &&
+                claim_exclusive(cpu, write_addr)) {
                 remove_exclusive(cpu, write_addr);
                 cpu->exclusive_state = 0;
 
                 Memory::Write8(write_addr, cpu->Reg[inst_cream->Rm]);
+                release_exclusive(cpu, write_addr);
                 RD = 0;
             } else {
                 // Failed to write due to mutex access
@@ -6189,12 +6471,14 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
             generic_arm_inst* inst_cream = (generic_arm_inst*)inst_base->component;
             unsigned int write_addr = cpu->Reg[inst_cream->Rn];
 
-            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1)) {
+            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1) &&
+                claim_exclusive(cpu, write_addr)) {
                 remove_exclusive(cpu, write_addr);
                 cpu->exclusive_state = 0;
 
                 Memory::Write32(write_addr, cpu->Reg[inst_cream->Rm]);
                 Memory::Write32(write_addr + 4, cpu->Reg[inst_cream->Rm + 1]);
+                release_exclusive(cpu, write_addr);
                 RD = 0;
             }
             else {
@@ -6213,11 +6497,13 @@ unsigned InterpreterMainLoop(ARMul_State* state) {
             generic_arm_inst* inst_cream = (generic_arm_inst*)inst_base->component;
             unsigned int write_addr = cpu->Reg[inst_cream->Rn];
 
-            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1)) {
+            if ((exclusive_detect(cpu, write_addr) == 0) && (cpu->exclusive_state == 1) &&
+                claim_exclusive(cpu, write_addr)) {
                 remove_exclusive(cpu, write_addr);
                 cpu->exclusive_state = 0;
 
                 Memory::Write16(write_addr, cpu->Reg[inst_cream->Rm]);
+                release_exclusive(cpu, write_addr);
                 RD = 0;
             } else {
                 // Failed to write due to mutex access
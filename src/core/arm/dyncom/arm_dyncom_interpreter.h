@@ -4,6 +4,33 @@
 
 #pragma once
 
+#include <vector>
+
+#include "common/common_types.h"
+
 #include "core/arm/skyeye_common/armdefs.h"
 
 unsigned InterpreterMainLoop(ARMul_State* state);
+
+/// Statistics about an idle loop which has been fast-forwarded over
+struct IdleLoopStats {
+    u32 address;        ///< Address of the first instruction of the loop
+    u64 hits;           ///< Number of times the loop has been skipped
+    u64 skipped_cycles; ///< Total number of emulated cycles skipped
+};
+
+/**
+ * Records that the CPU core fast-forwarded over an idle loop.
+ * @param address Address of the first instruction of the loop
+ * @param cycles Number of emulated cycles skipped
+ */
+void RecordIdleLoopSkip(u32 address, u64 cycles);
+
+/// Returns the statistics of all idle loops skipped so far (thread-safe).
+std::vector<IdleLoopStats> GetIdleLoopStats();
+
+/**
+ * Drops all translated blocks, so that code is translated again from memory on its next execution.
+ * Must not be called while a core is executing.
+ */
+void InterpreterClearCache();
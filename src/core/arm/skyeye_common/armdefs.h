@@ -22,6 +22,10 @@
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/arm/skyeye_common/skyeye_defs.h"
 
+namespace Core {
+struct ThreadContext;
+}
+
 #define BITS(s, a, b) ((s << ((sizeof(s) * 8 - 1) - b)) >> (sizeof(s) * 8 - b + a - 1))
 #define BIT(s, n) ((s >> (n)) & 1)
 
@@ -91,6 +95,7 @@ struct ARMul_State
     ARMword Bank;               // The current register bank
     ARMword exclusive_tag;      // The address for which the local monitor is in exclusive access mode
     ARMword exclusive_state;
+    ARMword exclusive_version;  // Global monitor version of exclusive_tag when it was reserved
     ARMword exclusive_result;
     ARMword CP15[VFP_BASE - CP15_BASE];
     ARMword VFP[3]; // FPSID, FPSCR, and FPEXC
@@ -112,6 +117,11 @@ struct ARMul_State
 
     unsigned long long NumInstrs; // The number of instructions executed
     unsigned NumInstrsToExecute;
+    bool IdleLoopDetected; // Set by the interpreter when it stopped at an idle loop
+
+    // Lazy VFP context switching, see ARM_DynCom::LoadContext
+    Core::ThreadContext* VFPContextOwner;         // Context the VFP registers currently belong to
+    const Core::ThreadContext* VFPContextPending; // Context to load the VFP registers from on first use
 
     unsigned NextInstr;
     unsigned VectorCatch;                   // Caught exception mask
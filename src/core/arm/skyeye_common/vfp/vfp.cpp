@@ -20,9 +20,12 @@
 
 /* Note: this file handles interface with arm core and vfp registers */
 
+#include <cstring>
+
 #include "common/common.h"
 #include "common/logging/log.h"
 
+#include "core/core.h"
 #include "core/arm/skyeye_common/armdefs.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -37,6 +40,28 @@ unsigned VFPInit(ARMul_State* state)
     return 0;
 }
 
+/* Called on the first VFP instruction after a thread switch: saves the VFP registers to the
+   context they belong to and loads the ones of the running thread */
+void VFPLoadPendingContext(ARMul_State* state)
+{
+    Core::ThreadContext* owner = state->VFPContextOwner;
+    if (owner != nullptr)
+    {
+        memcpy(owner->fpu_registers, state->ExtReg, sizeof(owner->fpu_registers));
+        owner->fpscr = state->VFP[VFP_OFFSET(VFP_FPSCR)];
+        owner->fpexc = state->VFP[VFP_OFFSET(VFP_FPEXC)];
+    }
+
+    const Core::ThreadContext* pending = state->VFPContextPending;
+    memcpy(state->ExtReg, pending->fpu_registers, sizeof(pending->fpu_registers));
+    state->VFP[VFP_OFFSET(VFP_FPSCR)] = pending->fpscr;
+    state->VFP[VFP_OFFSET(VFP_FPEXC)] = pending->fpexc;
+
+    /* The registers now belong to the running thread, which becomes the owner once it's saved */
+    state->VFPContextOwner = nullptr;
+    state->VFPContextPending = nullptr;
+}
+
 unsigned VFPMRC(ARMul_State* state, unsigned type, u32 instr, u32* value)
 {
     /* MRC<c> <coproc>,<opc1>,<Rt>,<CRn>,<CRm>{,<opc2>} */
@@ -2,10 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <thread>
+
 #include "common/common_types.h"
+#include "common/thread.h"
 
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/savestate.h"
 
 #include "core/settings.h"
 #include "core/arm/arm_interface.h"
@@ -20,12 +24,89 @@ namespace Core {
 ARM_Interface*     g_app_core = nullptr;  ///< ARM11 application core
 ARM_Interface*     g_sys_core = nullptr;  ///< ARM11 system (OS) core
 
+std::recursive_mutex g_kernel_lock;
+
+/// Core emulated on the calling host thread. Only the system core thread changes this.
+static THREAD_LOCAL CoreId current_core_id = CORE_APP;
+
+bool g_multi_core = false;
+
+// Host thread emulating the system core in multi-core mode. It runs one slice each time
+// sys_core_start_event is set, and signals sys_core_done_event once the slice is done.
+static std::thread sys_core_thread;
+static Common::Event sys_core_start_event;
+static Common::Event sys_core_done_event;
+static int sys_core_slice_length = 0;
+static bool sys_core_stop = false;
+
+CoreId GetCurrentCoreIdSlow() {
+    return current_core_id;
+}
+
+/// Runs one slice of the system core, switching threads before and after as needed
+static void RunSysCoreSlice(int tight_loop) {
+    bool is_runnable;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_kernel_lock);
+        if (Kernel::IsRescheduleNeeded())
+            Kernel::Reschedule();
+
+        const Kernel::Thread* thread = Kernel::GetCurrentThread();
+        is_runnable = thread != nullptr && thread->status == THREADSTATUS_RUNNING;
+    }
+
+    // The system core has no idle thread, it simply sits out the slice if there's nothing to run
+    if (is_runnable)
+        g_sys_core->Run(tight_loop);
+
+    std::lock_guard<std::recursive_mutex> lock(g_kernel_lock);
+    if (Kernel::IsRescheduleNeeded())
+        Kernel::Reschedule();
+}
+
+static void SysCoreThreadFunc() {
+    Common::SetCurrentThreadName("SysCore");
+    current_core_id = CORE_SYS;
+
+    while (true) {
+        sys_core_start_event.Wait();
+        if (sys_core_stop)
+            break;
+
+        RunSysCoreSlice(sys_core_slice_length);
+        sys_core_done_event.Set();
+    }
+}
+
 /// Run the core CPU loop
 void RunLoop(int tight_loop) {
+    // Savestates are taken between slices, while neither core is running
+    SaveState::ProcessRequests();
+
+    // Let the system core run the same slice concurrently, unless it has nothing to do anyway
+    bool run_sys_core = false;
+    if (g_multi_core) {
+        std::lock_guard<std::recursive_mutex> lock(g_kernel_lock);
+        run_sys_core = Kernel::HasRunnableThread(CORE_SYS);
+        if (run_sys_core) {
+            CoreTiming::StartSecondarySlice(g_sys_core);
+            sys_core_slice_length = tight_loop;
+            sys_core_start_event.Set();
+        }
+    }
+
+    // The system core may be switching threads meanwhile, which touches the same kernel state
+    bool is_idle;
+    {
+        KernelLock lock;
+        is_idle = Kernel::GetCurrentThread()->IsIdle();
+    }
+
     // If the current thread is an idle thread, then don't execute instructions,
     // instead advance to the next event and try to yield to the next thread
-    if (Kernel::GetCurrentThread()->IsIdle()) {
+    if (is_idle) {
         LOG_TRACE(Core_ARM11, "Idling");
+        // Idle and Advance take the kernel lock themselves, Advance releases it before pacing
         CoreTiming::Idle();
         CoreTiming::Advance();
         HLE::Reschedule(__func__);
@@ -33,8 +114,16 @@ void RunLoop(int tight_loop) {
         g_app_core->Run(tight_loop);
     }
 
+    // Both cores must have finished the slice before hardware and the scheduler are updated
+    if (run_sys_core)
+        sys_core_done_event.Wait();
+
+    KernelLock lock;
     HW::Update();
-    if (HLE::g_reschedule) {
+
+    // The system core clears g_reschedule whenever it switches threads itself, so in multi-core
+    // mode the application core has to check for itself
+    if (g_multi_core ? Kernel::IsRescheduleNeeded() : HLE::g_reschedule.load()) {
         Kernel::Reschedule();
     }
 }
@@ -59,11 +148,24 @@ int Init() {
     g_sys_core = new ARM_DynCom(USER32MODE);
     g_app_core = new ARM_DynCom(USER32MODE);
 
+    g_multi_core = Settings::values.use_multi_core;
+    if (g_multi_core) {
+        sys_core_stop = false;
+        sys_core_thread = std::thread(SysCoreThreadFunc);
+    }
+
     LOG_DEBUG(Core, "Initialized OK");
     return 0;
 }
 
 void Shutdown() {
+    if (sys_core_thread.joinable()) {
+        sys_core_stop = true;
+        sys_core_start_event.Set();
+        sys_core_thread.join();
+    }
+    g_multi_core = false;
+
     delete g_app_core;
     delete g_sys_core;
 
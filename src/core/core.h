@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "common/common_types.h"
 
 class ARM_Interface;
@@ -29,6 +31,67 @@ struct ThreadContext {
 extern ARM_Interface*   g_app_core;     ///< ARM11 application core
 extern ARM_Interface*   g_sys_core;     ///< ARM11 system (OS) core
 
+/// Emulated ARM11 cores
+enum CoreId {
+    CORE_APP,   ///< Application core, which also drives CoreTiming
+    CORE_SYS,   ///< System core, only used in multi-core mode
+    NUM_CORES
+};
+
+/**
+ * Serializes access to the state shared by both cores (kernel, HLE services, CoreTiming and
+ * hardware) when they run on separate host threads. Held by SVCs, event processing and hardware
+ * register accesses, through KernelLock.
+ */
+extern std::recursive_mutex g_kernel_lock;
+
+/// Whether the system core is emulated on its own host thread. Only changed by Init.
+extern bool g_multi_core;
+
+/// Returns whether the system core is emulated on its own host thread
+inline bool IsMultiCore() {
+    return g_multi_core;
+}
+
+/// Returns the ID of the core emulated on the calling host thread, looked up in thread-local storage
+CoreId GetCurrentCoreIdSlow();
+
+/**
+ * Returns the ID of the core emulated on the calling host thread. In single-core mode, everything
+ * runs on the application core, so this doesn't need to look at thread-local storage.
+ */
+inline CoreId GetCurrentCoreId() {
+    return g_multi_core ? GetCurrentCoreIdSlow() : CORE_APP;
+}
+
+/// Returns the core emulated on the calling host thread
+inline ARM_Interface* GetCurrentCore() {
+    return GetCurrentCoreId() == CORE_SYS ? g_sys_core : g_app_core;
+}
+
+/**
+ * Holds g_kernel_lock for the lifetime of the object in multi-core mode. In single-core mode,
+ * there's nothing to serialize against, so the lock isn't touched at all.
+ */
+class KernelLock {
+public:
+    KernelLock() : locked(g_multi_core) {
+        if (locked)
+            g_kernel_lock.lock();
+    }
+
+    ~KernelLock() {
+        if (locked)
+            g_kernel_lock.unlock();
+    }
+
+private:
+    KernelLock(const KernelLock&);
+    KernelLock& operator=(const KernelLock&);
+
+    bool locked;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /// Start the core
@@ -41,6 +104,8 @@ void Start();
  * required to do a full dispatch with each instruction. NOTE: the number of instructions requested
  * is not guaranteed to run, as this will be interrupted preemptively if a hardware update is
  * requested (e.g. on a thread switch).
+ * In multi-core mode, the system core runs the same number of instructions on its own host thread
+ * at the same time, and both cores are synchronized before hardware is updated.
  */
 void RunLoop(int tight_loop=1000);
 
@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -35,25 +37,76 @@ struct EventType
 
 static std::vector<EventType> event_types;
 
-struct BaseEvent
+/**
+ * A pending event. Events are kept in a binary min-heap ordered by their time. Events scheduled
+ * for the same time fire in the order they were scheduled in.
+ */
+struct Event
 {
     s64 time;
+    u64 fifo_order; ///< Sequence number, used to break ties between events with the same time
     u64 userdata;
     int type;
+    u32 slot;       ///< Index of the handle slot referring to this event
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+/// Maps event handles to positions in the event queue
+struct EventSlot
+{
+    u32 queue_index;
+    u32 generation; ///< Incremented whenever the slot is freed, invalidating stale handles
+};
+
+struct ThreadsafeEventPool;
+
+/// An event scheduled from outside the CPU thread, waiting to be moved into the event queue
+struct ThreadsafeEvent
+{
+    s64 time;
+    u64 userdata;
+    int type;
+
+    ThreadsafeEvent* next;
+    ThreadsafeEventPool* pool; ///< Pool of the thread which allocated the event
+};
+
+/**
+ * Unused threadsafe events of a single producer thread. Only the owning thread allocates from
+ * free_list. The CPU thread hands events back through the returned list, which the owner takes
+ * over as a whole once free_list runs dry, so neither side ever waits for the other.
+ */
+struct ThreadsafeEventPool
+{
+    ~ThreadsafeEventPool() {
+        FreeList(free_list);
+        FreeList(returned.exchange(nullptr));
+    }
+
+    static void FreeList(ThreadsafeEvent* event) {
+        while (event != nullptr) {
+            ThreadsafeEvent* next = event->next;
+            delete event;
+            event = next;
+        }
+    }
+
+    ThreadsafeEvent* free_list = nullptr;
+    std::atomic<ThreadsafeEvent*> returned{nullptr};
+};
+
+/// Pending events, stored as a binary min-heap
+static std::vector<Event> event_queue;
+static std::vector<EventSlot> event_slots;
+static std::vector<u32> free_event_slots;
+static u64 event_fifo_counter;
 
-static Event* first;
-static Event* ts_first;
-static Event* ts_last;
+/// Events scheduled from outside threads, as a lock-free stack in reverse scheduling order
+static std::atomic<ThreadsafeEvent*> ts_queue(nullptr);
 
-// event pools
-static Event* event_pool = nullptr;
-static Event* event_ts_pool = nullptr;
-static int allocated_ts_events = 0;
-// Optimization to skip MoveEvents when possible.
-static std::atomic<bool> has_ts_events(false);
+/// Pools of all threads which ever scheduled a threadsafe event. Pools outlive their thread.
+static std::vector<std::unique_ptr<ThreadsafeEventPool>> ts_event_pools;
+static std::mutex ts_event_pools_mutex;
+static THREAD_LOCAL ThreadsafeEventPool* ts_event_pool = nullptr;
 
 int g_slice_length;
 
@@ -62,7 +115,8 @@ static s64 idled_cycles;
 static s64 last_global_time_ticks;
 static s64 last_global_time_us;
 
-static std::recursive_mutex external_event_section;
+/// Time at which the current slice of the secondary core started, see StartSecondarySlice
+static u64 secondary_slice_start;
 
 // Warning: not included in save state.
 using AdvanceCallback = void(int cycles_executed);
@@ -97,35 +151,113 @@ u64 GetGlobalTimeUs() {
     return last_global_time_us + us_since_last;
 }
 
-static Event* GetNewEvent() {
-    if (!event_pool)
-        return new Event;
+static bool EventBefore(const Event& a, const Event& b) {
+    return a.time < b.time || (a.time == b.time && a.fifo_order < b.fifo_order);
+}
 
-    Event* event = event_pool;
-    event_pool = event->next;
-    return event;
+static EventHandle MakeEventHandle(u32 slot) {
+    return (static_cast<u64>(event_slots[slot].generation) << 32) | slot;
 }
 
-static Event* GetNewTsEvent() {
-    allocated_ts_events++;
+static u32 AllocateEventSlot() {
+    if (free_event_slots.empty()) {
+        event_slots.push_back({ 0, 1 });
+        return static_cast<u32>(event_slots.size() - 1);
+    }
 
-    if (!event_ts_pool)
-        return new Event;
+    u32 slot = free_event_slots.back();
+    free_event_slots.pop_back();
+    return slot;
+}
 
-    Event* event = event_ts_pool;
-    event_ts_pool = event->next;
-    return event;
+static void FreeEventSlot(u32 slot) {
+    // Skip generation 0 so that valid handles never equal INVALID_EVENT_HANDLE
+    if (++event_slots[slot].generation == 0)
+        event_slots[slot].generation = 1;
+    free_event_slots.push_back(slot);
+}
+
+/// Stores an event at the given position of the queue, keeping its handle slot up to date
+static void SetQueueEntry(size_t index, const Event& event) {
+    event_queue[index] = event;
+    event_slots[event.slot].queue_index = static_cast<u32>(index);
+}
+
+static void SiftUp(size_t index) {
+    const Event event = event_queue[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!EventBefore(event, event_queue[parent]))
+            break;
+
+        SetQueueEntry(index, event_queue[parent]);
+        index = parent;
+    }
+    SetQueueEntry(index, event);
+}
+
+static void SiftDown(size_t index) {
+    const Event event = event_queue[index];
+    const size_t size = event_queue.size();
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= size)
+            break;
+
+        if (child + 1 < size && EventBefore(event_queue[child + 1], event_queue[child]))
+            ++child;
+        if (!EventBefore(event_queue[child], event))
+            break;
+
+        SetQueueEntry(index, event_queue[child]);
+        index = child;
+    }
+    SetQueueEntry(index, event);
 }
 
-static void FreeEvent(Event* event) {
-    event->next = event_pool;
-    event_pool = event;
+static EventHandle AddEventToQueue(s64 time, int event_type, u64 userdata) {
+    const u32 slot = AllocateEventSlot();
+    event_queue.push_back({ time, event_fifo_counter++, userdata, event_type, slot });
+    SiftUp(event_queue.size() - 1);
+    return MakeEventHandle(slot);
 }
 
-static void FreeTsEvent(Event* event) {
-    event->next = event_ts_pool;
-    event_ts_pool = event;
-    allocated_ts_events--;
+/// Removes the event at the given position from the queue and invalidates its handle
+static void RemoveQueueEntry(size_t index) {
+    FreeEventSlot(event_queue[index].slot);
+
+    const Event last = event_queue.back();
+    event_queue.pop_back();
+    if (index == event_queue.size())
+        return;
+
+    SetQueueEntry(index, last);
+    if (index > 0 && EventBefore(last, event_queue[(index - 1) / 2]))
+        SiftUp(index);
+    else
+        SiftDown(index);
+}
+
+/// Removes all events matching the given predicate from the queue. This takes O(n) time.
+template <typename Predicate>
+static void RemoveQueueEntriesIf(Predicate pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < event_queue.size(); ++i) {
+        if (pred(event_queue[i]))
+            FreeEventSlot(event_queue[i].slot);
+        else
+            event_queue[kept++] = event_queue[i];
+    }
+
+    if (kept == event_queue.size())
+        return;
+
+    // Restore the heap property bottom-up
+    event_queue.resize(kept);
+    for (size_t i = 0; i < event_queue.size(); ++i)
+        event_slots[event_queue[i].slot].queue_index = static_cast<u32>(i);
+    for (size_t i = event_queue.size() / 2; i-- > 0;)
+        SiftDown(i);
 }
 
 int RegisterEvent(const char* name, TimedCallback callback) {
@@ -146,7 +278,7 @@ void RestoreRegisterEvent(int event_type, const char* name, TimedCallback callba
 }
 
 void UnregisterAllEvents() {
-    if (first)
+    if (!event_queue.empty())
         PanicAlert("Cannot unregister events with events pending");
     event_types.clear();
 }
@@ -155,10 +287,11 @@ void Init() {
     Core::g_app_core->down_count = INITIAL_SLICE_LENGTH;
     g_slice_length = INITIAL_SLICE_LENGTH;
     global_timer = 0;
+    secondary_slice_start = 0;
     idled_cycles = 0;
     last_global_time_ticks = 0;
     last_global_time_us = 0;
-    has_ts_events = 0;
+    event_fifo_counter = 0;
     mhz_change_callbacks.clear();
 }
 
@@ -167,22 +300,21 @@ void Shutdown() {
     ClearPendingEvents();
     UnregisterAllEvents();
 
-    while (event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        delete event;
-    }
-
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    while (event_ts_pool) {
-        Event* event = event_ts_pool;
-        event_ts_pool = event->next;
-        delete event;
-    }
+    event_slots.clear();
+    free_event_slots.clear();
 }
 
 u64 GetTicks() {
-    return (u64)global_timer + g_slice_length - Core::g_app_core->down_count;
+    const ARM_Interface* core = Core::GetCurrentCore();
+    if (core != Core::g_app_core)
+        return secondary_slice_start - core->down_count;
+
+    return (u64)global_timer + g_slice_length - core->down_count;
+}
+
+void StartSecondarySlice(ARM_Interface* core) {
+    secondary_slice_start = GetTicks();
+    core->down_count = 0;
 }
 
 u64 GetIdleTicks() {
@@ -190,22 +322,87 @@ u64 GetIdleTicks() {
 }
 
 
+static ThreadsafeEvent* AllocateThreadsafeEvent() {
+    // Registering the pool is the only time a producer has to lock anything
+    if (ts_event_pool == nullptr) {
+        std::unique_ptr<ThreadsafeEventPool> pool(new ThreadsafeEventPool);
+        ts_event_pool = pool.get();
+
+        std::lock_guard<std::mutex> lock(ts_event_pools_mutex);
+        ts_event_pools.push_back(std::move(pool));
+    }
+
+    ThreadsafeEventPool& pool = *ts_event_pool;
+    if (pool.free_list == nullptr)
+        pool.free_list = pool.returned.exchange(nullptr, std::memory_order_acquire);
+
+    ThreadsafeEvent* event = pool.free_list;
+    if (event == nullptr) {
+        event = new ThreadsafeEvent;
+        event->pool = &pool;
+    } else {
+        pool.free_list = event->next;
+    }
+    return event;
+}
+
+/// Hands an event back to the pool it was allocated from. Only called on the CPU thread.
+static void FreeThreadsafeEvent(ThreadsafeEvent* event) {
+    std::atomic<ThreadsafeEvent*>& returned = event->pool->returned;
+    event->next = returned.load(std::memory_order_relaxed);
+    while (!returned.compare_exchange_weak(event->next, event, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+}
+
+/// Takes all pending threadsafe events off the queue, in the order they were scheduled in.
+static ThreadsafeEvent* TakeThreadsafeEvents() {
+    ThreadsafeEvent* event = ts_queue.exchange(nullptr, std::memory_order_acquire);
+
+    ThreadsafeEvent* ordered = nullptr;
+    while (event != nullptr) {
+        ThreadsafeEvent* next = event->next;
+        event->next = ordered;
+        ordered = event;
+        event = next;
+    }
+    return ordered;
+}
+
+/**
+ * Moves all pending threadsafe events into the event queue, except for those matching the given
+ * predicate, which are dropped instead.
+ * @return The number of ticks until the last dropped event would have fired, or 0
+ */
+template <typename Predicate>
+static s64 MoveThreadsafeEventsExcept(Predicate drop) {
+    s64 result = 0;
+    ThreadsafeEvent* event = TakeThreadsafeEvents();
+    while (event != nullptr) {
+        ThreadsafeEvent* next = event->next;
+        if (drop(*event))
+            result = event->time - GetTicks();
+        else
+            AddEventToQueue(event->time, event->type, event->userdata);
+
+        FreeThreadsafeEvent(event);
+        event = next;
+    }
+    return result;
+}
+
 // This is to be called when outside threads, such as the graphics thread, wants to
-// schedule things to be executed on the main thread.
+// schedule things to be executed on the main thread. It never blocks.
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    Event* new_event = GetNewTsEvent();
-    new_event->time = GetTicks() + cycles_into_future;
-    new_event->type = event_type;
-    new_event->next = 0;
-    new_event->userdata = userdata;
-    if (!ts_first)
-        ts_first = new_event;
-    if (ts_last)
-        ts_last->next = new_event;
-    ts_last = new_event;
-
-    has_ts_events = true;
+    ThreadsafeEvent* event = AllocateThreadsafeEvent();
+    event->time = (s64)GetTicks() + cycles_into_future;
+    event->userdata = userdata;
+    event->type = event_type;
+
+    event->next = ts_queue.load(std::memory_order_relaxed);
+    while (!ts_queue.compare_exchange_weak(event->next, event, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
 }
 
 // Same as ScheduleEvent_Threadsafe(0, ...) EXCEPT if we are already on the CPU thread
@@ -213,7 +410,6 @@ void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userda
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
     if (false) //Core::IsCPUThread())
     {
-        std::lock_guard<std::recursive_mutex> lock(external_event_section);
         event_types[event_type].callback(userdata, 0);
     }
     else
@@ -221,117 +417,45 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
 }
 
 void ClearPendingEvents() {
-    while (first) {
-        Event* event = first->next;
-        FreeEvent(first);
-        first = event;
-    }
-}
-
-static void AddEventToQueue(Event* new_event) {
-    Event* prev_event = nullptr;
-    Event** next_event = &first;
-    for (;;) {
-        Event*& next = *next_event;
-        if (!next || new_event->time < next->time) {
-            new_event->next = next;
-            next = new_event;
-            break;
-        }
-        prev_event = next;
-        next_event = &prev_event->next;
-    }
+    for (const Event& event : event_queue)
+        FreeEventSlot(event.slot);
+    event_queue.clear();
 }
 
-void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata) {
-    Event* new_event = GetNewEvent();
-    new_event->userdata = userdata;
-    new_event->type = event_type;
-    new_event->time = GetTicks() + cycles_into_future;
-    AddEventToQueue(new_event);
+EventHandle ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata) {
+    return AddEventToQueue(GetTicks() + cycles_into_future, event_type, userdata);
 }
 
 s64 UnscheduleEvent(int event_type, u64 userdata) {
     s64 result = 0;
-    if (!first)
-        return result;
-    while (first) {
-        if (first->type == event_type && first->userdata == userdata) {
-            result = first->time - GetTicks();
-
-            Event* next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return result;
-
-    Event* prev_event = first;
-    Event* ptr = prev_event->next;
-
-    while (ptr) {
-        if (ptr->type == event_type && ptr->userdata == userdata) {
-            result = ptr->time - GetTicks();
-
-            prev_event->next = ptr->next;
-            FreeEvent(ptr);
-            ptr = prev_event->next;
-        } else {
-            prev_event = ptr;
-            ptr = ptr->next;
-        }
-    }
+    RemoveQueueEntriesIf([&](const Event& event) {
+        if (event.type != event_type || event.userdata != userdata)
+            return false;
 
+        result = event.time - GetTicks();
+        return true;
+    });
     return result;
 }
 
-s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata) {
-    s64 result = 0;
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return result;
-
-    while (ts_first) {
-        if (ts_first->type == event_type && ts_first->userdata == userdata) {
-            result = ts_first->time - GetTicks();
-
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first)
-    {
-        ts_last = nullptr;
-        return result;
-    }
-
-    Event* prev_event = ts_first;
-    Event* next = prev_event->next;
-    while (next) {
-        if (next->type == event_type && next->userdata == userdata) {
-            result = next->time - GetTicks();
-
-            prev_event->next = next->next;
-            if (next == ts_last)
-                ts_last = prev_event;
-            FreeTsEvent(next);
-            next = prev_event->next;
-        } else {
-            prev_event = next;
-            next = next->next;
-        }
-    }
+s64 CancelEvent(EventHandle handle) {
+    const u32 slot = static_cast<u32>(handle);
+    const u32 generation = static_cast<u32>(handle >> 32);
+    if (slot >= event_slots.size() || event_slots[slot].generation != generation)
+        return 0;
 
+    const size_t index = event_slots[slot].queue_index;
+    const s64 result = event_queue[index].time - GetTicks();
+    RemoveQueueEntry(index);
     return result;
 }
 
+s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata) {
+    return MoveThreadsafeEventsExcept([&](const ThreadsafeEvent& event) {
+        return event.type == event_type && event.userdata == userdata;
+    });
+}
+
 // Warning: not included in save state.
 void RegisterAdvanceCallback(AdvanceCallback* callback) {
     advance_callback = callback;
@@ -342,79 +466,16 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 }
 
 bool IsScheduled(int event_type) {
-    if (!first)
-        return false;
-    Event* event = first;
-    while (event) {
-        if (event->type == event_type)
-            return true;
-        event = event->next;
-    }
-    return false;
+    return std::any_of(event_queue.begin(), event_queue.end(),
+                       [event_type](const Event& event) { return event.type == event_type; });
 }
 
 void RemoveEvent(int event_type) {
-    if (!first)
-        return;
-    while (first) {
-        if (first->type == event_type) {
-            Event *next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return;
-    Event* prev = first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            FreeEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
-    }
+    RemoveQueueEntriesIf([event_type](const Event& event) { return event.type == event_type; });
 }
 
 void RemoveThreadsafeEvent(int event_type) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return;
-
-    while (ts_first) {
-        if (ts_first->type == event_type) {
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first) {
-        ts_last = nullptr;
-        return;
-    }
-
-    Event* prev = ts_first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            if (next == ts_last)
-                ts_last = prev;
-            FreeTsEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
-    }
+    MoveThreadsafeEventsExcept([event_type](const ThreadsafeEvent& event) { return event.type == event_type; });
 }
 
 void RemoveAllEvents(int event_type) {
@@ -424,38 +485,16 @@ void RemoveAllEvents(int event_type) {
 
 // This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents() {
-    while (first) {
-        if (first->time <= (s64)GetTicks()) {
-            Event* evt = first;
-            first = first->next;
-            event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-            FreeEvent(evt);
-        } else {
-            break;
-        }
+    while (!event_queue.empty() && event_queue.front().time <= (s64)GetTicks()) {
+        const Event event = event_queue.front();
+        RemoveQueueEntry(0);
+        event_types[event.type].callback(event.userdata, (int)(GetTicks() - event.time));
     }
 }
 
 void MoveEvents() {
-    has_ts_events = false;
-
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
     // Move events from async queue into main queue
-    while (ts_first) {
-        Event* next = ts_first->next;
-        AddEventToQueue(ts_first);
-        ts_first = next;
-    }
-    ts_last = nullptr;
-
-    // Move free events to threadsafe pool
-    while (allocated_ts_events > 0 && event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        event->next = event_ts_pool;
-        event_ts_pool = event;
-        allocated_ts_events--;
-    }
+    MoveThreadsafeEventsExcept([](const ThreadsafeEvent&) { return false; });
 }
 
 void ForceCheck() {
@@ -467,23 +506,25 @@ void ForceCheck() {
     g_slice_length = 0;
 }
 
-void Advance() {
+/// Advances the timer and processes due events, returning the cycles executed since the last call
+static s64 AdvanceLocked() {
     s64 cycles_executed = g_slice_length - Core::g_app_core->down_count;
     global_timer += cycles_executed;
     Core::g_app_core->down_count = g_slice_length;
 
-    if (has_ts_events)
+    // Optimization to skip MoveEvents when possible
+    if (ts_queue.load(std::memory_order_relaxed) != nullptr)
         MoveEvents();
     ProcessFifoWaitEvents();
 
-    if (!first) {
+    if (event_queue.empty()) {
         if (g_slice_length < 10000) {
             g_slice_length += 10000;
             Core::g_app_core->down_count += g_slice_length;
         }
     } else {
         // Note that events can eat cycles as well.
-        int target = (int)(first->time - global_timer);
+        int target = (int)(event_queue.front().time - global_timer);
         if (target > MAX_SLICE_LENGTH)
             target = MAX_SLICE_LENGTH;
 
@@ -491,26 +532,36 @@ void Advance() {
         g_slice_length += diff;
         Core::g_app_core->down_count += diff;
     }
+
+    return cycles_executed;
+}
+
+void Advance() {
+    s64 cycles_executed;
+    {
+        Core::KernelLock lock;
+        cycles_executed = AdvanceLocked();
+    }
+
+    // The callback may sleep to pace emulation, which mustn't block the other core or hardware
     if (advance_callback)
         advance_callback(cycles_executed);
 }
 
 void LogPendingEvents() {
-    Event* event = first;
-    while (event) {
-        //LOG_TRACE(Core_Timing, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, next->time, next->type);
-        event = event->next;
-    }
+    LOG_DEBUG(Core_Timing, "%s", GetScheduledEventsSummary().c_str());
 }
 
 void Idle(int max_idle) {
+    Core::KernelLock lock;
+
     s64 cycles_down = Core::g_app_core->down_count;
     if (max_idle != 0 && cycles_down > max_idle)
         cycles_down = max_idle;
 
-    if (first && cycles_down > 0) {
+    if (!event_queue.empty() && cycles_down > 0) {
         s64 cycles_executed = g_slice_length - Core::g_app_core->down_count;
-        s64 cycles_next_event = first->time - global_timer;
+        s64 cycles_next_event = event_queue.front().time - global_timer;
 
         if (cycles_next_event < cycles_executed + cycles_down) {
             cycles_down = cycles_next_event - cycles_executed;
@@ -529,21 +580,73 @@ void Idle(int max_idle) {
 }
 
 std::string GetScheduledEventsSummary() {
-    Event* event = first;
+    // The queue is only partially ordered, so sort a copy to list events in firing order
+    std::vector<Event> events(event_queue);
+    std::sort(events.begin(), events.end(), EventBefore);
+
     std::string text = "Scheduled events\n";
     text.reserve(1000);
-    while (event) {
-        unsigned int t = event->type;
+    for (const Event& event : events) {
+        unsigned int t = event.type;
         if (t >= event_types.size())
             PanicAlert("Invalid event type"); // %i", t);
-        const char* name = event_types[event->type].name;
+        const char* name = event_types[event.type].name;
         if (!name)
             name = "[unknown]";
-        text += Common::StringFromFormat("%s : %i %08x%08x\n", name, (int)event->time, 
-                (u32)(event->userdata >> 32), (u32)(event->userdata));
-        event = event->next;
+        text += Common::StringFromFormat("%s : %i %08x%08x\n", name, (int)event.time, 
+                (u32)(event.userdata >> 32), (u32)(event.userdata));
     }
     return text;
 }
 
+void DoState(PointerWrap& p) {
+    if (p.GetMode() == PointerWrap::MODE_READ)
+        MoveThreadsafeEventsExcept([](const ThreadsafeEvent&) { return true; });
+    else
+        MoveEvents();
+
+    std::vector<std::string> type_names;
+    for (const EventType& type : event_types)
+        type_names.push_back(type.name != nullptr ? type.name : "");
+    p.Do(type_names);
+
+    p.Do(event_queue);
+    p.Do(event_slots);
+    p.Do(free_event_slots);
+    p.Do(event_fifo_counter);
+
+    p.Do(g_slice_length);
+    p.Do(global_timer);
+    p.Do(idled_cycles);
+    p.Do(last_global_time_ticks);
+    p.Do(last_global_time_us);
+    p.Do(secondary_slice_start);
+
+    const int clock_rate = g_clock_rate_arm11;
+    p.Do(g_clock_rate_arm11);
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        return;
+
+    // The saved event types might have been registered in a different order
+    for (Event& event : event_queue) {
+        auto itr = event_types.end();
+        if (event.type >= 0 && event.type < (int)type_names.size()) {
+            const std::string& name = type_names[event.type];
+            itr = std::find_if(event_types.begin(), event_types.end(), [&](const EventType& type) {
+                return type.name != nullptr && name == type.name;
+            });
+        }
+        if (itr == event_types.end()) {
+            LOG_ERROR(Core_Timing, "Savestate contains an event of unknown type %d", event.type);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        event.type = static_cast<int>(itr - event_types.begin());
+    }
+
+    if (clock_rate != g_clock_rate_arm11)
+        FireMhzChange();
+}
+
 } // namespace
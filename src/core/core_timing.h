@@ -23,6 +23,9 @@
 
 #include "common/common.h"
 
+class ARM_Interface;
+class PointerWrap;
+
 extern int g_clock_rate_arm11;
 
 inline s64 msToCycles(int ms) {
@@ -69,10 +72,22 @@ void Shutdown();
 typedef void(*MHzChangeCallback)();
 typedef std::function<void(u64 userdata, int cycles_late)> TimedCallback;
 
+/// Identifies a single scheduled event, see ScheduleEvent and CancelEvent
+typedef u64 EventHandle;
+static const EventHandle INVALID_EVENT_HANDLE = 0;
+
 u64 GetTicks();
 u64 GetIdleTicks();
 u64 GetGlobalTimeUs();
 
+/**
+ * Starts a slice of a core which doesn't drive the event queue itself, i.e. the system core in
+ * multi-core mode. Until the next call, GetTicks() on that core returns the current time plus the
+ * cycles it has executed since.
+ * @param core Core which is about to run a slice
+ */
+void StartSecondarySlice(ARM_Interface* core);
+
 /**
  * Registers an event type with the specified name and callback
  * @param name Name of the event type
@@ -89,24 +104,43 @@ void UnregisterAllEvents();
 /**
  * Schedules an event to run after the specified number of cycles, 
  * with an optional parameter to be passed to the callback handler.
+ * Events scheduled for the same cycle fire in the order they were scheduled in.
  * This must be run ONLY from within the cpu thread.
  * @param cycles_into_future The number of cycles after which this event will be fired
  * @param event_type The event type to fire, as returned from RegisterEvent
  * @param userdata Optional parameter to pass to the callback when fired
+ * @returns A handle which can be used to cancel this particular event in O(log n) time
  */
-void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata = 0);
+EventHandle ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata = 0);
 
+/**
+ * Schedules an event from any host thread without blocking. The event is moved into the event
+ * queue by the CPU thread on its next Advance().
+ */
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata = 0);
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
 
 /**
- * Unschedules an event with the specified type and userdata
+ * Unschedules an event with the specified type and userdata. This needs to scan all pending
+ * events, so prefer CancelEvent where possible.
  * @param event_type The type of event to unschedule, as returned from RegisterEvent
  * @param userdata The userdata that identifies this event, as passed to ScheduleEvent
  * @returns The remaining ticks until the next invocation of the event callback
  */
 s64 UnscheduleEvent(int event_type, u64 userdata);
 
+/**
+ * Unschedules the event identified by the given handle
+ * @param handle Handle of the event as returned from ScheduleEvent. Handles of events which
+ *               already fired or have been cancelled are ignored.
+ * @returns The remaining ticks until the event would have fired, or 0 if it wasn't pending
+ */
+s64 CancelEvent(EventHandle handle);
+
+/**
+ * Removes pending threadsafe events, moving all others into the event queue right away. Like the
+ * other functions operating on the event queue, these may only be called on the CPU thread.
+ */
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata);
 
 void RemoveEvent(int event_type);
@@ -133,6 +167,13 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback);
 
 std::string GetScheduledEventsSummary();
 
+/**
+ * Saves or loads the pending events and the timing state, for savestates. Event types are stored
+ * by name, so all event types used by the saved events must have been registered before loading.
+ * Pending threadsafe events are moved into the queue when saving and discarded when loading.
+ */
+void DoState(PointerWrap& p);
+
 void SetClockFrequencyMHz(int cpu_mhz);
 int GetClockFrequencyMHz();
 extern int g_slice_length;
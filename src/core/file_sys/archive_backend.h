@@ -168,6 +168,16 @@ public:
         }
     }
 
+    void DoState(PointerWrap& p) {
+        p.Do(type);
+        p.Do(binary);
+        p.Do(string);
+
+        std::vector<u16> u16_data(u16str.begin(), u16str.end());
+        p.Do(u16_data);
+        u16str.assign(u16_data.begin(), u16_data.end());
+    }
+
 private:
     LowPathType type;
     std::vector<u8> binary;
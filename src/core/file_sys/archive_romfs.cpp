@@ -15,12 +15,20 @@
 
 namespace FileSys {
 
-ArchiveFactory_RomFS::ArchiveFactory_RomFS(const Loader::AppLoader& app_loader)
-        : romfs_data(std::make_shared<std::vector<u8>>()) {
-    // Load the RomFS from the app
-    if (Loader::ResultStatus::Success != app_loader.ReadRomFS(*romfs_data)) {
+ArchiveFactory_RomFS::ArchiveFactory_RomFS(const Loader::AppLoader& app_loader) {
+    // Map the RomFS of the app, so that boot doesn't have to wait for all of it to be read
+    std::unique_ptr<FileUtil::MappedFileView> view(new FileUtil::MappedFileView);
+    if (Loader::ResultStatus::Success == app_loader.MapRomFS(*view)) {
+        romfs_data = std::make_shared<IVFCData>(std::move(view));
+        return;
+    }
+
+    // Fall back to loading the whole RomFS, e.g. if it doesn't fit into the address space
+    std::vector<u8> buffer;
+    if (Loader::ResultStatus::Success != app_loader.ReadRomFS(buffer)) {
         LOG_ERROR(Service_FS, "Unable to read RomFS!");
     }
+    romfs_data = std::make_shared<IVFCData>(std::move(buffer));
 }
 
 ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_RomFS::Open(const Path& path) {
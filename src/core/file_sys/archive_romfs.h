@@ -27,7 +27,7 @@ public:
     ResultCode Format(const Path& path) override;
 
 private:
-    std::shared_ptr<std::vector<u8>> romfs_data;
+    std::shared_ptr<const IVFCData> romfs_data;
 };
 
 } // namespace FileSys
@@ -36,11 +36,19 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SaveDataCheck::Open(co
         return ResultCode(-1); // TODO(Subv): Find the right error code
     }
     auto size = file.GetSize();
-    auto raw_data = std::make_shared<std::vector<u8>>(size);
-    file.ReadBytes(raw_data->data(), size);
+    std::shared_ptr<IVFCData> ivfc_data;
+
+    std::unique_ptr<FileUtil::MappedFileView> view(new FileUtil::MappedFileView);
+    if (view->Map(file, 0, size)) {
+        ivfc_data = std::make_shared<IVFCData>(std::move(view));
+    } else {
+        std::vector<u8> raw_data(size);
+        file.ReadBytes(raw_data.data(), size);
+        ivfc_data = std::make_shared<IVFCData>(std::move(raw_data));
+    }
     file.Close();
 
-    auto archive = Common::make_unique<IVFCArchive>(std::move(raw_data));
+    auto archive = Common::make_unique<IVFCArchive>(std::move(ivfc_data));
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
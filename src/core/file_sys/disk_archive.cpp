@@ -101,17 +101,18 @@ bool DiskFile::Open() {
     mode_string += "b";
 
     file = Common::make_unique<FileUtil::IOFile>(path, mode_string.c_str());
+    readahead = Common::make_unique<ReadaheadCache>(*file);
     return true;
 }
 
 size_t DiskFile::Read(const u64 offset, const u32 length, u8* buffer) const {
-    file->Seek(offset, SEEK_SET);
-    return file->ReadBytes(buffer, length);
+    return readahead->Read(offset, length, buffer);
 }
 
 size_t DiskFile::Write(const u64 offset, const u32 length, const u32 flush, const u8* buffer) const {
-    file->Seek(offset, SEEK_SET);
-    size_t written = file->WriteBytes(buffer, length);
+    // Writes bypass the stdio buffer as well, so that positional reads always see them
+    readahead->Invalidate();
+    size_t written = file->WriteAt(buffer, length, offset);
     if (flush)
         file->Flush();
     return written;
@@ -122,12 +123,14 @@ size_t DiskFile::GetSize() const {
 }
 
 bool DiskFile::SetSize(const u64 size) const {
+    readahead->Invalidate();
     file->Resize(size);
     file->Flush();
     return true;
 }
 
 bool DiskFile::Close() const {
+    readahead->Invalidate();
     return file->Close();
 }
 
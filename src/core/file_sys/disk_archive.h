@@ -8,6 +8,7 @@
 #include "common/file_util.h"
 
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/readahead_cache.h"
 #include "core/loader/loader.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -62,6 +63,7 @@ protected:
     std::string path;
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+    std::unique_ptr<ReadaheadCache> readahead; ///< Reads directly from the file, never buffered
 };
 
 class DiskDirectory : public DirectoryBackend {
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
 
 #include "common/common_types.h"
@@ -15,7 +16,7 @@
 
 namespace FileSys {
 
-IVFCArchive::IVFCArchive(std::shared_ptr<const std::vector<u8>> data) : data(data) {
+IVFCArchive::IVFCArchive(std::shared_ptr<const IVFCData> data) : data(data) {
 }
 
 std::string IVFCArchive::GetName() const {
@@ -65,8 +66,13 @@ std::unique_ptr<DirectoryBackend> IVFCArchive::OpenDirectory(const Path& path) c
 
 size_t IVFCFile::Read(const u64 offset, const u32 length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%llu, length=%d", offset, length);
-    memcpy(buffer, data->data() + offset, length);
-    return length;
+    if (offset >= data->GetSize())
+        return 0;
+
+    // Reading from a mapped image only pages in the range which is actually read
+    const size_t read_length = static_cast<size_t>(std::min<u64>(length, data->GetSize() - offset));
+    memcpy(buffer, data->GetPointer() + offset, read_length);
+    return read_length;
 }
 
 size_t IVFCFile::Write(const u64 offset, const u32 length, const u32 flush, const u8* buffer) const {
@@ -75,7 +81,7 @@ size_t IVFCFile::Write(const u64 offset, const u32 length, const u32 flush, cons
 }
 
 size_t IVFCFile::GetSize() const {
-    return sizeof(u8) * data->size();
+    return static_cast<size_t>(data->GetSize());
 }
 
 bool IVFCFile::SetSize(const u64 size) const {
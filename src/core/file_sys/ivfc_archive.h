@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "common/common_types.h"
+#include "common/file_util.h"
 
 #include "core/file_sys/archive_backend.h"
 #include "core/loader/loader.h"
@@ -17,6 +18,28 @@
 
 namespace FileSys {
 
+/**
+ * Read-only contents of an IVFC image. Preferably a memory-mapped view of the file containing the
+ * image, so that only the parts actually accessed are read, or otherwise a copy in memory.
+ */
+class IVFCData : NonCopyable {
+public:
+    explicit IVFCData(std::unique_ptr<FileUtil::MappedFileView> view)
+            : view(std::move(view)), pointer(this->view->GetData()), size(this->view->GetSize()) {}
+
+    explicit IVFCData(std::vector<u8> data)
+            : buffer(std::move(data)), pointer(buffer.data()), size(buffer.size()) {}
+
+    const u8* GetPointer() const { return pointer; }
+    u64 GetSize() const { return size; }
+
+private:
+    std::unique_ptr<FileUtil::MappedFileView> view;
+    std::vector<u8> buffer;
+    const u8* pointer;
+    u64 size;
+};
+
 /**
  * Helper which implements an interface to deal with IVFC images used in some archives
  * This should be subclassed by concrete archive types, which will provide the
@@ -24,7 +47,7 @@ namespace FileSys {
  */
 class IVFCArchive : public ArchiveBackend {
 public:
-    IVFCArchive(std::shared_ptr<const std::vector<u8>> data);
+    IVFCArchive(std::shared_ptr<const IVFCData> data);
 
     std::string GetName() const override;
 
@@ -38,12 +61,12 @@ public:
     std::unique_ptr<DirectoryBackend> OpenDirectory(const Path& path) const override;
 
 protected:
-    std::shared_ptr<const std::vector<u8>> data;
+    std::shared_ptr<const IVFCData> data;
 };
 
 class IVFCFile : public FileBackend {
 public:
-    IVFCFile(std::shared_ptr<const std::vector<u8>> data) : data(data) {}
+    IVFCFile(std::shared_ptr<const IVFCData> data) : data(data) {}
 
     bool Open() override { return true; }
     size_t Read(const u64 offset, const u32 length, u8* buffer) const override;
@@ -54,7 +77,7 @@ public:
     void Flush() const override { }
 
 private:
-    std::shared_ptr<const std::vector<u8>> data;
+    std::shared_ptr<const IVFCData> data;
 };
 
 class IVFCDirectory : public DirectoryBackend {
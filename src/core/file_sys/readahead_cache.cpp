@@ -0,0 +1,123 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "common/thread_pool.h"
+
+#include "core/file_sys/readahead_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+static std::mutex readahead_pool_mutex;
+static std::unique_ptr<Common::ThreadPool> readahead_pool;
+
+/// Returns the worker thread shared by all readahead caches, starting it on first use.
+static Common::ThreadPool& GetReadaheadPool() {
+    std::lock_guard<std::mutex> lock(readahead_pool_mutex);
+    if (readahead_pool == nullptr)
+        readahead_pool.reset(new Common::ThreadPool(1, "FS readahead"));
+    return *readahead_pool;
+}
+
+ReadaheadCache::~ReadaheadCache() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readahead_done.wait(lock, [this] { return !readahead_pending; });
+}
+
+size_t ReadaheadCache::Read(u64 offset, size_t length, u8* buffer) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Only wait for an in-flight readahead if it's going to deliver the requested data
+        if (readahead_pending && offset >= incoming_offset && offset < incoming_offset + incoming_size)
+            readahead_done.wait(lock, [this] { return !readahead_pending; });
+
+        if (!readahead_pending)
+            CollectReadahead(offset);
+    }
+
+    size_t bytes_read = 0;
+    if (offset >= cache_offset && offset < cache_offset + cache.size()) {
+        bytes_read = static_cast<size_t>(std::min<u64>(length, cache_offset + cache.size() - offset));
+        std::memcpy(buffer, &cache[static_cast<size_t>(offset - cache_offset)], bytes_read);
+    }
+
+    if (bytes_read < length)
+        bytes_read += file.ReadAt(buffer + bytes_read, length - bytes_read, offset + bytes_read);
+
+    sequential_reads = (offset == next_offset) ? sequential_reads + 1 : 0;
+    next_offset = offset + bytes_read;
+
+    // Nothing to read ahead if we hit the end of the file
+    if (sequential_reads < kSequentialReadThreshold || bytes_read != length)
+        return bytes_read;
+
+    // Keep at least half a readahead window of data ready in front of the reader
+    size_t window_size = length * 4;
+    if (window_size < kMinReadaheadSize)
+        window_size = kMinReadaheadSize;
+    else if (window_size > kMaxReadaheadSize)
+        window_size = kMaxReadaheadSize;
+
+    const u64 cache_end = cache_offset + cache.size();
+    const u64 ready_end = (next_offset >= cache_offset && next_offset < cache_end) ? cache_end : next_offset;
+    if (ready_end - next_offset >= window_size / 2)
+        return bytes_read;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!readahead_pending)
+        StartReadahead(ready_end, window_size);
+
+    return bytes_read;
+}
+
+void ReadaheadCache::Invalidate() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readahead_done.wait(lock, [this] { return !readahead_pending; });
+
+    incoming.clear();
+    cache.clear();
+    sequential_reads = 0;
+}
+
+void ReadaheadCache::CollectReadahead(u64 read_offset) {
+    if (incoming.empty())
+        return;
+
+    const u64 cache_end = cache_offset + cache.size();
+    if (incoming_offset == cache_end && read_offset >= cache_offset && read_offset <= cache_end) {
+        // The readahead continues the cached data: Drop what was consumed already and append to it
+        cache.erase(cache.begin(), cache.begin() + static_cast<size_t>(read_offset - cache_offset));
+        cache_offset = read_offset;
+        cache.insert(cache.end(), incoming.begin(), incoming.end());
+    } else {
+        cache.swap(incoming);
+        cache_offset = incoming_offset;
+    }
+    incoming.clear();
+}
+
+void ReadaheadCache::StartReadahead(u64 offset, size_t size) {
+    readahead_pending = true;
+    incoming_offset = offset;
+    incoming_size = size;
+
+    GetReadaheadPool().Push([this, offset, size] {
+        std::vector<u8> data(size);
+        data.resize(file.ReadAt(data.data(), size, offset));
+
+        // Notify while holding the lock, the cache may be destroyed as soon as it's released
+        std::lock_guard<std::mutex> lock(mutex);
+        incoming = std::move(data);
+        readahead_pending = false;
+        readahead_done.notify_all();
+    });
+}
+
+} // namespace FileSys
@@ -0,0 +1,77 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "common/common.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * Reads from a host file using positional reads, and detects sequential access patterns. Once a
+ * file is read sequentially, the data following the last read is read ahead asynchronously on a
+ * worker thread, so that streaming reads don't have to block on the host disk.
+ * All functions other than the destructor must be called from the same thread.
+ */
+class ReadaheadCache : NonCopyable {
+public:
+    explicit ReadaheadCache(FileUtil::IOFile& file) : file(file) {}
+
+    /// Waits for an in-flight readahead, since it still accesses the file.
+    ~ReadaheadCache();
+
+    /**
+     * Reads data from the file, serving as much as possible from data which was read ahead
+     * @param offset Offset in the file to read from
+     * @param length Number of bytes to read
+     * @param buffer Buffer to read into, e.g. directly into emulated memory
+     * @return Number of bytes read
+     */
+    size_t Read(u64 offset, size_t length, u8* buffer);
+
+    /// Drops all data which was read ahead. Has to be called before the file gets modified.
+    void Invalidate();
+
+private:
+    /// Number of consecutive reads after which a file is considered to be read sequentially
+    static const unsigned kSequentialReadThreshold = 2;
+    static const size_t kMinReadaheadSize = 64 * 1024;
+    static const size_t kMaxReadaheadSize = 1024 * 1024;
+
+    /**
+     * Moves the data of a finished readahead into the cache. Must be called with the mutex held.
+     * @param read_offset Offset of the upcoming read, cached data before it is dropped
+     */
+    void CollectReadahead(u64 read_offset);
+
+    /// Queues a readahead on the worker thread. Must be called with the mutex held.
+    void StartReadahead(u64 offset, size_t size);
+
+    FileUtil::IOFile& file;
+
+    // Only accessed from the owning thread
+    u64 next_offset = 0;           ///< Offset directly following the last read
+    unsigned sequential_reads = 0; ///< Number of consecutive reads which continued the previous one
+    u64 cache_offset = 0;
+    std::vector<u8> cache;         ///< Data read ahead which is ready to be consumed
+
+    // Shared with the worker thread
+    std::mutex mutex;
+    std::condition_variable readahead_done;
+    bool readahead_pending = false;
+    u64 incoming_offset = 0;
+    size_t incoming_size = 0;      ///< Number of bytes requested from the worker
+    std::vector<u8> incoming;      ///< Result of the last readahead, not yet moved into the cache
+};
+
+} // namespace FileSys
@@ -7,19 +7,20 @@
 #include "common/common_types.h"
 
 #include "core/arm/arm_interface.h"
+#include "core/core.h"
 #include "core/mem_map.h"
 #include "core/hle/hle.h"
 
 namespace HLE {
 
-#define PARAM(n)    Core::g_app_core->GetReg(n)
+#define PARAM(n)    Core::GetCurrentCore()->GetReg(n)
 
 /**
  * HLE a function return from the current ARM11 userland process
  * @param res Result to return
  */
 static inline void FuncReturn(u32 res) {
-    Core::g_app_core->SetReg(0, res);
+    Core::GetCurrentCore()->SetReg(0, res);
 }
 
 /**
@@ -28,8 +29,8 @@ static inline void FuncReturn(u32 res) {
  * @todo Verify that this function is correct
  */
 static inline void FuncReturn64(u64 res) {
-    Core::g_app_core->SetReg(0, (u32)(res & 0xFFFFFFFF));
-    Core::g_app_core->SetReg(1, (u32)((res >> 32) & 0xFFFFFFFF));
+    Core::GetCurrentCore()->SetReg(0, (u32)(res & 0xFFFFFFFF));
+    Core::GetCurrentCore()->SetReg(1, (u32)((res >> 32) & 0xFFFFFFFF));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,7 +43,7 @@ template<ResultCode func(u32, u32, u32, u32)> void Wrap() {
 template<ResultCode func(u32*, u32, u32, u32, u32, u32)> void Wrap(){
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(0), PARAM(1), PARAM(2), PARAM(3), PARAM(4)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
@@ -50,7 +51,7 @@ template<ResultCode func(s32*, u32*, s32, bool, s64)> void Wrap() {
     s32 param_1 = 0;
     s32 retval = func(&param_1, (Handle*)Memory::GetPointer(PARAM(1)), (s32)PARAM(2),
         (PARAM(3) != 0), (((s64)PARAM(4) << 32) | PARAM(0))).raw;
-    Core::g_app_core->SetReg(1, (u32)param_1);
+    Core::GetCurrentCore()->SetReg(1, (u32)param_1);
     FuncReturn(retval);
 }
 
@@ -61,7 +62,7 @@ template<ResultCode func(u32, u32, u32, u32, s64)> void Wrap() {
 template<ResultCode func(u32*)> void Wrap(){
     u32 param_1 = 0;
     u32 retval = func(&param_1).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
@@ -76,7 +77,7 @@ template<ResultCode func(void*, void*, u32)> void Wrap(){
 template<ResultCode func(s32*, u32)> void Wrap(){
     s32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
@@ -87,7 +88,7 @@ template<ResultCode func(u32, s32)> void Wrap() {
 template<ResultCode func(u32*, u32)> void Wrap(){
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
@@ -103,28 +104,28 @@ template<ResultCode func(s64*, u32, void*, s32)> void Wrap(){
 template<ResultCode func(u32*, const char*)> void Wrap() {
     u32 param_1 = 0;
     u32 retval = func(&param_1, Memory::GetCharPointer(PARAM(1))).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
 template<ResultCode func(u32*, s32, s32)> void Wrap() {
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1), PARAM(2)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
 template<ResultCode func(s32*, u32, s32)> void Wrap() {
     s32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1), PARAM(2)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
 template<ResultCode func(u32*, u32, u32, u32, u32)> void Wrap() {
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1), PARAM(2), PARAM(3), PARAM(4)).raw;
-    Core::g_app_core->SetReg(1, param_1);
+    Core::GetCurrentCore()->SetReg(1, param_1);
     FuncReturn(retval);
 }
 
@@ -2,12 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <unordered_map>
 #include <vector>
 
+#include "common/chunk_file.h"
+
 #include "core/arm/arm_interface.h"
 #include "core/mem_map.h"
 #include "core/hle/hle.h"
 #include "core/hle/config_mem.h"
+#include "core/hle/profiler.h"
 #include "core/hle/shared_page.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/service/service.h"
@@ -21,7 +26,65 @@ namespace HLE {
 
 static std::vector<ModuleDef> g_module_db;
 
-bool g_reschedule = false;  ///< If true, immediately reschedules the CPU to a new thread
+std::atomic<bool> g_reschedule(false);
+
+/// True if the SVC being executed requested a reschedule
+static std::atomic<bool> reschedule_requested(false);
+
+/// True while the respective core is executing an SVC. Only accessed by that core's host thread.
+static bool in_svc[Core::NUM_CORES];
+
+// Games depend on some CPU execution time elapsing during HLE routines, so every SVC and service
+// request advances the emulated clock. These values are estimates; the costs of SVCs which block
+// the calling thread match the fixed penalty all of them used to be charged, which worked well
+// enough for everything tested.
+
+/// Cost in ticks of SVCs without an entry in kSVCCosts
+static const u32 kDefaultSVCCost = 500;
+/// Cost in ticks of requests to services without an entry in kServiceCosts
+static const u32 kDefaultServiceCost = 1000;
+
+static const struct {
+    u32 svc_id;
+    u32 ticks;
+} kSVCCosts[] = {
+    {0x09, 4000}, // ExitThread
+    {0x0A, 4000}, // SleepThread
+    {0x18, 4000}, // SignalEvent
+    {0x22, 4000}, // ArbitrateAddress
+    {0x24, 4000}, // WaitSynchronization1
+    {0x25, 4000}, // WaitSynchronizationN
+};
+
+static const struct {
+    const char* port_name;
+    u32 ticks;
+} kServiceCosts[] = {
+    {"fs:USER", 4000},
+    {"gsp::Gpu", 2000},
+};
+
+static std::array<u32, 0x100> svc_costs;
+static std::unordered_map<std::string, u32> service_costs;
+
+static void InitCostTables() {
+    svc_costs.fill(kDefaultSVCCost);
+    for (const auto& entry : kSVCCosts)
+        svc_costs[entry.svc_id] = entry.ticks;
+
+    service_costs.clear();
+    for (const auto& entry : kServiceCosts)
+        service_costs[entry.port_name] = entry.ticks;
+}
+
+u32 GetSVCCost(u32 svc_id) {
+    return svc_id < svc_costs.size() ? svc_costs[svc_id] : kDefaultSVCCost;
+}
+
+u32 GetServiceCost(const std::string& port_name) {
+    auto itr = service_costs.find(port_name);
+    return itr != service_costs.end() ? itr->second : kDefaultServiceCost;
+}
 
 static const FunctionDef* GetSVCInfo(u32 opcode) {
     u32 func_num = opcode & 0xFFFFFF; // 8 bits
@@ -32,31 +95,66 @@ static const FunctionDef* GetSVCInfo(u32 opcode) {
     return &g_module_db[0].func_table[func_num];
 }
 
+const char* GetSVCName(u32 svc_id) {
+    if (g_module_db.empty() || svc_id > 0xFF)
+        return "unknown";
+    return g_module_db[0].func_table[svc_id].name.c_str();
+}
+
+/// Runs the handler of an SVC and charges the emulated time it takes
+static void ExecuteSVC(const FunctionDef* info) {
+    if (info->func) {
+        info->func();
+    } else {
+        LOG_ERROR(Kernel_SVC, "unimplemented SVC function %s(..)", info->name.c_str());
+    }
+
+    // This may run scheduled events, so do it before deciding whether to reschedule
+    Core::GetCurrentCore()->AddTicks(GetSVCCost(info->id));
+}
+
 void CallSVC(u32 opcode) {
     const FunctionDef *info = GetSVCInfo(opcode);
 
     if (!info) {
         return;
     }
-    if (info->func) {
-        info->func();
+
+    Core::KernelLock lock;
+    const Core::CoreId core_id = Core::GetCurrentCoreId();
+    in_svc[core_id] = true;
+    reschedule_requested = false;
+
+    if (Profiler::IsEnabled()) {
+        Profiler::RecordSVC(info->id, Profiler::Measure([info] { ExecuteSVC(info); }));
     } else {
-        LOG_ERROR(Kernel_SVC, "unimplemented SVC function %s(..)", info->name.c_str());
+        ExecuteSVC(info);
+    }
+
+    // Only interrupt the CPU if the SVC actually made a different thread eligible to run
+    if (reschedule_requested) {
+        reschedule_requested = false;
+
+        g_reschedule = Kernel::IsRescheduleNeeded();
+        if (g_reschedule)
+            Core::GetCurrentCore()->PrepareReschedule();
     }
+
+    in_svc[core_id] = false;
 }
 
 void Reschedule(const char *reason) {
     DEBUG_ASSERT_MSG(reason != nullptr && strlen(reason) < 256, "Reschedule: Invalid or too long reason.");
 
-    // TODO(bunnei): It seems that games depend on some CPU execution time elapsing during HLE
-    // routines. This simulates that time by artificially advancing the number of CPU "ticks".
-    // The value was chosen empirically, it seems to work well enough for everything tested, but
-    // is likely not ideal. We should find a more accurate way to simulate timing with HLE.
-    Core::g_app_core->AddTicks(4000);
-
-    Core::g_app_core->PrepareReschedule();
-
+    // Within an SVC, the decision is deferred until the SVC is done (see CallSVC), since the
+    // current thread might only start waiting after requesting the reschedule.
+    reschedule_requested = true;
     g_reschedule = true;
+
+    // Outside of SVCs (e.g. in event callbacks), stop the CPU right away so that woken threads
+    // don't have to wait for the end of the slice
+    if (!in_svc[Core::GetCurrentCoreId()])
+        Core::GetCurrentCore()->PrepareReschedule();
 }
 
 void RegisterModule(std::string name, int num_functions, const FunctionDef* func_table) {
@@ -64,11 +162,24 @@ void RegisterModule(std::string name, int num_functions, const FunctionDef* func
     g_module_db.push_back(module);
 }
 
+void DoState(PointerWrap& p) {
+    bool reschedule = g_reschedule;
+    bool requested = reschedule_requested;
+    p.Do(reschedule);
+    p.Do(requested);
+    g_reschedule = reschedule;
+    reschedule_requested = requested;
+}
+
 static void RegisterAllModules() {
     SVC::Register();
 }
 
 void Init() {
+    InitCostTables();
+    reschedule_requested = false;
+    in_svc[Core::CORE_APP] = in_svc[Core::CORE_SYS] = false;
+
     Service::Init();
     Service::FS::ArchiveInit();
     Service::CFG::CFGInit();
@@ -88,6 +199,9 @@ void Shutdown() {
     Service::FS::ArchiveShutdown();
     Service::Shutdown();
 
+    // Statistics refer to service objects by address, which may be reused after this point
+    Profiler::Reset();
+
     g_module_db.clear();
 
     LOG_DEBUG(Kernel, "shutdown OK");
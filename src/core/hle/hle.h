@@ -4,16 +4,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "common/common_types.h"
 #include "core/core.h"
 
+class PointerWrap;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace HLE {
 
-extern bool g_reschedule;   ///< If true, immediately reschedules the CPU to a new thread
+/// If true, immediately reschedules the CPU to a new thread. Atomic since both cores may set it.
+extern std::atomic<bool> g_reschedule;
 
 typedef u32 Addr;
 typedef void (*Func)();
@@ -34,8 +38,39 @@ void RegisterModule(std::string name, int num_functions, const FunctionDef *func
 
 void CallSVC(u32 opcode);
 
+/**
+ * Gets the name of an SVC
+ * @param svc_id Number of the SVC
+ * @return Name of the SVC, or "unknown"
+ */
+const char* GetSVCName(u32 svc_id);
+
+/**
+ * Requests a reschedule after the current SVC. The CPU is only stopped and threads are only
+ * switched if the current thread stopped running or a higher priority thread became ready.
+ * Outside of SVCs, the CPU is stopped right away.
+ * @param reason Name of the function requesting the reschedule, for debugging
+ */
 void Reschedule(const char *reason);
 
+/**
+ * Gets the emulated CPU time charged for executing the given SVC
+ * @param svc_id Number of the SVC
+ * @return Cost in ARM11 ticks
+ */
+u32 GetSVCCost(u32 svc_id);
+
+/**
+ * Gets the emulated CPU time charged for a request to the given service, in addition to the cost
+ * of the SendSyncRequest SVC
+ * @param port_name Port name of the service
+ * @return Cost in ARM11 ticks
+ */
+u32 GetServiceCost(const std::string& port_name);
+
+/// Saves or loads the pending reschedule state, for savestates
+void DoState(PointerWrap& p);
+
 void Init();
 
 void Shutdown();
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 
 #include "core/mem_map.h"
@@ -26,6 +27,10 @@ SharedPtr<AddressArbiter> AddressArbiter::Create(std::string name) {
     return address_arbiter;
 }
 
+void AddressArbiter::DoState(PointerWrap& p) {
+    p.Do(name);
+}
+
 ResultCode AddressArbiter::ArbitrateAddress(ArbitrationType type, VAddr address, s32 value,
         u64 nanoseconds) {
     switch (type) {
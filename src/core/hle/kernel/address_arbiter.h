@@ -42,6 +42,8 @@ public:
     static const HandleType HANDLE_TYPE = HandleType::AddressArbiter;
     HandleType GetHandleType() const override { return HANDLE_TYPE; }
 
+    void DoState(PointerWrap& p) override;
+
     std::string name;   ///< Name of address arbiter object (optional)
 
     ResultCode ArbitrateAddress(ArbitrationType type, VAddr address, s32 value, u64 nanoseconds);
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <vector>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/hle/kernel/kernel.h"
@@ -27,6 +28,15 @@ SharedPtr<Event> Event::Create(ResetType reset_type, std::string name) {
     return evt;
 }
 
+void Event::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(intitial_reset_type);
+    p.Do(reset_type);
+    p.Do(signaled);
+    p.Do(name);
+}
+
 bool Event::ShouldWait() {
     return !signaled;
 }
@@ -26,6 +26,8 @@ public:
     static const HandleType HANDLE_TYPE = HandleType::Event;
     HandleType GetHandleType() const override { return HANDLE_TYPE; }
 
+    void DoState(PointerWrap& p) override;
+
     ResetType intitial_reset_type;          ///< ResetType specified at Event initialization
     ResetType reset_type;                   ///< Current ResetType
 
@@ -3,12 +3,19 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <unordered_map>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 
@@ -55,6 +62,10 @@ void WaitObject::WakeupAllWaitingThreads() {
     ASSERT_MSG(waiting_threads.empty(), "failed to awaken all waiting threads!");
 }
 
+void WaitObject::DoState(PointerWrap& p) {
+    DoObjects(p, waiting_threads);
+}
+
 HandleTable::HandleTable() {
     next_generation = 1;
     Clear();
@@ -134,10 +145,124 @@ void HandleTable::Clear() {
     next_free_slot = 0;
 }
 
+void HandleTable::DoState(PointerWrap& p) {
+    for (auto& object : objects)
+        DoObject(p, object);
+    p.DoArray(generations.data(), static_cast<int>(generations.size()));
+    p.Do(next_generation);
+    p.Do(next_free_slot);
+}
+
+/// Marks a reference to no object in a savestate
+static const u32 NULL_OBJECT_INDEX = 0xFFFFFFFF;
+
+static std::unordered_map<std::string, ObjectFactory> object_factories;
+
+/// Indices of the objects saved so far, in the order they were first referenced
+static std::unordered_map<const Object*, u32> saved_object_indices;
+/// Objects loaded so far, indexed like saved_object_indices
+static std::vector<SharedPtr<Object>> loaded_objects;
+
+void RegisterObjectFactory(const std::string& type_name, ObjectFactory factory) {
+    object_factories[type_name] = factory;
+}
+
+void DoObject(PointerWrap& p, SharedPtr<Object>& object) {
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        u32 index = NULL_OBJECT_INDEX;
+        bool first_reference = false;
+        if (object != nullptr) {
+            auto itr = saved_object_indices.find(object.get());
+            if (itr != saved_object_indices.end()) {
+                index = itr->second;
+            } else {
+                index = static_cast<u32>(saved_object_indices.size());
+                saved_object_indices.emplace(object.get(), index);
+                first_reference = true;
+            }
+        }
+        p.Do(index);
+
+        if (first_reference) {
+            std::string type_name = object->GetTypeName();
+            std::string name = object->GetName();
+            p.Do(type_name);
+            p.Do(name);
+            object->DoState(p);
+        }
+        return;
+    }
+
+    u32 index;
+    p.Do(index);
+    if (index == NULL_OBJECT_INDEX) {
+        object = nullptr;
+        return;
+    }
+    if (index < loaded_objects.size()) {
+        object = loaded_objects[index];
+        return;
+    }
+
+    std::string type_name;
+    std::string name;
+    p.Do(type_name);
+    p.Do(name);
+
+    auto factory = object_factories.find(type_name);
+    object = (factory != object_factories.end()) ? factory->second(name) : nullptr;
+    if (index != loaded_objects.size() || object == nullptr) {
+        LOG_ERROR(Kernel, "Unable to load %s %s from savestate", type_name.c_str(), name.c_str());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        object = nullptr;
+        return;
+    }
+
+    // Register the object first, its state may refer back to it
+    loaded_objects.push_back(object);
+    object->DoState(p);
+}
+
+void ClearObjectTable() {
+    saved_object_indices.clear();
+    loaded_objects.clear();
+}
+
+void DoState(PointerWrap& p) {
+    g_handle_table.DoState(p);
+    DoObject(p, g_main_thread);
+    p.Do(g_program_id);
+
+    ThreadingDoState(p);
+    TimersDoState(p);
+}
+
 /// Initialize the kernel
 void Init() {
     Kernel::ThreadingInit();
     Kernel::TimersInit();
+
+    RegisterObjectFactory("Arbiter", [](const std::string& name) -> SharedPtr<Object> {
+        return AddressArbiter::Create(name);
+    });
+    RegisterObjectFactory("Event", [](const std::string& name) -> SharedPtr<Object> {
+        return Event::Create(RESETTYPE_ONESHOT, name);
+    });
+    RegisterObjectFactory("Mutex", [](const std::string& name) -> SharedPtr<Object> {
+        return Mutex::Create(false, name);
+    });
+    RegisterObjectFactory("Semaphore", [](const std::string& name) -> SharedPtr<Object> {
+        return Semaphore::Create(0, 1, name).MoveFrom();
+    });
+    RegisterObjectFactory("SharedMemory", [](const std::string& name) -> SharedPtr<Object> {
+        return SharedMemory::Create(name);
+    });
+    RegisterObjectFactory("Thread", [](const std::string& name) -> SharedPtr<Object> {
+        return Thread::CreateForLoad();
+    });
+    RegisterObjectFactory("Timer", [](const std::string& name) -> SharedPtr<Object> {
+        return Timer::CreateForLoad();
+    });
 }
 
 /// Shutdown the kernel
@@ -145,6 +270,8 @@ void Shutdown() {
     Kernel::ThreadingShutdown();
     Kernel::TimersShutdown();
     g_handle_table.Clear(); // Free all kernel objects
+    ClearObjectTable();
+    object_factories.clear();
 }
 
 /**
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 #include "core/hle/result.h"
 
@@ -95,6 +96,12 @@ public:
         return false;
     }
 
+    /**
+     * Saves or loads the state of the object, for savestates. References to other kernel objects
+     * must be serialized with DoObject.
+     */
+    virtual void DoState(PointerWrap& p) {}
+
 private:
     friend void intrusive_ptr_add_ref(Object*);
     friend void intrusive_ptr_release(Object*);
@@ -153,6 +160,8 @@ public:
     /// Wake up all threads waiting on this object
     void WakeupAllWaitingThreads();
 
+    void DoState(PointerWrap& p) override;
+
 private:
     /// Threads waiting for this object to become available
     std::vector<SharedPtr<Thread>> waiting_threads;
@@ -246,6 +255,9 @@ public:
     /// Closes all handles held in this table.
     void Clear();
 
+    /// Saves or loads the handle table, for savestates.
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * This is the maximum limit of handles allowed per process in CTR-OS. It can be further
@@ -277,6 +289,69 @@ private:
 
 extern HandleTable g_handle_table;
 
+/**
+ * Creates an object of a particular type to load a savestate into, without any side effects.
+ * @param name Name of the object, as returned by GetName when it was saved
+ * @return The new object, or nullptr if it can't be created
+ */
+typedef SharedPtr<Object> (*ObjectFactory)(const std::string& name);
+
+/**
+ * Registers the factory used to recreate objects with the given type name when loading a
+ * savestate. The kernel object types are registered by Init.
+ * @param type_name Type name as returned by Object::GetTypeName
+ */
+void RegisterObjectFactory(const std::string& type_name, ObjectFactory factory);
+
+/**
+ * Saves or loads a reference to a kernel object, for savestates. The first time an object is
+ * referenced, its type, name and state are stored along with the reference. When loading, the
+ * object is recreated through its factory at that point, all further references resolve to it.
+ */
+void DoObject(PointerWrap& p, SharedPtr<Object>& object);
+
+template <typename T>
+void DoObject(PointerWrap& p, SharedPtr<T>& object) {
+    SharedPtr<Object> generic = object;
+    DoObject(p, generic);
+    object = boost::dynamic_pointer_cast<T>(generic);
+    if (object == nullptr && generic != nullptr) {
+        LOG_ERROR(Kernel, "Savestate contains a %s where a different type was expected",
+                  generic->GetTypeName().c_str());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+}
+
+/// Saves or loads a reference to a kernel object which is kept alive elsewhere.
+template <typename T>
+void DoObject(PointerWrap& p, T*& object) {
+    SharedPtr<T> shared = object;
+    DoObject(p, shared);
+    object = shared.get();
+}
+
+/// Saves or loads a vector of kernel object references.
+template <typename T>
+void DoObjects(PointerWrap& p, std::vector<T>& objects) {
+    u32 size = static_cast<u32>(objects.size());
+    p.Do(size);
+    objects.resize(size);
+    for (auto& object : objects)
+        DoObject(p, object);
+}
+
+/**
+ * Forgets the objects serialized so far. Has to be called before and after saving or loading a
+ * savestate, references to the same object are only recognized in between.
+ */
+void ClearObjectTable();
+
+/**
+ * Saves or loads the kernel state, for savestates. This includes all objects referenced by the
+ * kernel and the state of the scheduler.
+ */
+void DoState(PointerWrap& p);
+
 /// The ID code of the currently running game
 /// TODO(Subv): This variable should not be here, 
 /// we need a way to store information about the currently loaded application 
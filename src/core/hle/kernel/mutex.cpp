@@ -7,6 +7,7 @@
 
 #include <boost/range/algorithm_ext/erase.hpp>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/hle/kernel/kernel.h"
@@ -55,6 +56,14 @@ SharedPtr<Mutex> Mutex::Create(bool initial_locked, std::string name) {
     return mutex;
 }
 
+void Mutex::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(lock_count);
+    p.Do(name);
+    DoObject(p, holding_thread);
+}
+
 bool Mutex::ShouldWait() {
     return lock_count > 0 && holding_thread != GetCurrentThread();;
 }
@@ -30,6 +30,8 @@ public:
     static const HandleType HANDLE_TYPE = HandleType::Mutex;
     HandleType GetHandleType() const override { return HANDLE_TYPE; }
 
+    void DoState(PointerWrap& p) override;
+
     int lock_count;                             ///< Number of times the mutex has been acquired
     std::string name;                           ///< Name of mutex (optional)
     SharedPtr<Thread> holding_thread;           ///< Thread that has acquired the mutex
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/hle/kernel/kernel.h"
@@ -31,6 +32,14 @@ ResultVal<SharedPtr<Semaphore>> Semaphore::Create(s32 initial_count, s32 max_cou
     return MakeResult<SharedPtr<Semaphore>>(std::move(semaphore));
 }
 
+void Semaphore::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(max_count);
+    p.Do(available_count);
+    p.Do(name);
+}
+
 bool Semaphore::ShouldWait() {
     return available_count <= 0;
 }
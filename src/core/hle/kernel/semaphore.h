@@ -32,6 +32,8 @@ public:
     static const HandleType HANDLE_TYPE = HandleType::Semaphore;
     HandleType GetHandleType() const override { return HANDLE_TYPE; }
 
+    void DoState(PointerWrap& p) override;
+
     s32 max_count;                              ///< Maximum number of simultaneous holders the semaphore can have
     s32 available_count;                        ///< Number of free slots left in the semaphore
     std::string name;                           ///< Name of semaphore (optional)
@@ -12,12 +12,15 @@ namespace Kernel {
 static const int kCommandHeaderOffset = 0x80; ///< Offset into command buffer of header
 
 /**
- * Returns a pointer to the command buffer in kernel memory
+ * Returns a pointer to the command buffer in kernel memory. Since HLE services write their
+ * replies through it, the command buffer is marked as written.
  * @param offset Optional offset into command buffer
  * @return Pointer to command buffer
  */
 inline static u32* GetCommandBuffer(const int offset=0) {
-    return (u32*)Memory::GetPointer(Memory::KERNEL_MEMORY_VADDR + kCommandHeaderOffset + offset);
+    const VAddr address = Memory::KERNEL_MEMORY_VADDR + kCommandHeaderOffset + offset;
+    Memory::MarkRegionWritten(address, sizeof(u32));
+    return (u32*)Memory::GetPointer(address);
 }
 
 /**
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/mem_map.h"
@@ -20,6 +21,13 @@ SharedPtr<SharedMemory> SharedMemory::Create(std::string name) {
     return shared_memory;
 }
 
+void SharedMemory::DoState(PointerWrap& p) {
+    p.Do(base_address);
+    p.Do(permissions);
+    p.Do(other_permissions);
+    p.Do(name);
+}
+
 ResultCode SharedMemory::Map(VAddr address, MemoryPermission permissions,
         MemoryPermission other_permissions) {
 
@@ -39,8 +47,12 @@ ResultCode SharedMemory::Map(VAddr address, MemoryPermission permissions,
 }
 
 ResultVal<u8*> SharedMemory::GetPointer(u32 offset) {
-    if (base_address != 0)
+    if (base_address != 0) {
+        // HLE services update their structures in shared memory through this pointer. They are
+        // small, so marking a page's worth as written lets write tracking notice the updates.
+        Memory::MarkRegionWritten(base_address + offset, Memory::PAGE_SIZE);
         return MakeResult<u8*>(Memory::GetPointer(base_address + offset));
+    }
 
     LOG_ERROR(Kernel_SVC, "memory block id=%u not mapped!", GetObjectId());
     // TODO(yuriks): Verify error code.
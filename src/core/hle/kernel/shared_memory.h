@@ -36,6 +36,8 @@ public:
     static const HandleType HANDLE_TYPE = HandleType::SharedMemory;
     HandleType GetHandleType() const override { return HANDLE_TYPE; }
 
+    void DoState(PointerWrap& p) override;
+
     /**
      * Maps a shared memory block to an address in system memory
      * @param address Address in system memory to map shared memory block to
@@ -45,7 +47,8 @@ public:
     ResultCode Map(VAddr address, MemoryPermission permissions, MemoryPermission other_permissions);
 
     /**
-    * Gets a pointer to the shared memory block
+    * Gets a pointer to the shared memory block, which may be written through. The memory it points
+    * to is marked as written.
     * @param offset Offset from the start of the shared memory block to get pointer
     * @return Pointer to the shared memory block from the specified offset
     */
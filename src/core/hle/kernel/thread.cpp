@@ -4,8 +4,10 @@
 
 #include <algorithm>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 #include "common/thread_queue_list.h"
 
@@ -16,6 +18,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/session.h"
 #include "core/hle/result.h"
 #include "core/mem_map.h"
 
@@ -32,13 +35,50 @@ void Thread::Acquire() {
     ASSERT_MSG(!ShouldWait(), "object unavailable!");
 }
 
+void Thread::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(context);
+    p.Do(thread_id);
+    p.Do(status);
+    p.Do(entry_point);
+    p.Do(stack_top);
+    p.Do(initial_priority);
+    p.Do(current_priority);
+    p.Do(processor_id);
+    p.Do(core);
+
+    std::vector<SharedPtr<Mutex>> mutexes(held_mutexes.begin(), held_mutexes.end());
+    DoObjects(p, mutexes);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        held_mutexes.clear();
+        held_mutexes.insert(mutexes.begin(), mutexes.end());
+    }
+
+    DoObjects(p, wait_objects);
+    p.Do(wait_address);
+    p.Do(wait_all);
+    p.Do(wait_set_output);
+    p.Do(pending_ipc_reply);
+    p.Do(name);
+    p.Do(idle);
+    p.Do(callback_handle);
+    p.Do(wakeup_event);
+}
+
 // Lists all thread ids that aren't deleted/etc.
 static std::vector<SharedPtr<Thread>> thread_list;
 
-// Lists only ready thread ids.
-static Common::ThreadQueueList<Thread*, THREADPRIO_LOWEST+1> ready_queue;
+// Lists only ready thread ids, separately for each core.
+static Common::ThreadQueueList<Thread*, THREADPRIO_LOWEST+1> ready_queues[Core::NUM_CORES];
 
-static Thread* current_thread;
+// The thread running on each core
+static Thread* current_threads[Core::NUM_CORES];
+
+// Threads waiting to be arbitrated, by arbitration address. Each queue is ordered by priority, with
+// threads of equal priority in the order they started waiting. Queues are erased once empty, so
+// that the map doesn't grow with every address a game ever arbitrated on.
+static std::unordered_map<VAddr, std::vector<Thread*>> arbitration_queues;
 
 // The first available thread id at startup
 static u32 next_thread_id = 1;
@@ -55,7 +95,15 @@ Thread::Thread() {}
 Thread::~Thread() {}
 
 Thread* GetCurrentThread() {
-    return current_thread;
+    return current_threads[Core::GetCurrentCoreId()];
+}
+
+bool HasRunnableThread(Core::CoreId core) {
+    const Thread* thread = current_threads[core];
+    if (thread != nullptr && thread->status == THREADSTATUS_RUNNING)
+        return true;
+
+    return ready_queues[core].get_first_better(THREADPRIO_LOWEST + 1) != nullptr;
 }
 
 /**
@@ -73,13 +121,29 @@ static bool CheckWait_WaitObject(const Thread* thread, WaitObject* wait_object)
 }
 
 /**
- * Check if the specified thread is waiting on the specified address to be arbitrated
- * @param thread The thread to test
- * @param wait_address The address to test against
- * @return True if the thread is waiting, false otherwise
+ * Adds a thread to the arbitration queue of its wait address
+ * @param thread The thread to add, which must be waiting on an address arbiter
+ */
+static void AddToArbitrationQueue(Thread* thread) {
+    auto& queue = arbitration_queues[thread->wait_address];
+    auto position = std::upper_bound(queue.begin(), queue.end(), thread,
+            [](const Thread* a, const Thread* b) { return a->current_priority < b->current_priority; });
+    queue.insert(position, thread);
+}
+
+/**
+ * Removes a thread from the arbitration queue of its wait address, if it is in there
+ * @param thread The thread to remove
  */
-static bool CheckWait_AddressArbiter(const Thread* thread, VAddr wait_address) {
-    return thread->status == THREADSTATUS_WAIT_ARB && wait_address == thread->wait_address;
+static void RemoveFromArbitrationQueue(Thread* thread) {
+    auto queue = arbitration_queues.find(thread->wait_address);
+    if (queue == arbitration_queues.end())
+        return;
+
+    auto& threads = queue->second;
+    threads.erase(std::remove(threads.begin(), threads.end(), thread), threads.end());
+    if (threads.empty())
+        arbitration_queues.erase(queue);
 }
 
 void Thread::Stop() {
@@ -87,12 +151,14 @@ void Thread::Stop() {
     ReleaseThreadMutexes(this);
 
     // Cancel any outstanding wakeup events for this thread
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::CancelEvent(wakeup_event);
 
     // Clean up thread from ready queue
     // This is only needed when the thread is termintated forcefully (SVC TerminateProcess)
     if (status == THREADSTATUS_READY){
-        ready_queue.remove(current_priority, this);
+        ready_queues[core].remove(current_priority, this);
+    } else if (status == THREADSTATUS_WAIT_ARB) {
+        RemoveFromArbitrationQueue(this);
     }
 
     status = THREADSTATUS_DEAD;
@@ -106,37 +172,39 @@ void Thread::Stop() {
 }
 
 Thread* ArbitrateHighestPriorityThread(u32 address) {
-    Thread* highest_priority_thread = nullptr;
-    s32 priority = THREADPRIO_LOWEST;
+    auto queue = arbitration_queues.find(address);
+    if (queue == arbitration_queues.end())
+        return nullptr;
 
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated...
-    for (auto& thread : thread_list) {
-        if (!CheckWait_AddressArbiter(thread.get(), address))
-            continue;
+    // The queue is ordered by priority, so the first thread is the one to resume. Resuming it
+    // also removes it from the queue, which invalidates the iterator if it was the last one.
+    Thread* highest_priority_thread = queue->second.front();
+    highest_priority_thread->ResumeFromWait();
 
-        if (thread == nullptr)
-            continue;
+    return highest_priority_thread;
+}
 
-        if(thread->current_priority <= priority) {
-            highest_priority_thread = thread.get();
-            priority = thread->current_priority;
-        }
-    }
+void ArbitrateAllThreads(u32 address) {
+    auto queue = arbitration_queues.find(address);
+    if (queue == arbitration_queues.end())
+        return;
 
-    // If a thread was arbitrated, resume it
-    if (nullptr != highest_priority_thread) {
-        highest_priority_thread->ResumeFromWait();
-    }
+    // Take the whole queue at once, so that resuming the threads doesn't need to search it
+    std::vector<Thread*> threads;
+    threads.swap(queue->second);
+    arbitration_queues.erase(queue);
 
-    return highest_priority_thread;
+    for (Thread* thread : threads)
+        thread->ResumeFromWait();
 }
 
-void ArbitrateAllThreads(u32 address) {
-    // Resume all threads found to be waiting on the address
-    for (auto& thread : thread_list) {
-        if (CheckWait_AddressArbiter(thread.get(), address))
-            thread->ResumeFromWait();
-    }
+/// Moves a reply which arrived while the thread was waiting into the (shared) command buffer
+static void DeliverPendingIPCReply(Thread* thread) {
+    if (thread->pending_ipc_reply.empty())
+        return;
+
+    std::copy(thread->pending_ipc_reply.begin(), thread->pending_ipc_reply.end(), Kernel::GetCommandBuffer());
+    thread->pending_ipc_reply.clear();
 }
 
 /** 
@@ -144,32 +212,44 @@ void ArbitrateAllThreads(u32 address) {
  * @param new_thread The thread to switch to
  */
 static void SwitchContext(Thread* new_thread) {
-    DEBUG_ASSERT_MSG(new_thread->status == THREADSTATUS_READY, "Thread must be ready to become running.");
+    DEBUG_ASSERT_MSG(new_thread == nullptr || new_thread->status == THREADSTATUS_READY,
+                     "Thread must be ready to become running.");
 
+    const Core::CoreId core = Core::GetCurrentCoreId();
     Thread* previous_thread = GetCurrentThread();
 
+    // Rescheduling to the thread which is already loaded (e.g. after a wait that was satisfied
+    // right away) doesn't need to touch the CPU state at all
+    if (new_thread != nullptr && new_thread == previous_thread) {
+        ready_queues[core].remove(new_thread->current_priority, new_thread);
+        new_thread->status = THREADSTATUS_RUNNING;
+        DeliverPendingIPCReply(new_thread);
+        return;
+    }
+
     // Save context for previous thread
     if (previous_thread) {
-        Core::g_app_core->SaveContext(previous_thread->context);
+        Core::GetCurrentCore()->SaveContext(previous_thread->context);
 
         if (previous_thread->status == THREADSTATUS_RUNNING) {
             // This is only the case when a reschedule is triggered without the current thread
             // yielding execution (i.e. an event triggered, system core time-sliced, etc)
-            ready_queue.push_front(previous_thread->current_priority, previous_thread);
+            ready_queues[core].push_front(previous_thread->current_priority, previous_thread);
             previous_thread->status = THREADSTATUS_READY;
         }
     }
 
     // Load context of new thread
     if (new_thread) {
-        current_thread = new_thread;
+        current_threads[core] = new_thread;
 
-        ready_queue.remove(new_thread->current_priority, new_thread);
+        ready_queues[core].remove(new_thread->current_priority, new_thread);
         new_thread->status = THREADSTATUS_RUNNING;
 
-        Core::g_app_core->LoadContext(new_thread->context);
+        Core::GetCurrentCore()->LoadContext(new_thread->context);
+        DeliverPendingIPCReply(new_thread);
     } else {
-        current_thread = nullptr;
+        current_threads[core] = nullptr;
     }
 }
 
@@ -178,6 +258,7 @@ static void SwitchContext(Thread* new_thread) {
  * @return A pointer to the next ready thread
  */
 static Thread* PopNextReadyThread() {
+    auto& ready_queue = ready_queues[Core::GetCurrentCoreId()];
     Thread* next;
     Thread* thread = GetCurrentThread();
 
@@ -192,6 +273,14 @@ static Thread* PopNextReadyThread() {
     return next;
 }
 
+bool IsRescheduleNeeded() {
+    Thread* thread = GetCurrentThread();
+    if (thread == nullptr || thread->status != THREADSTATUS_RUNNING)
+        return true;
+
+    return ready_queues[thread->core].get_first_better(thread->current_priority) != nullptr;
+}
+
 void WaitCurrentThread_Sleep() {
     Thread* thread = GetCurrentThread();
     thread->status = THREADSTATUS_WAIT_SLEEP;
@@ -205,10 +294,16 @@ void WaitCurrentThread_WaitSynchronization(std::vector<SharedPtr<WaitObject>> wa
     thread->status = THREADSTATUS_WAIT_SYNCH;
 }
 
+void WaitCurrentThread_IPC() {
+    Thread* thread = GetCurrentThread();
+    thread->status = THREADSTATUS_WAIT_IPC;
+}
+
 void WaitCurrentThread_ArbitrateAddress(VAddr wait_address) {
     Thread* thread = GetCurrentThread();
     thread->wait_address = wait_address;
     thread->status = THREADSTATUS_WAIT_ARB;
+    AddToArbitrationQueue(thread);
 }
 
 // TODO(yuriks): This can be removed if Thread objects are explicitly pooled in the future, allowing
@@ -244,7 +339,7 @@ void Thread::WakeAfterDelay(s64 nanoseconds) {
         return;
 
     u64 microseconds = nanoseconds / 1000;
-    CoreTiming::ScheduleEvent(usToCycles(microseconds), ThreadWakeupEventType, callback_handle);
+    wakeup_event = CoreTiming::ScheduleEvent(usToCycles(microseconds), ThreadWakeupEventType, callback_handle);
 }
 
 void Thread::ReleaseWaitObject(WaitObject* wait_object) {
@@ -291,7 +386,7 @@ void Thread::ReleaseWaitObject(WaitObject* wait_object) {
 
 void Thread::ResumeFromWait() {
     // Cancel any outstanding wakeup events for this thread
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::CancelEvent(wakeup_event);
 
     switch (status) {
         case THREADSTATUS_WAIT_SYNCH:
@@ -300,7 +395,10 @@ void Thread::ResumeFromWait() {
                 wait_object->RemoveWaitingThread(this);
             break;
         case THREADSTATUS_WAIT_ARB:
+            RemoveFromArbitrationQueue(this);
+            break;
         case THREADSTATUS_WAIT_SLEEP:
+        case THREADSTATUS_WAIT_IPC:
             break;
         case THREADSTATUS_RUNNING:
         case THREADSTATUS_READY:
@@ -313,7 +411,7 @@ void Thread::ResumeFromWait() {
             return;
     }
     
-    ready_queue.push_back(current_priority, this);
+    ready_queues[core].push_back(current_priority, this);
     status = THREADSTATUS_READY;
 }
 
@@ -329,7 +427,7 @@ static void DebugThreadQueue() {
     }
 
     for (auto& t : thread_list) {
-        s32 priority = ready_queue.contains(t.get());
+        s32 priority = ready_queues[t->core].contains(t.get());
         if (priority != -1) {
             LOG_DEBUG(Kernel, "0x%02X %u", priority, t->GetObjectId());
         }
@@ -356,8 +454,15 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
 
     SharedPtr<Thread> thread(new Thread);
 
+    // Threads only run on the system core if they ask for it, and only in multi-core mode.
+    // Applications pass either THREADPROCESSORID_1 or the plain core number.
+    const u32 requested_core = static_cast<u32>(processor_id);
+    thread->core = Core::CORE_APP;
+    if (Core::IsMultiCore() && (requested_core == THREADPROCESSORID_1 || requested_core == Core::CORE_SYS))
+        thread->core = Core::CORE_SYS;
+
     thread_list.push_back(thread);
-    ready_queue.prepare(priority);
+    ready_queues[thread->core].prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = THREADSTATUS_DORMANT;
@@ -374,14 +479,18 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
 
     // TODO(peachum): move to ScheduleThread() when scheduler is added so selected core is used
     // to initialize the context
-    Core::g_app_core->ResetContext(thread->context, stack_top, entry_point, arg);
+    Core::GetCurrentCore()->ResetContext(thread->context, stack_top, entry_point, arg);
 
-    ready_queue.push_back(thread->current_priority, thread.get());
+    ready_queues[thread->core].push_back(thread->current_priority, thread.get());
     thread->status = THREADSTATUS_READY;
 
     return MakeResult<SharedPtr<Thread>>(std::move(thread));
 }
 
+SharedPtr<Thread> Thread::CreateForLoad() {
+    return SharedPtr<Thread>(new Thread);
+}
+
 // TODO(peachum): Remove this. Range checking should be done, and an appropriate error should be returned.
 static void ClampPriority(const Thread* thread, s32* priority) {
     if (*priority < THREADPRIO_HIGHEST || *priority > THREADPRIO_LOWEST) {
@@ -405,12 +514,18 @@ void Thread::SetPriority(s32 priority) {
 
     if (status == THREADSTATUS_READY) {
         // If thread was ready, adjust queues
-        ready_queue.remove(current_priority, this);
-        ready_queue.prepare(priority);
-        ready_queue.push_back(priority, this);
+        ready_queues[core].remove(current_priority, this);
+        ready_queues[core].prepare(priority);
+        ready_queues[core].push_back(priority, this);
+        current_priority = priority;
+    } else if (status == THREADSTATUS_WAIT_ARB) {
+        // Keep the arbitration queue ordered by priority
+        RemoveFromArbitrationQueue(this);
+        current_priority = priority;
+        AddToArbitrationQueue(this);
+    } else {
+        current_priority = priority;
     }
-    
-    current_priority = priority;
 }
 
 SharedPtr<Thread> SetupIdleThread() {
@@ -443,9 +558,14 @@ void Reschedule() {
     HLE::g_reschedule = false;
 
     if (next != nullptr) {
-        LOG_TRACE(Kernel, "context switch %u -> %u", prev->GetObjectId(), next->GetObjectId());
+        LOG_TRACE(Kernel, "context switch %u -> %u", prev ? prev->GetObjectId() : 0, next->GetObjectId());
         SwitchContext(next);
-    } else {
+    } else if (prev != nullptr && prev->status != THREADSTATUS_RUNNING) {
+        // Only the system core can run out of threads, since it has no idle thread. Unload the
+        // waiting thread, so that its context can be updated when it's woken up.
+        LOG_TRACE(Kernel, "no thread left to run after %u", prev->GetObjectId());
+        SwitchContext(nullptr);
+    } else if (prev != nullptr) {
         LOG_TRACE(Kernel, "cannot context switch from %u, no higher priority thread!", prev->GetObjectId());
 
         for (auto& thread : thread_list) {
@@ -473,6 +593,61 @@ void ThreadingInit() {
 }
 
 void ThreadingShutdown() {
+    arbitration_queues.clear();
+
+    for (auto& thread : current_threads)
+        thread = nullptr;
+}
+
+void ThreadingDoState(PointerWrap& p) {
+    DoObjects(p, thread_list);
+
+    for (auto& ready_queue : ready_queues) {
+        if (p.GetMode() == PointerWrap::MODE_READ)
+            ready_queue.clear();
+
+        for (s32 priority = THREADPRIO_HIGHEST; priority <= THREADPRIO_LOWEST; ++priority) {
+            const auto& queue = ready_queue.get_queue(priority);
+            std::vector<Thread*> threads(queue.begin(), queue.end());
+            DoObjects(p, threads);
+
+            if (p.GetMode() == PointerWrap::MODE_READ) {
+                for (Thread* thread : threads)
+                    ready_queue.push_back(priority, thread);
+            }
+        }
+    }
+
+    for (auto& thread : current_threads)
+        DoObject(p, thread);
+
+    u32 num_arbitration_queues = static_cast<u32>(arbitration_queues.size());
+    p.Do(num_arbitration_queues);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        arbitration_queues.clear();
+        for (u32 i = 0; i < num_arbitration_queues; ++i) {
+            VAddr address;
+            p.Do(address);
+            DoObjects(p, arbitration_queues[address]);
+        }
+    } else {
+        for (auto& queue : arbitration_queues) {
+            VAddr address = queue.first;
+            p.Do(address);
+            DoObjects(p, queue.second);
+        }
+    }
+
+    p.Do(next_thread_id);
+    wakeup_callback_handle_table.DoState(p);
+
+    // Threads are only ever queued at priorities which were prepared beforehand
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        for (auto& thread : thread_list) {
+            ready_queues[thread->core].prepare(thread->initial_priority);
+            ready_queues[thread->core].prepare(thread->current_priority);
+        }
+    }
 }
 
 } // namespace
@@ -12,6 +12,7 @@
 #include "common/common_types.h"
 
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/mem_map.h"
 
 #include "core/hle/kernel/kernel.h"
@@ -36,6 +37,7 @@ enum ThreadStatus {
     THREADSTATUS_WAIT_ARB,      ///< Waiting on an address arbiter
     THREADSTATUS_WAIT_SLEEP,    ///< Waiting due to a SleepThread SVC
     THREADSTATUS_WAIT_SYNCH,    ///< Waiting due to a WaitSynchronization SVC
+    THREADSTATUS_WAIT_IPC,      ///< Waiting for an asynchronously handled HLE service request
     THREADSTATUS_DORMANT,       ///< Created but not yet made ready
     THREADSTATUS_DEAD           ///< Run to completion, or forcefully terminated
 };
@@ -60,6 +62,12 @@ public:
     static ResultVal<SharedPtr<Thread>> Create(std::string name, VAddr entry_point, s32 priority,
         u32 arg, s32 processor_id, VAddr stack_top);
 
+    /**
+     * Creates a thread without scheduling it, for its state to be loaded from a savestate
+     * @return A shared pointer to the newly created thread
+     */
+    static SharedPtr<Thread> CreateForLoad();
+
     std::string GetName() const override { return name; }
     std::string GetTypeName() const override { return "Thread"; }
 
@@ -69,6 +77,8 @@ public:
     bool ShouldWait() override;
     void Acquire() override;
 
+    void DoState(PointerWrap& p) override;
+
     /**
      * Checks if the thread is an idle (stub) thread
      * @return True if the thread is an idle (stub) thread, false otherwise
@@ -139,6 +149,7 @@ public:
     s32 current_priority;
 
     s32 processor_id;
+    Core::CoreId core;  ///< Core the thread is scheduled on, derived from processor_id
 
     /// Mutexes currently held by this thread, which will be released when it exits.
     boost::container::flat_set<SharedPtr<Mutex>> held_mutexes;
@@ -148,6 +159,10 @@ public:
     bool wait_all;          ///< True if the thread is waiting on all objects before resuming
     bool wait_set_output;   ///< True if the output parameter should be set on thread wakeup
 
+    /// Command buffer contents to restore when the thread is scheduled next, used to deliver the
+    /// reply of an asynchronously handled service request. Empty if there is none.
+    std::vector<u32> pending_ipc_reply;
+
     std::string name;
 
     /// Whether this thread is intended to never actually be executed, i.e. always idle
@@ -159,6 +174,9 @@ private:
 
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
+
+    /// Pending wakeup event of this thread, if any
+    CoreTiming::EventHandle wakeup_event = CoreTiming::INVALID_EVENT_HANDLE;
 };
 
 extern SharedPtr<Thread> g_main_thread;
@@ -177,6 +195,18 @@ SharedPtr<Thread> SetupMainThread(u32 stack_size, u32 entry_point, s32 priority)
  */
 void Reschedule();
 
+/**
+ * Checks whether the given core has a thread to run, either the current one or a ready one
+ * @param core The core to check
+ */
+bool HasRunnableThread(Core::CoreId core);
+
+/**
+ * Checks whether rescheduling would switch away from the current thread, i.e. whether the current
+ * thread stopped running or a thread with higher priority became ready
+ */
+bool IsRescheduleNeeded();
+
 /**
  * Arbitrate the highest priority thread that is waiting
  * @param address The address for which waiting threads should be arbitrated
@@ -207,6 +237,12 @@ void WaitCurrentThread_Sleep();
  */
 void WaitCurrentThread_WaitSynchronization(std::vector<SharedPtr<WaitObject>> wait_objects, bool wait_set_output, bool wait_all);
 
+/**
+ * Waits the current thread until an asynchronously handled service request completes. The request
+ * handler resumes the thread after storing the reply in pending_ipc_reply.
+ */
+void WaitCurrentThread_IPC();
+
 /**
  * Waits the current thread from an ArbitrateAddress call
  * @param wait_address Arbitration address used to resume from wait
@@ -231,4 +267,9 @@ void ThreadingInit();
  */
 void ThreadingShutdown();
 
+/**
+ * Saves or loads all threads and the state of the scheduler, for savestates
+ */
+void ThreadingDoState(PointerWrap& p);
+
 } // namespace
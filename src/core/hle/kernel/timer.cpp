@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/core_timing.h"
@@ -33,6 +34,10 @@ SharedPtr<Timer> Timer::Create(ResetType reset_type, std::string name) {
     return timer;
 }
 
+SharedPtr<Timer> Timer::CreateForLoad() {
+    return SharedPtr<Timer>(new Timer);
+}
+
 bool Timer::ShouldWait() {
     return !signaled;
 }
@@ -41,6 +46,18 @@ void Timer::Acquire() {
     ASSERT_MSG( !ShouldWait(), "object unavailable!");
 }
 
+void Timer::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(reset_type);
+    p.Do(signaled);
+    p.Do(name);
+    p.Do(initial_delay);
+    p.Do(interval_delay);
+    p.Do(callback_event);
+    p.Do(callback_handle);
+}
+
 void Timer::Set(s64 initial, s64 interval) {
     // Ensure we get rid of any previous scheduled event
     Cancel();
@@ -49,12 +66,12 @@ void Timer::Set(s64 initial, s64 interval) {
     interval_delay = interval;
 
     u64 initial_microseconds = initial / 1000;
-    CoreTiming::ScheduleEvent(usToCycles(initial_microseconds),
+    callback_event = CoreTiming::ScheduleEvent(usToCycles(initial_microseconds),
             timer_callback_event_type, callback_handle);
 }
 
 void Timer::Cancel() {
-    CoreTiming::UnscheduleEvent(timer_callback_event_type, callback_handle);
+    CoreTiming::CancelEvent(callback_event);
 }
 
 void Timer::Clear() {
@@ -83,7 +100,7 @@ static void TimerCallback(u64 timer_handle, int cycles_late) {
     if (timer->interval_delay != 0) {
         // Reschedule the timer with the interval delay
         u64 interval_microseconds = timer->interval_delay / 1000;
-        CoreTiming::ScheduleEvent(usToCycles(interval_microseconds) - cycles_late, 
+        timer->callback_event = CoreTiming::ScheduleEvent(usToCycles(interval_microseconds) - cycles_late,
                 timer_callback_event_type, timer_handle);
     }
 }
@@ -95,4 +112,8 @@ void TimersInit() {
 void TimersShutdown() {
 }
 
+void TimersDoState(PointerWrap& p) {
+    timer_callback_handle_table.DoState(p);
+}
+
 } // namespace
@@ -6,6 +6,7 @@
 
 #include "common/common_types.h"
 
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/svc.h"
 
@@ -21,6 +22,12 @@ public:
      */
     static SharedPtr<Timer> Create(ResetType reset_type, std::string name = "Unknown");
 
+    /**
+     * Creates a timer without a callback handle, for its state to be loaded from a savestate
+     * @return The created Timer
+     */
+    static SharedPtr<Timer> CreateForLoad();
+
     std::string GetTypeName() const override { return "Timer"; }
     std::string GetName() const override { return name; }
 
@@ -35,9 +42,14 @@ public:
     u64 initial_delay;                      ///< The delay until the timer fires for the first time
     u64 interval_delay;                     ///< The delay until the timer fires after the first time
 
+    /// Pending timer callback event, if any
+    CoreTiming::EventHandle callback_event = CoreTiming::INVALID_EVENT_HANDLE;
+
     bool ShouldWait() override;
     void Acquire() override;
 
+    void DoState(PointerWrap& p) override;
+
     /**
      * Starts the timer, with the specified initial delay and interval.
      * @param initial Delay until the timer is first fired
@@ -60,5 +72,7 @@ private:
 void TimersInit();
 /// Tears down the timer variables
 void TimersShutdown();
+/// Saves or loads the timer variables, for savestates
+void TimersDoState(PointerWrap& p);
 
 } // namespace
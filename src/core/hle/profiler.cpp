@@ -0,0 +1,176 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "common/logging/log.h"
+#include "common/string_util.h"
+
+#include "core/hle/hle.h"
+#include "core/hle/profiler.h"
+#include "core/hle/service/service.h"
+
+namespace HLE {
+
+namespace Profiler {
+
+std::atomic<bool> g_enabled(false);
+
+/// Statistics recorded by a single thread
+struct ThreadCounters {
+    /// Only contended while statistics are being read or reset
+    std::mutex mutex;
+
+    std::array<CallStats, 0x100> svcs;
+    std::map<std::pair<Service::Interface*, u32>, ServiceCallStats> service_calls;
+};
+
+/// Counters of all threads which ever recorded anything. Never shrinks, so that statistics of
+/// exited threads are kept.
+static std::vector<std::unique_ptr<ThreadCounters>> all_counters;
+static std::mutex all_counters_mutex;
+
+static THREAD_LOCAL ThreadCounters* thread_counters = nullptr;
+
+static ThreadCounters& GetThreadCounters() {
+    if (thread_counters == nullptr) {
+        std::unique_ptr<ThreadCounters> counters(new ThreadCounters);
+        thread_counters = counters.get();
+
+        std::lock_guard<std::mutex> lock(all_counters_mutex);
+        all_counters.push_back(std::move(counters));
+    }
+    return *thread_counters;
+}
+
+static void AddSample(CallStats& stats, const CallSample& sample) {
+    stats.calls++;
+    stats.total_host_ns += sample.host_ns;
+    stats.max_host_ns = std::max(stats.max_host_ns, sample.host_ns);
+    stats.total_ticks += sample.ticks;
+}
+
+static void MergeStats(CallStats& dest, const CallStats& src) {
+    dest.calls += src.calls;
+    dest.total_host_ns += src.total_host_ns;
+    dest.max_host_ns = std::max(dest.max_host_ns, src.max_host_ns);
+    dest.total_ticks += src.total_ticks;
+}
+
+void SetEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+void Reset() {
+    std::lock_guard<std::mutex> lock(all_counters_mutex);
+    for (auto& counters : all_counters) {
+        std::lock_guard<std::mutex> counters_lock(counters->mutex);
+        counters->svcs.fill(CallStats());
+        counters->service_calls.clear();
+    }
+}
+
+void RecordSVC(u32 svc_id, const CallSample& sample) {
+    ThreadCounters& counters = GetThreadCounters();
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    AddSample(counters.svcs[svc_id & 0xFF], sample);
+}
+
+void RecordServiceCall(Service::Interface* service, u32 command_id, const CallSample& sample) {
+    ThreadCounters& counters = GetThreadCounters();
+    std::lock_guard<std::mutex> lock(counters.mutex);
+
+    auto itr = counters.service_calls.find(std::make_pair(service, command_id));
+    if (itr == counters.service_calls.end()) {
+        ServiceCallStats entry;
+        entry.port_name = service->GetPortName();
+        entry.command_id = command_id;
+        itr = counters.service_calls.emplace(std::make_pair(service, command_id), entry).first;
+    }
+    AddSample(itr->second.stats, sample);
+}
+
+std::vector<SVCStats> GetSVCStats() {
+    std::array<CallStats, 0x100> merged;
+
+    {
+        std::lock_guard<std::mutex> lock(all_counters_mutex);
+        for (auto& counters : all_counters) {
+            std::lock_guard<std::mutex> counters_lock(counters->mutex);
+            for (size_t i = 0; i < merged.size(); ++i)
+                MergeStats(merged[i], counters->svcs[i]);
+        }
+    }
+
+    std::vector<SVCStats> result;
+    for (u32 svc_id = 0; svc_id < merged.size(); ++svc_id) {
+        if (merged[svc_id].calls == 0)
+            continue;
+
+        SVCStats entry;
+        entry.svc_id = svc_id;
+        entry.name = GetSVCName(svc_id);
+        entry.stats = merged[svc_id];
+        result.push_back(entry);
+    }
+    return result;
+}
+
+std::vector<ServiceCallStats> GetServiceCallStats() {
+    std::map<std::pair<std::string, u32>, ServiceCallStats> merged;
+
+    {
+        std::lock_guard<std::mutex> lock(all_counters_mutex);
+        for (auto& counters : all_counters) {
+            std::lock_guard<std::mutex> counters_lock(counters->mutex);
+            for (const auto& call : counters->service_calls) {
+                const ServiceCallStats& src = call.second;
+                auto itr = merged.find(std::make_pair(src.port_name, src.command_id));
+                if (itr == merged.end())
+                    merged.emplace(std::make_pair(src.port_name, src.command_id), src);
+                else
+                    MergeStats(itr->second.stats, src.stats);
+            }
+        }
+    }
+
+    std::vector<ServiceCallStats> result;
+    result.reserve(merged.size());
+    for (const auto& entry : merged)
+        result.push_back(entry.second);
+    return result;
+}
+
+void LogStats() {
+    auto FormatStats = [](const CallStats& stats) {
+        return Common::StringFromFormat("calls=%llu total=%.3fms avg=%.2fus max=%.2fus ticks=%llu",
+                stats.calls, stats.total_host_ns / 1000000.0, stats.total_host_ns / 1000.0 / stats.calls,
+                stats.max_host_ns / 1000.0, stats.total_ticks);
+    };
+
+    auto svcs = GetSVCStats();
+    std::sort(svcs.begin(), svcs.end(), [](const SVCStats& a, const SVCStats& b) {
+        return a.stats.total_host_ns > b.stats.total_host_ns;
+    });
+    for (const auto& svc : svcs) {
+        LOG_INFO(Kernel, "SVC 0x%02X %s: %s", svc.svc_id, svc.name.c_str(), FormatStats(svc.stats).c_str());
+    }
+
+    auto service_calls = GetServiceCallStats();
+    std::sort(service_calls.begin(), service_calls.end(), [](const ServiceCallStats& a, const ServiceCallStats& b) {
+        return a.stats.total_host_ns > b.stats.total_host_ns;
+    });
+    for (const auto& call : service_calls) {
+        LOG_INFO(Service, "%s command 0x%04X: %s", call.port_name.c_str(), call.command_id,
+                 FormatStats(call.stats).c_str());
+    }
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,95 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "core/core_timing.h"
+
+namespace Service {
+class Interface;
+}
+
+namespace HLE {
+
+/**
+ * Records how much host time and emulated time is spent in each SVC and service command.
+ *
+ * Statistics are collected in per-thread counters, so recording never contends with other
+ * emulation threads. When profiling is disabled, instrumented call sites only pay for checking
+ * IsEnabled().
+ */
+namespace Profiler {
+
+struct CallStats {
+    u64 calls = 0;         ///< Number of calls
+    u64 total_host_ns = 0; ///< Total host time spent in the calls
+    u64 max_host_ns = 0;   ///< Longest host time spent in a single call
+    u64 total_ticks = 0;   ///< Total emulated ARM11 ticks elapsed during the calls
+};
+
+struct SVCStats {
+    u32 svc_id;
+    std::string name;
+    CallStats stats;
+};
+
+struct ServiceCallStats {
+    std::string port_name;
+    u32 command_id; ///< Upper 16 bits of the command header
+    CallStats stats;
+};
+
+/// Host and emulated time taken by a single call
+struct CallSample {
+    u64 host_ns;
+    u64 ticks;
+};
+
+extern std::atomic<bool> g_enabled;
+
+inline bool IsEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void SetEnabled(bool enabled);
+
+/// Clears all statistics collected so far.
+void Reset();
+
+/// Runs func and measures the host and emulated time it took.
+template <typename Func>
+CallSample Measure(Func func) {
+    using Clock = std::chrono::steady_clock;
+
+    const auto start_time = Clock::now();
+    const u64 start_ticks = CoreTiming::GetTicks();
+    func();
+    const u64 ticks = CoreTiming::GetTicks() - start_ticks;
+    const auto host_time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time);
+
+    return { static_cast<u64>(host_time.count()), ticks };
+}
+
+void RecordSVC(u32 svc_id, const CallSample& sample);
+void RecordServiceCall(Service::Interface* service, u32 command_id, const CallSample& sample);
+
+/// Returns the statistics of all SVCs called so far, merged over all threads (thread-safe).
+std::vector<SVCStats> GetSVCStats();
+
+/// Returns the statistics of all service commands called so far, merged over all threads (thread-safe).
+std::vector<ServiceCallStats> GetServiceCallStats();
+
+/// Writes the collected statistics to the log, most expensive calls first.
+void LogStats();
+
+} // namespace
+
+} // namespace
@@ -348,6 +348,7 @@ void GetSharedFont(Service::Interface* self) {
         // Instead, it should probably map the shared font as RO memory. We don't currently have
         // an easy way to do this, but the copy should be sufficient for now.
         memcpy(Memory::GetPointer(SHARED_FONT_VADDR), shared_font.data(), shared_font.size());
+        Memory::MarkRegionWritten(SHARED_FONT_VADDR, static_cast<u32>(shared_font.size()));
 
         cmd_buff[0] = 0x00440082;
         cmd_buff[1] = RESULT_SUCCESS.raw; // No error
@@ -490,6 +491,13 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x00500040, GetAppCpuTimeLimit,              "GetAppCpuTimeLimit"},
 };
 
+void DoState(PointerWrap& p) {
+    Kernel::DoObject(p, shared_font_mem);
+    Kernel::DoObject(p, lock);
+    Kernel::DoObject(p, notification_event);
+    Kernel::DoObject(p, pause_event);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Interface class
 
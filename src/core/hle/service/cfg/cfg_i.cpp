@@ -35,6 +35,7 @@ static void GetConfigInfoBlk8(Service::Interface* self) {
         return;
     }
 
+    Memory::MarkRegionWritten(cmd_buffer[4], size);
     cmd_buffer[1] = Service::CFG::GetConfigInfoBlock(block_id, size, 0x8, data_pointer).raw;
 }
 
@@ -33,6 +33,7 @@ static void GetConfigInfoBlk2(Service::Interface* self) {
         return;
     }
 
+    Memory::MarkRegionWritten(cmd_buffer[4], size);
     cmd_buffer[1] = Service::CFG::GetConfigInfoBlock(block_id, size, 0x2, data_pointer).raw;
 }
 
@@ -58,6 +59,7 @@ static void GetConfigInfoBlk8(Service::Interface* self) {
         return;
     }
 
+    Memory::MarkRegionWritten(cmd_buffer[4], size);
     cmd_buffer[1] = Service::CFG::GetConfigInfoBlock(block_id, size, 0x8, data_pointer).raw;
 }
 
@@ -256,6 +256,12 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x00210000, nullptr,                          "GetIsDspOccupied"},
 };
 
+void DoState(PointerWrap& p) {
+    p.Do(read_pipe_count);
+    Kernel::DoObject(p, semaphore_event);
+    Kernel::DoObject(p, interrupt_event);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Interface class
 
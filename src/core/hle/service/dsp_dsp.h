@@ -23,4 +23,7 @@ public:
 /// Signals that a DSP interrupt has occurred to userland code
 void SignalInterrupt();
 
+/// Saves or loads the state of the service, for savestates
+void DoState(PointerWrap& p);
+
 } // namespace
@@ -2,15 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/make_unique.h"
 #include "common/math_util.h"
+#include "common/thread_pool.h"
+#include "common/timer.h"
 
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/archive_extsavedata.h"
@@ -19,8 +25,13 @@
 #include "core/file_sys/archive_savedatacheck.h"
 #include "core/file_sys/archive_sdmc.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/core_timing.h"
+#include "core/arm/arm_interface.h"
+#include "core/hle/hle.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/result.h"
+#include "core/settings.h"
 
 // Specializes std::hash for ArchiveIdCode, so that we can use it in std::unordered_map.
 // Workaroung for libstdc++ bug: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=60970
@@ -75,39 +86,178 @@ enum class DirectoryCommand : u32 {
     Close           = 0x08020000,
 };
 
+using IOClock = std::chrono::steady_clock;
+
+/// Number of words in the IPC command buffer
+static const size_t kCommandBufferWords = 0x40;
+
+// Emulated storage timing for asynchronous requests. Host I/O is usually a lot faster than the
+// actual hardware, so requests don't complete before the emulated time they'd take has passed.
+static const u64 kAsyncRequestLatencyUs = 100; ///< Fixed cost of each request
+static const u64 kAsyncBytesPerUs = 16;        ///< Transfer rate, i.e. 16 MB/s
+
+/// A file read or write which is performed on an I/O worker thread while the requesting thread waits
+struct AsyncFileRequest {
+    Kernel::SharedPtr<File> file;
+    Kernel::SharedPtr<Kernel::Thread> thread;
+    std::vector<u32> cmd_buff; ///< Copy of the request, which receives the reply
+    u64 completion_ticks;      ///< Emulated time at which the request completes at the earliest
+    u64 io_time_us;            ///< Host time the I/O took, set by the worker
+};
+
+/// Worker threads which perform asynchronous requests, only exists if those are enabled
+static std::unique_ptr<Common::ThreadPool> io_pool;
+static int async_completion_event_type = -1;
+
+/**
+ * Requests which are in flight or waiting for their emulated completion time. Only accessed from
+ * the emulation thread, workers just use the request they were handed.
+ */
+static std::unordered_map<u64, std::unique_ptr<AsyncFileRequest>> async_requests;
+static u64 next_async_request_id;
+
+/**
+ * Performs a Read or Write command on an I/O worker thread. The requesting thread waits until the
+ * CoreTiming event scheduled by the worker delivers the reply.
+ */
+static void QueueAsyncTransfer(File* file, const u32* cmd_buff) {
+    const u32 length = cmd_buff[3];
+
+    std::unique_ptr<AsyncFileRequest> request(new AsyncFileRequest);
+    request->file = file;
+    request->thread = Kernel::GetCurrentThread();
+    request->cmd_buff.assign(cmd_buff, cmd_buff + kCommandBufferWords);
+    request->completion_ticks = CoreTiming::GetTicks() +
+                                usToCycles(kAsyncRequestLatencyUs + length / kAsyncBytesPerUs);
+    request->io_time_us = 0;
+
+    const u64 request_id = next_async_request_id++;
+    AsyncFileRequest* worker_request = request.get();
+    async_requests.emplace(request_id, std::move(request));
+
+    io_pool->Push([worker_request, request_id] {
+        worker_request->io_time_us = worker_request->file->PerformTransfer(worker_request->cmd_buff.data());
+        CoreTiming::ScheduleEvent_Threadsafe(0, async_completion_event_type, request_id);
+    });
+
+    Kernel::WaitCurrentThread_IPC();
+    HLE::Reschedule(__func__);
+}
+
+static void AsyncRequestCallback(u64 request_id, int cycles_late) {
+    auto itr = async_requests.find(request_id);
+    if (itr == async_requests.end())
+        return;
+
+    AsyncFileRequest& request = *itr->second;
+
+    // The host I/O is done, but the emulated storage might still be busy
+    const u64 ticks = CoreTiming::GetTicks();
+    if (ticks < request.completion_ticks) {
+        CoreTiming::ScheduleEvent(request.completion_ticks - ticks, async_completion_event_type, request_id);
+        return;
+    }
+
+    request.file->FinishTransfer(request.cmd_buff.data(), request.io_time_us);
+
+    // The thread might have been terminated in the meantime
+    if (request.thread->status == THREADSTATUS_WAIT_IPC) {
+        request.thread->pending_ipc_reply = std::move(request.cmd_buff);
+        request.thread->ResumeFromWait();
+        HLE::Reschedule(__func__);
+    }
+
+    async_requests.erase(itr);
+}
+
+u64 File::PerformTransfer(u32* cmd_buff) {
+    std::lock_guard<std::mutex> lock(backend_mutex);
+    const auto start = IOClock::now();
+
+    const FileCommand cmd = static_cast<FileCommand>(cmd_buff[0]);
+    const u64 offset = cmd_buff[1] | ((u64)cmd_buff[2]) << 32;
+    const u32 length = cmd_buff[3];
+
+    // Backends transfer straight from or to emulated memory, without an intermediate buffer
+    if (cmd == FileCommand::Read) {
+        const u32 address = cmd_buff[5];
+        cmd_buff[2] = static_cast<u32>(backend->Read(offset, length, Memory::GetPointer(address)));
+    } else {
+        const u32 flush = cmd_buff[4];
+        const u32 address = cmd_buff[6];
+        cmd_buff[2] = static_cast<u32>(backend->Write(offset, length, flush, Memory::GetPointer(address)));
+    }
+    cmd_buff[1] = RESULT_SUCCESS.raw;
+
+    return Common::MicrosecondsSince(start);
+}
+
+void File::FinishTransfer(const u32* cmd_buff, u64 io_time_us) {
+    const FileCommand cmd = static_cast<FileCommand>(cmd_buff[0]);
+    if (cmd == FileCommand::Read) {
+        io_stats->reads++;
+        io_stats->bytes_read += cmd_buff[2];
+        io_stats->read_time_us += io_time_us;
+    } else {
+        io_stats->writes++;
+        io_stats->bytes_written += cmd_buff[2];
+        io_stats->write_time_us += io_time_us;
+    }
+}
+
 ResultVal<bool> File::SyncRequest() {
     u32* cmd_buff = Kernel::GetCommandBuffer();
     FileCommand cmd = static_cast<FileCommand>(cmd_buff[0]);
+
+    // Files which couldn't be reopened when loading a savestate have no backend
+    if (backend == nullptr) {
+        LOG_ERROR(Service_FS, "Command 0x%08X on file %s which is no longer open", static_cast<u32>(cmd), GetName().c_str());
+        cmd_buff[1] = ResultCode(ErrorDescription::FS_NotFound, ErrorModule::FS,
+                                 ErrorSummary::NotFound, ErrorLevel::Status).raw;
+        return MakeResult<bool>(false);
+    }
+
     switch (cmd) {
 
         // Read from file...
         case FileCommand::Read:
         {
-            u64 offset = cmd_buff[1] | ((u64)cmd_buff[2]) << 32;
             u32 length = cmd_buff[3];
             u32 address = cmd_buff[5];
             LOG_TRACE(Service_FS, "Read %s %s: offset=0x%llx length=%d address=0x%x",
-                      GetTypeName().c_str(), GetName().c_str(), offset, length, address);
-            cmd_buff[2] = static_cast<u32>(backend->Read(offset, length, Memory::GetPointer(address)));
+                      GetTypeName().c_str(), GetName().c_str(),
+                      (unsigned long long)(cmd_buff[1] | ((u64)cmd_buff[2]) << 32), length, address);
+            // Marked up front, asynchronous reads must not slip past a savestate captured meanwhile
+            Memory::MarkRegionWritten(address, length);
+            if (io_pool != nullptr) {
+                QueueAsyncTransfer(this, cmd_buff);
+                return MakeResult<bool>(true);
+            }
+
+            FinishTransfer(cmd_buff, PerformTransfer(cmd_buff));
             break;
         }
 
         // Write to file...
         case FileCommand::Write:
         {
-            u64 offset = cmd_buff[1] | ((u64)cmd_buff[2]) << 32;
-            u32 length = cmd_buff[3];
-            u32 flush = cmd_buff[4];
-            u32 address = cmd_buff[6];
             LOG_TRACE(Service_FS, "Write %s %s: offset=0x%llx length=%d address=0x%x, flush=0x%x",
-                      GetTypeName().c_str(), GetName().c_str(), offset, length, address, flush);
-            cmd_buff[2] = static_cast<u32>(backend->Write(offset, length, flush, Memory::GetPointer(address)));
+                      GetTypeName().c_str(), GetName().c_str(),
+                      (unsigned long long)(cmd_buff[1] | ((u64)cmd_buff[2]) << 32),
+                      cmd_buff[3], cmd_buff[6], cmd_buff[4]);
+            if (io_pool != nullptr) {
+                QueueAsyncTransfer(this, cmd_buff);
+                return MakeResult<bool>(true);
+            }
+
+            FinishTransfer(cmd_buff, PerformTransfer(cmd_buff));
             break;
         }
 
         case FileCommand::GetSize:
         {
             LOG_TRACE(Service_FS, "GetSize %s %s", GetTypeName().c_str(), GetName().c_str());
+            std::lock_guard<std::mutex> lock(backend_mutex);
             u64 size = backend->GetSize();
             cmd_buff[2] = (u32)size;
             cmd_buff[3] = size >> 32;
@@ -118,7 +268,8 @@ ResultVal<bool> File::SyncRequest() {
         {
             u64 size = cmd_buff[1] | ((u64)cmd_buff[2] << 32);
             LOG_TRACE(Service_FS, "SetSize %s %s size=%llu",
-                GetTypeName().c_str(), GetName().c_str(), size);
+                GetTypeName().c_str(), GetName().c_str(), (unsigned long long)size);
+            std::lock_guard<std::mutex> lock(backend_mutex);
             backend->SetSize(size);
             break;
         }
@@ -126,6 +277,7 @@ ResultVal<bool> File::SyncRequest() {
         case FileCommand::Close:
         {
             LOG_TRACE(Service_FS, "Close %s %s", GetTypeName().c_str(), GetName().c_str());
+            std::lock_guard<std::mutex> lock(backend_mutex);
             backend->Close();
             break;
         }
@@ -133,6 +285,7 @@ ResultVal<bool> File::SyncRequest() {
         case FileCommand::Flush:
         {
             LOG_TRACE(Service_FS, "Flush");
+            std::lock_guard<std::mutex> lock(backend_mutex);
             backend->Flush();
             break;
         }
@@ -172,6 +325,14 @@ ResultVal<bool> File::SyncRequest() {
 ResultVal<bool> Directory::SyncRequest() {
     u32* cmd_buff = Kernel::GetCommandBuffer();
     DirectoryCommand cmd = static_cast<DirectoryCommand>(cmd_buff[0]);
+
+    if (backend == nullptr) {
+        LOG_ERROR(Service_FS, "Command 0x%08X on directory %s which is no longer open", static_cast<u32>(cmd), GetName().c_str());
+        cmd_buff[1] = ResultCode(ErrorDescription::NotFound, ErrorModule::FS,
+                                 ErrorSummary::NotFound, ErrorLevel::Permanent).raw;
+        return MakeResult<bool>(false);
+    }
+
     switch (cmd) {
 
         // Read from directory...
@@ -180,6 +341,7 @@ ResultVal<bool> Directory::SyncRequest() {
             u32 count = cmd_buff[1];
             u32 address = cmd_buff[3];
             auto entries = reinterpret_cast<FileSys::Entry*>(Memory::GetPointer(address));
+            Memory::MarkRegionWritten(address, count * sizeof(FileSys::Entry));
             LOG_TRACE(Service_FS, "Read %s %s: count=%d",
                 GetTypeName().c_str(), GetName().c_str(), count);
 
@@ -221,15 +383,22 @@ static boost::container::flat_map<ArchiveIdCode, std::unique_ptr<ArchiveFactory>
  * Map of active archive handles. Values are pointers to the archives in `idcode_map`.
  */
 static std::unordered_map<ArchiveHandle, std::unique_ptr<ArchiveBackend>> handle_map;
+/// Id codes the archives in `handle_map` were opened with
+static std::unordered_map<ArchiveHandle, ArchiveIdCode> handle_id_code_map;
+/// Paths the archives in `handle_map` were opened with, to reopen them when loading a savestate
+static std::unordered_map<ArchiveHandle, FileSys::Path> handle_path_map;
 static ArchiveHandle next_handle;
 
+/// I/O statistics per archive type. Only grows while the service is running, files keep references to entries
+static std::unordered_map<ArchiveIdCode, ArchiveIOStats> io_stats_map;
+
 static ArchiveBackend* GetArchive(ArchiveHandle handle) {
     auto itr = handle_map.find(handle);
     return (itr == handle_map.end()) ? nullptr : itr->second.get();
 }
 
 ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archive_path) {
-    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X", id_code);
+    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X", static_cast<u32>(id_code));
 
     auto itr = id_code_map.find(id_code);
     if (itr == id_code_map.end()) {
@@ -245,14 +414,18 @@ ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archi
         ++next_handle;
     }
     handle_map.emplace(next_handle, std::move(res));
+    handle_id_code_map.emplace(next_handle, id_code);
+    handle_path_map.emplace(next_handle, archive_path);
     return MakeResult<ArchiveHandle>(next_handle++);
 }
 
 ResultCode CloseArchive(ArchiveHandle handle) {
     if (handle_map.erase(handle) == 0)
         return ERR_INVALID_HANDLE;
-    else
-        return RESULT_SUCCESS;
+
+    handle_id_code_map.erase(handle);
+    handle_path_map.erase(handle);
+    return RESULT_SUCCESS;
 }
 
 // TODO(yuriks): This might be what the fs:REG service is for. See the Register/Unregister calls in
@@ -264,7 +437,8 @@ ResultCode RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factor
     ASSERT_MSG(inserted, "Tried to register more than one archive with same id code");
 
     auto& archive = result.first->second;
-    LOG_DEBUG(Service_FS, "Registered archive %s with id code 0x%08X", archive->GetName().c_str(), id_code);
+    LOG_DEBUG(Service_FS, "Registered archive %s with id code 0x%08X", archive->GetName().c_str(),
+              static_cast<u32>(id_code));
     return RESULT_SUCCESS;
 }
 
@@ -280,10 +454,58 @@ ResultVal<Kernel::SharedPtr<File>> OpenFileFromArchive(ArchiveHandle archive_han
                           ErrorSummary::NotFound, ErrorLevel::Status);
     }
 
-    auto file = Kernel::SharedPtr<File>(new File(std::move(backend), path));
+    // Value-initialization zeroes the statistics of archive types which weren't used before
+    ArchiveIOStats& io_stats = io_stats_map[handle_id_code_map[archive_handle]];
+
+    auto file = Kernel::SharedPtr<File>(new File(std::move(backend), archive_handle, path, mode, io_stats));
     return MakeResult<Kernel::SharedPtr<File>>(std::move(file));
 }
 
+Kernel::SharedPtr<File> File::CreateForLoad() {
+    return Kernel::SharedPtr<File>(new File);
+}
+
+void File::DoState(PointerWrap& p) {
+    Session::DoState(p);
+    p.Do(archive_handle);
+    path.DoState(p);
+    p.Do(mode.hex);
+    p.Do(priority);
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        return;
+
+    io_stats = &io_stats_map[handle_id_code_map[archive_handle]];
+    ArchiveBackend* archive = GetArchive(archive_handle);
+    if (archive != nullptr)
+        backend = archive->OpenFile(path, mode);
+    if (backend == nullptr)
+        LOG_WARNING(Service_FS, "Couldn't reopen file %s from a savestate", path.DebugStr().c_str());
+}
+
+Kernel::SharedPtr<Directory> Directory::CreateForLoad() {
+    return Kernel::SharedPtr<Directory>(new Directory);
+}
+
+void Directory::DoState(PointerWrap& p) {
+    Session::DoState(p);
+    p.Do(archive_handle);
+    path.DoState(p);
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        return;
+
+    ArchiveBackend* archive = GetArchive(archive_handle);
+    if (archive != nullptr)
+        backend = archive->OpenDirectory(path);
+    if (backend == nullptr)
+        LOG_WARNING(Service_FS, "Couldn't reopen directory %s from a savestate", path.DebugStr().c_str());
+}
+
+std::vector<std::pair<ArchiveIdCode, ArchiveIOStats>> GetArchiveIOStats() {
+    return std::vector<std::pair<ArchiveIdCode, ArchiveIOStats>>(io_stats_map.begin(), io_stats_map.end());
+}
+
 ResultCode DeleteFileFromArchive(ArchiveHandle archive_handle, const FileSys::Path& path) {
     ArchiveBackend* archive = GetArchive(archive_handle);
     if (archive == nullptr)
@@ -379,7 +601,7 @@ ResultVal<Kernel::SharedPtr<Directory>> OpenDirectoryFromArchive(ArchiveHandle a
                           ErrorSummary::NotFound, ErrorLevel::Permanent);
     }
 
-    auto directory = Kernel::SharedPtr<Directory>(new Directory(std::move(backend), path));
+    auto directory = Kernel::SharedPtr<Directory>(new Directory(std::move(backend), archive_handle, path));
     return MakeResult<Kernel::SharedPtr<Directory>>(std::move(directory));
 }
 
@@ -414,10 +636,98 @@ ResultCode CreateExtSaveData(u32 high, u32 low) {
     return RESULT_SUCCESS;
 }
 
+void WaitForAsyncTransfers() {
+    if (io_pool != nullptr)
+        io_pool->WaitForIdle();
+}
+
+void ArchiveDoState(PointerWrap& p) {
+    WaitForAsyncTransfers();
+
+    p.Do(next_handle);
+
+    std::vector<ArchiveHandle> handles;
+    for (const auto& entry : handle_map)
+        handles.push_back(entry.first);
+    p.Do(handles);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        handle_map.clear();
+        handle_id_code_map.clear();
+        handle_path_map.clear();
+    }
+
+    for (ArchiveHandle handle : handles) {
+        ArchiveIdCode id_code = handle_id_code_map[handle];
+        FileSys::Path& archive_path = handle_path_map[handle];
+        p.Do(id_code);
+        archive_path.DoState(p);
+
+        if (p.GetMode() != PointerWrap::MODE_READ)
+            continue;
+
+        handle_id_code_map[handle] = id_code;
+        auto itr = id_code_map.find(id_code);
+        if (itr != id_code_map.end()) {
+            auto archive = itr->second->Open(archive_path);
+            if (archive.Succeeded()) {
+                handle_map.emplace(handle, std::move(*archive));
+                continue;
+            }
+        }
+        LOG_WARNING(Service_FS, "Couldn't reopen archive with id code 0x%08X from a savestate",
+                    static_cast<u32>(id_code));
+    }
+
+    // The workers are idle, so only requests waiting for their emulated completion time are left
+    u32 num_requests = static_cast<u32>(async_requests.size());
+    p.Do(num_requests);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        async_requests.clear();
+        for (u32 i = 0; i < num_requests; ++i) {
+            u64 request_id;
+            std::unique_ptr<AsyncFileRequest> request(new AsyncFileRequest);
+            p.Do(request_id);
+            Kernel::DoObject(p, request->file);
+            Kernel::DoObject(p, request->thread);
+            p.Do(request->cmd_buff);
+            p.Do(request->completion_ticks);
+            p.Do(request->io_time_us);
+            async_requests.emplace(request_id, std::move(request));
+        }
+    } else {
+        for (auto& entry : async_requests) {
+            u64 request_id = entry.first;
+            AsyncFileRequest& request = *entry.second;
+            p.Do(request_id);
+            Kernel::DoObject(p, request.file);
+            Kernel::DoObject(p, request.thread);
+            p.Do(request.cmd_buff);
+            p.Do(request.completion_ticks);
+            p.Do(request.io_time_us);
+        }
+    }
+    p.Do(next_async_request_id);
+}
+
 /// Initialize archives
 void ArchiveInit() {
+    io_stats_map.clear();
+
+    if (Settings::values.use_async_fs) {
+        async_completion_event_type = CoreTiming::RegisterEvent("FS::AsyncRequestCallback", AsyncRequestCallback);
+        io_pool.reset(new Common::ThreadPool(2, "FS I/O"));
+    }
+
     next_handle = 1;
 
+    Kernel::RegisterObjectFactory("File", [](const std::string& name) -> Kernel::SharedPtr<Kernel::Object> {
+        return File::CreateForLoad();
+    });
+    Kernel::RegisterObjectFactory("Directory", [](const std::string& name) -> Kernel::SharedPtr<Kernel::Object> {
+        return Directory::CreateForLoad();
+    });
+
     // TODO(Subv): Add the other archive types (see here for the known types:
     // http://3dbrew.org/wiki/FS:OpenArchive#Archive_idcodes).
 
@@ -453,7 +763,25 @@ void ArchiveInit() {
 
 /// Shutdown archives
 void ArchiveShutdown() {
+    // Lets the workers finish, they access emulated memory and the files of the requests
+    io_pool.reset();
+    async_requests.clear();
+
+    for (const auto& entry : io_stats_map) {
+        const ArchiveIOStats& stats = entry.second;
+        LOG_DEBUG(Service_FS, "Archive 0x%08X: %llu reads (%llu bytes, %llu us), %llu writes (%llu bytes, %llu us)",
+                  static_cast<u32>(entry.first),
+                  static_cast<unsigned long long>(stats.reads),
+                  static_cast<unsigned long long>(stats.bytes_read),
+                  static_cast<unsigned long long>(stats.read_time_us),
+                  static_cast<unsigned long long>(stats.writes),
+                  static_cast<unsigned long long>(stats.bytes_written),
+                  static_cast<unsigned long long>(stats.write_time_us));
+    }
+
     handle_map.clear();
+    handle_id_code_map.clear();
+    handle_path_map.clear();
     id_code_map.clear();
 }
 
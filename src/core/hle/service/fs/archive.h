@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "common/common_types.h"
 
 #include "core/file_sys/archive_backend.h"
@@ -37,33 +41,85 @@ enum class ArchiveIdCode : u32 {
 
 typedef u64 ArchiveHandle;
 
+/// Host I/O statistics of all files opened from archives of one type
+struct ArchiveIOStats {
+    u64 reads;          ///< Number of read requests
+    u64 bytes_read;
+    u64 read_time_us;   ///< Total host time spent handling read requests
+    u64 writes;         ///< Number of write requests
+    u64 bytes_written;
+    u64 write_time_us;  ///< Total host time spent handling write requests
+};
+
 class File : public Kernel::Session {
 public:
-    File(std::unique_ptr<FileSys::FileBackend>&& backend, const FileSys::Path& path)
-        : path(path), priority(0), backend(std::move(backend)) {
+    File(std::unique_ptr<FileSys::FileBackend>&& backend, ArchiveHandle archive_handle,
+         const FileSys::Path& path, const FileSys::Mode mode, ArchiveIOStats& io_stats)
+        : archive_handle(archive_handle), path(path), mode(mode), priority(0),
+          backend(std::move(backend)), io_stats(&io_stats) {
     }
 
+    /// Creates a file without a backend, for its state to be loaded from a savestate
+    static Kernel::SharedPtr<File> CreateForLoad();
+
+    std::string GetTypeName() const override { return "File"; }
     std::string GetName() const override { return "Path: " + path.DebugStr(); }
 
+    ArchiveHandle archive_handle; ///< Archive the file was opened from
     FileSys::Path path; ///< Path of the file
+    FileSys::Mode mode; ///< Mode the file was opened with
     u32 priority; ///< Priority of the file. TODO(Subv): Find out what this means
     std::unique_ptr<FileSys::FileBackend> backend; ///< File backend interface
+    ArchiveIOStats* io_stats; ///< Statistics of the archive type the file was opened from
+
+    /// Held while the backend is used, which may happen on an I/O worker thread
+    std::mutex backend_mutex;
 
     ResultVal<bool> SyncRequest() override;
+
+    /// Saves or loads the file, which is reopened from its archive when loading.
+    void DoState(PointerWrap& p) override;
+
+    /**
+     * Performs the host side of a Read or Write command and writes the reply into the given
+     * command buffer. Only accesses the backend, so it may run on an I/O worker thread.
+     * @return Host time the transfer took, in microseconds
+     */
+    u64 PerformTransfer(u32* cmd_buff);
+
+    /// Bookkeeping on the emulation thread for a transfer done by PerformTransfer.
+    void FinishTransfer(const u32* cmd_buff, u64 io_time_us);
+
+private:
+    File() : archive_handle(0), priority(0), io_stats(nullptr) {
+        mode.hex = 0;
+    }
 };
 
 class Directory : public Kernel::Session {
 public:
-    Directory(std::unique_ptr<FileSys::DirectoryBackend>&& backend, const FileSys::Path& path)
-        : path(path), backend(std::move(backend)) {
+    Directory(std::unique_ptr<FileSys::DirectoryBackend>&& backend, ArchiveHandle archive_handle,
+              const FileSys::Path& path)
+        : archive_handle(archive_handle), path(path), backend(std::move(backend)) {
     }
 
+    /// Creates a directory without a backend, for its state to be loaded from a savestate
+    static Kernel::SharedPtr<Directory> CreateForLoad();
+
+    std::string GetTypeName() const override { return "Directory"; }
     std::string GetName() const override { return "Directory: " + path.DebugStr(); }
 
+    ArchiveHandle archive_handle; ///< Archive the directory was opened from
     FileSys::Path path; ///< Path of the directory
     std::unique_ptr<FileSys::DirectoryBackend> backend; ///< File backend interface
 
     ResultVal<bool> SyncRequest() override;
+
+    /// Saves or loads the directory, which is reopened from its archive when loading.
+    void DoState(PointerWrap& p) override;
+
+private:
+    Directory() : archive_handle(0) {}
 };
 
 /**
@@ -97,6 +153,12 @@ ResultCode RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factor
 ResultVal<Kernel::SharedPtr<File>> OpenFileFromArchive(ArchiveHandle archive_handle,
         const FileSys::Path& path, const FileSys::Mode mode);
 
+/**
+ * Returns the host I/O statistics of all archive types which had files opened from them, since
+ * the FS service was initialized
+ */
+std::vector<std::pair<ArchiveIdCode, ArchiveIOStats>> GetArchiveIOStats();
+
 /**
  * Delete a File from an Archive
  * @param archive_handle Handle to an open Archive object
@@ -178,6 +240,16 @@ ResultCode FormatArchive(ArchiveIdCode id_code, const FileSys::Path& path = File
  */
 ResultCode CreateExtSaveData(u32 high, u32 low);
 
+/// Blocks until the I/O workers have finished all asynchronous transfers which were queued
+void WaitForAsyncTransfers();
+
+/**
+ * Saves or loads the opened archives and the asynchronous requests, for savestates. Archives are
+ * reopened from their archive types when loading. Has to run before the kernel objects are
+ * serialized, since files reopen their backends from the archives.
+ */
+void ArchiveDoState(PointerWrap& p);
+
 /// Initialize archives
 void ArchiveInit();
 
@@ -186,6 +186,7 @@ static void ReadHWRegs(Service::Interface* self) {
     }
 
     u32* dst = (u32*)Memory::GetPointer(cmd_buff[0x41]);
+    Memory::MarkRegionWritten(cmd_buff[0x41], size);
 
     while (size > 0) {
         GPU::Read<u32>(*dst, reg_addr + 0x1EB00000);
@@ -343,6 +344,7 @@ static void ExecuteCommand(const Command& command, u32 thread_id) {
         memcpy(Memory::GetPointer(command.dma_request.dest_address),
                Memory::GetPointer(command.dma_request.source_address),
                command.dma_request.size);
+        Memory::MarkRegionWritten(command.dma_request.dest_address, command.dma_request.size);
         SignalInterrupt(InterruptId::DMA);
         break;
 
@@ -483,6 +485,12 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x001F0082, nullptr,                       "StoreDataCache"},
 };
 
+void DoState(PointerWrap& p) {
+    Kernel::DoObject(p, g_interrupt_event);
+    Kernel::DoObject(p, g_shared_memory);
+    p.Do(g_thread_id);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Interface class
 
@@ -170,4 +170,7 @@ public:
  */
 void SignalInterrupt(InterruptId interrupt_id);
 
+/// Saves or loads the state of the service, for savestates
+void DoState(PointerWrap& p);
+
 } // namespace
@@ -138,5 +138,19 @@ void HIDShutdown() {
 
 }
 
+void HIDDoState(PointerWrap& p) {
+    Kernel::DoObject(p, g_shared_mem);
+    Kernel::DoObject(p, g_event_pad_or_touch_1);
+    Kernel::DoObject(p, g_event_pad_or_touch_2);
+    Kernel::DoObject(p, g_event_accelerometer);
+    Kernel::DoObject(p, g_event_gyroscope);
+    Kernel::DoObject(p, g_event_debug_pad);
+
+    p.DoVoid(&next_state, sizeof(next_state));
+    p.Do(next_index);
+    p.Do(next_circle_x);
+    p.Do(next_circle_y);
+}
+
 }
 }
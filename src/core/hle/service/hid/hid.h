@@ -112,5 +112,8 @@ void PadUpdateComplete();
 void HIDInit();
 void HIDShutdown();
 
+/// Saves or loads the state of the HID module, for savestates
+void HIDDoState(PointerWrap& p);
+
 }
 }
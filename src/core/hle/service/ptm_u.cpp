@@ -132,6 +132,11 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x000F0084, nullptr,               "GetStepHistoryAll"},
 };
 
+void DoState(PointerWrap& p) {
+    p.Do(shell_open);
+    p.Do(battery_is_charging);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Interface class
 
@@ -5,6 +5,9 @@
 #include "common/common.h"
 #include "common/string_util.h"
 
+#include "core/core.h"
+#include "core/arm/arm_interface.h"
+#include "core/hle/hle.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/ac_u.h"
 #include "core/hle/service/act_u.h"
@@ -24,6 +27,7 @@
 #include "core/hle/service/cfg/cfg_u.h"
 #include "core/hle/service/csnd_snd.h"
 #include "core/hle/service/dsp_dsp.h"
+#include "core/hle/service/hid/hid.h"
 #include "core/hle/service/err_f.h"
 #include "core/hle/service/fs/fs_user.h"
 #include "core/hle/service/frd_a.h"
@@ -57,14 +61,40 @@ namespace Service {
 std::unordered_map<std::string, Kernel::SharedPtr<Interface>> g_kernel_named_ports;
 std::unordered_map<std::string, Kernel::SharedPtr<Interface>> g_srv_services;
 
+void Interface::ExecuteFunction(const FunctionInfo& info) {
+    info.func(this);
+    Core::GetCurrentCore()->AddTicks(request_cost);
+}
+
+void Interface::ReportUnimplementedFunction(const FunctionInfo* info, const u32* cmd_buff) {
+    // Some games call unimplemented functions every frame, don't format anything nobody sees
+    if (!Log::IsLogEnabled(Log::Class::Service, Log::Level::Error))
+        return;
+
+    std::string function_name;
+    if (info == nullptr || info->name == nullptr) {
+        function_name = Common::StringFromFormat("0x%08X", cmd_buff[0]);
+    } else if (info->id != cmd_buff[0]) {
+        function_name = Common::StringFromFormat("%s (unexpected header 0x%08X, expected 0x%08X)",
+                                                 info->name, cmd_buff[0], info->id);
+    } else {
+        function_name = info->name;
+    }
+
+    LOG_ERROR(Service, "unknown / unimplemented %s",
+              MakeFunctionString(function_name.c_str(), GetPortName().c_str(), cmd_buff).c_str());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Module interface
 
 static void AddNamedPort(Interface* interface) {
+    interface->SetRequestCost(HLE::GetServiceCost(interface->GetPortName()));
     g_kernel_named_ports.emplace(interface->GetPortName(), interface);
 }
 
 static void AddService(Interface* interface) {
+    interface->SetRequestCost(HLE::GetServiceCost(interface->GetPortName()));
     g_srv_services.emplace(interface->GetPortName(), interface);
 }
 
@@ -117,6 +147,19 @@ void Init() {
     AddService(new SSL_C::Interface);
     AddService(new Y2R_U::Interface);
 
+    // Services are never recreated, savestates refer to them by their port name
+    Kernel::RegisterObjectFactory("Service", [](const std::string& name) -> Kernel::SharedPtr<Kernel::Object> {
+        auto itr = g_srv_services.find(name);
+        if (itr != g_srv_services.end())
+            return itr->second;
+
+        itr = g_kernel_named_ports.find(name);
+        if (itr != g_kernel_named_ports.end())
+            return itr->second;
+
+        return nullptr;
+    });
+
     LOG_DEBUG(Service, "initialized OK");
 }
 
@@ -127,5 +170,14 @@ void Shutdown() {
     LOG_DEBUG(Service, "shutdown OK");
 }
 
+void DoState(PointerWrap& p) {
+    APT_U::DoState(p);
+    DSP_DSP::DoState(p);
+    GSP_GPU::DoState(p);
+    HID::HIDDoState(p);
+    PTM_U::DoState(p);
+    SRV::DoState(p);
+}
+
 
 }
@@ -9,13 +9,12 @@
 #include <unordered_map>
 #include <vector>
 
-#include <boost/container/flat_map.hpp>
-
 #include "common/common.h"
 #include "common/string_util.h"
 #include "core/mem_map.h"
 
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/profiler.h"
 #include "core/hle/kernel/session.h"
 #include "core/hle/svc.h"
 
@@ -53,6 +52,7 @@ class Interface : public Kernel::Session {
 
 public:
     std::string GetName() const override { return GetPortName(); }
+    std::string GetTypeName() const override { return "Service"; }
 
     typedef void (*Function)(Interface*);
 
@@ -72,24 +72,39 @@ public:
 
     ResultVal<bool> SyncRequest() override {
         u32* cmd_buff = Kernel::GetCommandBuffer();
-        auto itr = m_functions.find(cmd_buff[0]);
+        const u32 header = cmd_buff[0];
+        const u32 command_id = header >> 16;
 
-        if (itr == m_functions.end() || itr->second.func == nullptr) {
-            std::string function_name = (itr == m_functions.end()) ? Common::StringFromFormat("0x%08X", cmd_buff[0]) : itr->second.name;
-            LOG_ERROR(Service, "unknown / unimplemented %s", MakeFunctionString(function_name.c_str(), GetPortName().c_str(), cmd_buff).c_str());
+        // The command ID selects the function, the rest of the header must match its parameters
+        const FunctionInfo* info = (command_id < m_functions.size()) ? &m_functions[command_id] : nullptr;
+        if (info == nullptr || info->func == nullptr || info->id != header) {
+            ReportUnimplementedFunction(info, cmd_buff);
 
             // TODO(bunnei): Hack - ignore error
             cmd_buff[1] = 0;
             return MakeResult<bool>(false);
-        } else {
-            LOG_TRACE(Service, "%s", MakeFunctionString(itr->second.name, GetPortName().c_str(), cmd_buff).c_str());
         }
 
-        itr->second.func(this);
+        LOG_TRACE(Service, "%s", MakeFunctionString(info->name, GetPortName().c_str(), cmd_buff).c_str());
+
+        if (HLE::Profiler::IsEnabled()) {
+            auto sample = HLE::Profiler::Measure([this, info] { ExecuteFunction(*info); });
+            HLE::Profiler::RecordServiceCall(this, command_id, sample);
+        } else {
+            ExecuteFunction(*info);
+        }
 
         return MakeResult<bool>(false); // TODO: Implement return from actual function
     }
 
+    /**
+     * Sets the emulated CPU time charged for each request to this service
+     * @param ticks Cost in ARM11 ticks
+     */
+    void SetRequestCost(u32 ticks) {
+        request_cost = ticks;
+    }
+
 protected:
 
     /**
@@ -97,15 +112,30 @@ protected:
      */
     template <size_t N>
     void Register(const FunctionInfo (&functions)[N]) {
-        m_functions.reserve(N);
         for (auto& fn : functions) {
-            // Usually this array is sorted by id already, so hint to instead at the end
-            m_functions.emplace_hint(m_functions.cend(), fn.id, fn);
+            const u32 command_id = fn.id >> 16;
+            if (command_id >= m_functions.size())
+                m_functions.resize(command_id + 1, FunctionInfo{ 0, nullptr, nullptr });
+
+            m_functions[command_id] = fn;
         }
     }
 
 private:
-    boost::container::flat_map<u32, FunctionInfo> m_functions;
+    /// Runs the handler of a command and charges the emulated time it takes
+    void ExecuteFunction(const FunctionInfo& info);
+
+    /**
+     * Logs a request for a function which doesn't exist, isn't implemented or was called with an
+     * unexpected header. Kept out of line so that the request path doesn't do any formatting.
+     * @param info Registered function with the requested command ID, if any
+     * @param cmd_buff Command buffer of the request
+     */
+    void ReportUnimplementedFunction(const FunctionInfo* info, const u32* cmd_buff);
+
+    /// Registered functions, indexed by command ID (upper 16 bits of the command header)
+    std::vector<FunctionInfo> m_functions;
+    u32 request_cost = 0; ///< Emulated CPU time charged for each request, in ARM11 ticks
 
 };
 
@@ -115,6 +145,9 @@ void Init();
 /// Shutdown ServiceManager
 void Shutdown();
 
+/// Saves or loads the state of the services, for savestates. See FS::ArchiveDoState for FS.
+void DoState(PointerWrap& p);
+
 /// Map of named ports managed by the kernel, which can be retrieved using the ConnectToPort SVC.
 extern std::unordered_map<std::string, Kernel::SharedPtr<Interface>> g_kernel_named_ports;
 /// Map of services registered with the "srv:" service, retrieved using GetServiceHandle.
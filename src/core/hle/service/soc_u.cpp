@@ -534,6 +534,7 @@ static void RecvFrom(Service::Interface* self) {
     socklen_t addr_len = static_cast<socklen_t>(cmd_buffer[4]);
 
     u8* output_buff = Memory::GetPointer(cmd_buffer[0x104 >> 2]);
+    Memory::MarkRegionWritten(cmd_buffer[0x104 >> 2], len);
     sockaddr src_addr;
     socklen_t src_addr_len = sizeof(src_addr);
     int ret = ::recvfrom(socket_handle, (char*)output_buff, len, flags, &src_addr, &src_addr_len);
@@ -541,6 +542,7 @@ static void RecvFrom(Service::Interface* self) {
     if (cmd_buffer[0x1A0 >> 2] != 0) {
         CTRSockAddr* ctr_src_addr = reinterpret_cast<CTRSockAddr*>(Memory::GetPointer(cmd_buffer[0x1A0 >> 2]));
         *ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
+        Memory::MarkRegionWritten(cmd_buffer[0x1A0 >> 2], sizeof(CTRSockAddr));
     }
 
     int result = 0;
@@ -561,6 +563,7 @@ static void Poll(Service::Interface* self) {
     int timeout = cmd_buffer[2];
     CTRPollFD* input_fds = reinterpret_cast<CTRPollFD*>(Memory::GetPointer(cmd_buffer[6]));
     CTRPollFD* output_fds = reinterpret_cast<CTRPollFD*>(Memory::GetPointer(cmd_buffer[0x104 >> 2]));
+    Memory::MarkRegionWritten(cmd_buffer[0x104 >> 2], nfds * sizeof(CTRPollFD));
 
     // The 3ds_pollfd and the pollfd structures may be different (Windows/Linux have different sizes)
     // so we have to copy the data
@@ -597,6 +600,7 @@ static void GetSockName(Service::Interface* self) {
 
     if (ctr_dest_addr != nullptr) {
         *ctr_dest_addr = CTRSockAddr::FromPlatform(dest_addr);
+        Memory::MarkRegionWritten(cmd_buffer[0x104 >> 2], sizeof(CTRSockAddr));
     } else {
         cmd_buffer[1] = -1; // TODO(Subv): Verify error
         return;
@@ -636,6 +640,7 @@ static void GetPeerName(Service::Interface* self) {
 
     if (ctr_dest_addr != nullptr) {
         *ctr_dest_addr = CTRSockAddr::FromPlatform(dest_addr);
+        Memory::MarkRegionWritten(cmd_buffer[0x104 >> 2], sizeof(CTRSockAddr));
     } else {
         cmd_buffer[1] = -1;
         return;
@@ -59,6 +59,10 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x000C0080, nullptr,             "PublishToSubscriber"},
 };
 
+void DoState(PointerWrap& p) {
+    Kernel::DoObject(p, event_handle);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Interface class
 
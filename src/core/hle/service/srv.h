@@ -19,4 +19,7 @@ public:
     }
 };
 
+/// Saves or loads the state of the service, for savestates
+void DoState(PointerWrap& p);
+
 } // namespace
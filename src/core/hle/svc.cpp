@@ -306,7 +306,7 @@ static ResultCode GetResourceLimitCurrentValues(s64* values, Handle resource_lim
     s32 name_count) {
     LOG_ERROR(Kernel_SVC, "(UNIMPLEMENTED) called resource_limit=%08X, names=%s, name_count=%d",
         resource_limit, names, name_count);
-    Memory::Write32(Core::g_app_core->GetReg(0), 0); // Normmatt: Set used memory to 0 for now
+    Memory::Write32(Core::GetCurrentCore()->GetReg(0), 0); // Normmatt: Set used memory to 0 for now
     return RESULT_SUCCESS;
 }
 
@@ -330,7 +330,7 @@ static ResultCode CreateThread(u32* out_handle, u32 priority, u32 entry_point, u
         "threadpriority=0x%08X, processorid=0x%08X : created handle=0x%08X", entry_point,
         name.c_str(), arg, stack_top, priority, processor_id, *out_handle);
 
-    if (THREADPROCESSORID_1 == processor_id) {
+    if (THREADPROCESSORID_1 == processor_id && !Core::IsMultiCore()) {
         LOG_WARNING(Kernel_SVC,
             "thread designated for system CPU core (UNIMPLEMENTED) will be run with app core scheduling");
     }
@@ -340,7 +340,7 @@ static ResultCode CreateThread(u32* out_handle, u32 priority, u32 entry_point, u
 
 /// Called when a thread exits
 static void ExitThread() {
-    LOG_TRACE(Kernel_SVC, "called, pc=0x%08X", Core::g_app_core->GetPC());
+    LOG_TRACE(Kernel_SVC, "called, pc=0x%08X", Core::GetCurrentCore()->GetPC());
 
     Kernel::GetCurrentThread()->Stop();
     HLE::Reschedule(__func__);
@@ -551,7 +551,7 @@ static void SleepThread(s64 nanoseconds) {
 
 /// This returns the total CPU ticks elapsed since the CPU was powered-on
 static s64 GetSystemTick() {
-    return (s64)Core::g_app_core->GetTicks();
+    return (s64)Core::GetCurrentCore()->GetTicks();
 }
 
 /// Creates a memory block at the specified address with the specified permissions and size
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 
 #include "core/arm/arm_interface.h"
@@ -10,6 +13,7 @@
 #include "core/core.h"
 #include "core/mem_map.h"
 #include "core/core_timing.h"
+#include "core/speed_limiter.h"
 
 #include "core/hle/hle.h"
 #include "core/hle/service/gsp_gpu.h"
@@ -18,6 +22,8 @@
 #include "core/hw/gpu.h"
 
 #include "video_core/command_processor.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/debug_utils/pica_trace_file.h"
 #include "video_core/video_core.h"
 
 
@@ -37,6 +43,26 @@ static u64 frame_count;
 /// True if the last frame was skipped
 static bool last_skip_frame = false;
 
+/// Number of frames between automatic frame skip adjustments
+static const int kAutoFrameSkipInterval = 15;
+/// Weight of the most recent frame in the frame time averages
+static const double kFrameTimeSmoothing = 1.0 / 8;
+/// Fraction of the frame budget that must remain free before rendering more frames again
+static const double kAutoFrameSkipHysteresis = 0.9;
+/// Frames taking longer than this many frame budgets (e.g. due to pausing) are not measured
+static const double kMaxMeasuredFrameBudgets = 8.0;
+
+/// Total time the speed limiter had throttled emulation at the last VBlank
+static u64 last_vblank_throttled_us;
+/// Average host time in milliseconds taken by rendered frames
+static double rendered_frame_time;
+/// Average host time in milliseconds taken by skipped frames
+static double skipped_frame_time;
+/// Number of frames skipped per rendered frame in automatic frame skip mode
+static int auto_skip_level;
+/// Number of frames measured since the last automatic frame skip adjustment
+static int frames_since_adjustment;
+
 template <typename T>
 inline void Read(T &var, const u32 raw_addr) {
     u32 addr = raw_addr - 0x1EF00000;
@@ -94,6 +120,11 @@ inline void Write(u32 addr, const T data) {
                     *ptr = config.value_16bit;
             }
 
+            Memory::MarkRegionWritten(Memory::PhysicalToVirtualAddress(config.GetStartAddress()),
+                                      config.GetEndAddress() - config.GetStartAddress());
+            Pica::DebugUtils::RecordPicaMemoryWrite(config.GetStartAddress(),
+                                                    config.GetEndAddress() - config.GetStartAddress());
+
             LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(), config.GetEndAddress());
 
             config.trigger = 0;
@@ -175,6 +206,11 @@ inline void Write(u32 addr, const T data) {
                 }
             }
 
+            const u32 output_size = config.output_height * output_width * Regs::BytesPerPixel(config.output_format);
+            Memory::MarkRegionWritten(Memory::PhysicalToVirtualAddress(config.GetPhysicalOutputAddress()),
+                                      output_size);
+            Pica::DebugUtils::RecordPicaMemoryWrite(config.GetPhysicalOutputAddress(), output_size);
+
             LOG_TRACE(HW_GPU, "DisplayTriggerTransfer: 0x%08x bytes from 0x%08x(%ux%u)-> 0x%08x(%ux%u), dst format %x",
                       config.output_height * output_width * 4,
                       config.GetPhysicalInputAddress(), (u32)config.input_width, (u32)config.input_height,
@@ -193,6 +229,7 @@ inline void Write(u32 addr, const T data) {
         if (config.trigger & 1)
         {
             u32* buffer = (u32*)Memory::GetPointer(Memory::PhysicalToVirtualAddress(config.GetPhysicalAddress()));
+            Pica::DebugUtils::RecordPicaCommandList(config.GetPhysicalAddress(), config.size);
             Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
         }
         break;
@@ -215,21 +252,72 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
+/**
+ * Adjusts the automatic frame skip level based on the host time taken by the frame that just
+ * finished, such that emulation keeps up with the gpu_refresh_rate frame budget.
+ */
+static void UpdateAutoFrameSkip(double frame_time) {
+    const double frame_budget = 1000.0 / Settings::values.gpu_refresh_rate;
+    if (frame_time > kMaxMeasuredFrameBudgets * frame_budget)
+        return;
+
+    // g_skip_frame still refers to the frame that just finished
+    double& average = g_skip_frame ? skipped_frame_time : rendered_frame_time;
+    average += (frame_time - average) * kFrameTimeSmoothing;
+
+    if (++frames_since_adjustment < kAutoFrameSkipInterval)
+        return;
+    frames_since_adjustment = 0;
+
+    // Expected average host time per frame when skipping the given number of frames per rendered one
+    auto PredictFrameTime = [](int skip_level) {
+        return (rendered_frame_time + skip_level * skipped_frame_time) / (skip_level + 1);
+    };
+
+    const int max_skip_level = std::max(0, Settings::values.max_auto_frame_skip);
+    if (PredictFrameTime(auto_skip_level) > frame_budget && auto_skip_level < max_skip_level) {
+        ++auto_skip_level;
+        LOG_DEBUG(HW_GPU, "Increased automatic frame skip to %d", auto_skip_level);
+    } else if (auto_skip_level > 0 &&
+               PredictFrameTime(auto_skip_level - 1) < frame_budget * kAutoFrameSkipHysteresis) {
+        --auto_skip_level;
+        LOG_DEBUG(HW_GPU, "Decreased automatic frame skip to %d", auto_skip_level);
+    }
+}
+
 /// Update hardware
 static void VBlankCallback(u64 userdata, int cycles_late) {
     frame_count++;
     last_skip_frame = g_skip_frame;
-    g_skip_frame = (frame_count & Settings::values.frame_skip) != 0;
-
-    // Swap buffers based on the frameskip mode, which is a little bit tricky. When
-    // a frame is being skipped, nothing is being rendered to the internal framebuffer(s).
-    // So, we should only swap frames if the last frame was rendered. The rules are:
-    //  - If frameskip == 0 (disabled), always swap buffers
-    //  - If frameskip == 1, swap buffers every other frame (starting from the first frame)
-    //  - If frameskip > 1, swap buffers every frameskip^n frames (starting from the second frame)
-    if ((((Settings::values.frame_skip != 1) ^ last_skip_frame) && last_skip_frame != g_skip_frame) || 
-            Settings::values.frame_skip == 0) {
-        VideoCore::g_renderer->SwapBuffers();
+
+    Pica::DebugUtils::RecordPicaFrameEnd();
+
+    // Time spent sleeping in the speed limiter isn't part of the cost of emulating a frame
+    const u64 throttled_us = SpeedLimiter::GetThrottledTimeUs();
+    auto& frame_stats = VideoCore::g_renderer->GetFrameStats();
+    frame_stats.OnFrameEmulated(throttled_us - last_vblank_throttled_us);
+    last_vblank_throttled_us = throttled_us;
+
+    if (Settings::values.use_auto_frame_skip) {
+        UpdateAutoFrameSkip(frame_stats.GetResults().last_frame_time_ms);
+        g_skip_frame = (frame_count % (auto_skip_level + 1)) != 0;
+
+        // Only present frames which were actually rendered
+        if (!last_skip_frame)
+            VideoCore::g_renderer->SwapBuffers();
+    } else {
+        g_skip_frame = (frame_count & Settings::values.frame_skip) != 0;
+
+        // Swap buffers based on the frameskip mode, which is a little bit tricky. When
+        // a frame is being skipped, nothing is being rendered to the internal framebuffer(s).
+        // So, we should only swap frames if the last frame was rendered. The rules are:
+        //  - If frameskip == 0 (disabled), always swap buffers
+        //  - If frameskip == 1, swap buffers every other frame (starting from the first frame)
+        //  - If frameskip > 1, swap buffers every frameskip^n frames (starting from the second frame)
+        if ((((Settings::values.frame_skip != 1) ^ last_skip_frame) && last_skip_frame != g_skip_frame) ||
+                Settings::values.frame_skip == 0) {
+            VideoCore::g_renderer->SwapBuffers();
+        }
     }
 
     // Signal to GSP that GPU interrupt has occurred
@@ -249,6 +337,20 @@ static void VBlankCallback(u64 userdata, int cycles_late) {
     CoreTiming::ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
+void DoState(PointerWrap& p) {
+    p.DoVoid(&g_regs, sizeof(g_regs));
+    p.Do(g_skip_frame);
+    p.Do(frame_ticks);
+    p.Do(frame_count);
+    p.Do(last_skip_frame);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // Host timing starts over, frame times measured before loading don't apply anymore
+        last_vblank_throttled_us = SpeedLimiter::GetThrottledTimeUs();
+        frames_since_adjustment = 0;
+    }
+}
+
 /// Initialize hardware
 void Init() {
     auto& framebuffer_top = g_regs.framebuffer_config[0];
@@ -283,9 +385,17 @@ void Init() {
     last_skip_frame = false;
     g_skip_frame = false;
 
+    last_vblank_throttled_us = SpeedLimiter::GetThrottledTimeUs();
+    rendered_frame_time = 1000.0 / Settings::values.gpu_refresh_rate;
+    skipped_frame_time = 0.0;
+    auto_skip_level = 0;
+    frames_since_adjustment = 0;
+
     vblank_event = CoreTiming::RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     CoreTiming::ScheduleEvent(frame_ticks, vblank_event);
 
+    Pica::DebugUtils::DebugHooks::SetDumpingEnabled(Settings::values.dump_gpu_data);
+
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
@@ -9,6 +9,8 @@
 #include "common/common_types.h"
 #include "common/bit_field.h"
 
+class PointerWrap;
+
 namespace GPU {
 
 // Returns index corresponding to the Regs member labeled by field_name
@@ -297,6 +299,9 @@ void Read(T &var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/// Saves or loads the GPU registers and frame state, for savestates
+void DoState(PointerWrap& p);
+
 /// Initialize hardware
 void Init();
 
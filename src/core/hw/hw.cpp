@@ -4,6 +4,7 @@
 
 #include "common/common_types.h"
 
+#include "core/core.h"
 #include "core/hw/hw.h"
 #include "core/hw/gpu.h"
 
@@ -37,6 +38,8 @@ enum {
 
 template <typename T>
 inline void Read(T &var, const u32 addr) {
+    Core::KernelLock lock;
+
     switch (addr & 0xFFFFF000) {
 
     case VADDR_GPU:
@@ -50,6 +53,9 @@ inline void Read(T &var, const u32 addr) {
 
 template <typename T>
 inline void Write(u32 addr, const T data) {
+    // Register writes may signal interrupts and schedule events, which touches kernel state
+    Core::KernelLock lock;
+
     switch (addr & 0xFFFFF000) {
 
     case VADDR_GPU:
@@ -4,19 +4,19 @@
 
 #include <string>
 
-#include "common/make_unique.h"
+#include "common/timer.h"
 
-#include "core/file_sys/archive_romfs.h"
 #include "core/loader/3dsx.h"
 #include "core/loader/elf.h"
 #include "core/loader/ncch.h"
-#include "core/hle/service/fs/archive.h"
 #include "core/mem_map.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace Loader {
 
+BootTimings g_boot_timings;
+
 /**
  * Identifies the type of a bootable file
  * @param file open file
@@ -92,7 +92,16 @@ static const char* GetFileTypeString(FileType type) {
     return "unknown";
 }
 
-ResultStatus LoadFile(const std::string& filename) {
+/// Logs the boot timing breakdown of the application which was just loaded
+static void LogBootTimings() {
+    const BootTimings& timings = g_boot_timings;
+    LOG_INFO(Loader, "Loaded in %.1f ms (identify %.1f ms, headers %.1f ms, code %.1f ms, RomFS %.1f ms)",
+             timings.total_us / 1000.0, timings.identify_us / 1000.0, timings.headers_us / 1000.0,
+             timings.code_us / 1000.0, timings.romfs_us / 1000.0);
+}
+
+static ResultStatus LoadFileImpl(const std::string& filename) {
+    const auto identify_start = std::chrono::steady_clock::now();
     std::unique_ptr<FileUtil::IOFile> file(new FileUtil::IOFile(filename, "rb"));
     if (!file->IsOpen()) {
         LOG_ERROR(Loader, "Failed to load file %s", filename.c_str());
@@ -109,6 +118,7 @@ ResultStatus LoadFile(const std::string& filename) {
     }
 
     LOG_INFO(Loader, "Loading file %s as %s...", filename.c_str(), GetFileTypeString(type));
+    g_boot_timings.identify_us = Common::MicrosecondsSince(identify_start);
 
     switch (type) {
 
@@ -129,7 +139,6 @@ ResultStatus LoadFile(const std::string& filename) {
         // Load application and RomFS
         if (ResultStatus::Success == app_loader.Load()) {
             Kernel::g_program_id = app_loader.GetProgramId();
-            Service::FS::RegisterArchiveType(Common::make_unique<FileSys::ArchiveFactory_RomFS>(app_loader), Service::FS::ArchiveIdCode::RomFS);
             return ResultStatus::Success;
         }
         break;
@@ -159,4 +168,16 @@ ResultStatus LoadFile(const std::string& filename) {
     return ResultStatus::Error;
 }
 
+ResultStatus LoadFile(const std::string& filename) {
+    const auto start = std::chrono::steady_clock::now();
+    g_boot_timings = {};
+
+    ResultStatus result = LoadFileImpl(filename);
+
+    g_boot_timings.total_us = Common::MicrosecondsSince(start);
+    if (result == ResultStatus::Success)
+        LogBootTimings();
+    return result;
+}
+
 } // namespace Loader
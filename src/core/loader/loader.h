@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/common.h"
@@ -99,11 +100,34 @@ public:
         return ResultStatus::ErrorNotImplemented;
     }
 
+    /**
+     * Map the RomFS of the application into memory, so that it's only read as it's accessed
+     * @param view Reference to the mapping to set up
+     * @return ResultStatus result of function
+     */
+    virtual ResultStatus MapRomFS(FileUtil::MappedFileView& view) const {
+        return ResultStatus::ErrorNotImplemented;
+    }
+
 protected:
     std::unique_ptr<FileUtil::IOFile> file;
     bool                              is_loaded = false;
 };
 
+/**
+ * Host time spent in the phases of the last LoadFile call, in microseconds. Phases which run on a
+ * worker thread overlap with the other ones.
+ */
+struct BootTimings {
+    u64 identify_us; ///< Opening the file and identifying its type
+    u64 headers_us;  ///< Reading the headers of the application
+    u64 code_us;     ///< Reading and decompressing the code, runs on a worker thread
+    u64 romfs_us;    ///< Mapping or reading the RomFS and registering the RomFS archive
+    u64 total_us;
+};
+
+extern BootTimings g_boot_timings;
+
 /**
  * Identifies and loads a bootable file
  * @param filename String filename of bootable file
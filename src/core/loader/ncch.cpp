@@ -2,10 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <future>
 #include <memory>
 
+#include "common/file_util.h"
+#include "common/linear_disk_cache.h"
+#include "common/make_unique.h"
+#include "common/string_util.h"
+#include "common/timer.h"
+
+#include "core/file_sys/archive_romfs.h"
 #include "core/loader/ncch.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/service/fs/archive.h"
 #include "core/mem_map.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -23,7 +33,8 @@ static const int kBlockSize   = 0x200;    ///< Size of ExeFS blocks (in bytes)
  * @return Size of decompressed buffer
  */
 static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
-    u32 offset_size = *(u32*)(buffer + size - 4);
+    u32 offset_size;
+    std::memcpy(&offset_size, buffer + size - 4, sizeof(u32));
     return offset_size + size;
 }
 
@@ -36,61 +47,104 @@ static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
  * @return True on success, otherwise false
  */
 static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed, u32 decompressed_size) {
-    const u8* footer = compressed + compressed_size - 8;
-    u32 buffer_top_and_bottom = *reinterpret_cast<const u32*>(footer);
+    if (compressed_size < 8 || decompressed_size < compressed_size)
+        return false;
+
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, compressed + compressed_size - 8, sizeof(u32));
+    const u32 top = (buffer_top_and_bottom >> 24) & 0xFF;
+    const u32 bottom = buffer_top_and_bottom & 0xFFFFFF;
+    if (top > compressed_size || bottom > compressed_size)
+        return false;
+
     u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
-
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
-
-    while (index > stop_index) {
-       u8 control = compressed[--index];
-
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
-
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
+    u32 index = compressed_size - top;
+    const u32 stop_index = compressed_size - bottom;
+
+    // The data is decompressed backwards, on top of the uncompressed beginning of the buffer
+    std::memcpy(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
+
+    while (index > stop_index && out > 0) {
+        u8 control = compressed[--index];
+
+        // Fast path: Eight literals in a row are a plain block copy
+        if (control == 0 && index - stop_index >= 8 && out >= 8) {
+            index -= 8;
+            out -= 8;
+            std::memcpy(decompressed + out, compressed + index, 8);
+            continue;
+        }
+
+        for (unsigned i = 0; i < 8 && index > stop_index && out > 0; ++i, control <<= 1) {
+            if (!(control & 0x80)) {
                 decompressed[--out] = compressed[--index];
+                continue;
+            }
+
+            // Check if compression is out of bounds
+            if (index < 2)
+                return false;
+            index -= 2;
+
+            const u32 segment_info = compressed[index] | (compressed[index + 1] << 8);
+            const u32 segment_size = ((segment_info >> 12) & 15) + 3;
+            // Distance between each output byte and the byte it's copied from
+            const u32 distance = (segment_info & 0x0FFF) + 3;
+
+            // Check if compression is out of bounds
+            if (out < segment_size || out + distance > decompressed_size)
+                return false;
+
+            out -= segment_size;
+            u8* dest = decompressed + out;
+            if (distance >= segment_size) {
+                std::memcpy(dest, dest + distance, segment_size);
+            } else {
+                // The segment repeats bytes it produced itself, which have to be copied one by one
+                for (u32 j = segment_size; j-- > 0;)
+                    dest[j] = dest[j + distance];
             }
-            control <<= 1;
         }
     }
     return true;
 }
 
+/// Identifies a compressed ExeFS section in the decompressed code cache
+struct CodeCacheKey {
+    u64 program_id;
+    u8 section_hash[0x20]; ///< SHA-256 of the compressed section, as listed in the ExeFS header
+};
+
+/// Picks the entry matching a key out of a decompressed code cache file
+class CodeCacheReader : public LinearDiskCacheReader<CodeCacheKey, u8> {
+public:
+    CodeCacheReader(const CodeCacheKey& key, std::vector<u8>& buffer) : key(key), buffer(buffer) {}
+
+    void Read(const CodeCacheKey& entry_key, const u8* value, u32 value_size) override {
+        if (std::memcmp(&entry_key, &key, sizeof(key)) == 0) {
+            buffer.assign(value, value + value_size);
+            found = true;
+        }
+    }
+
+    bool found = false;
+
+private:
+    const CodeCacheKey& key;
+    std::vector<u8>& buffer;
+};
+
+/**
+ * Get the path of the file caching the decompressed code of an application. The cache is
+ * invalidated by the LinearDiskCache header whenever the emulator revision changes.
+ * @param program_id Program ID of the application
+ * @return Path of the cache file
+ */
+static std::string GetCodeCachePath(u64 program_id) {
+    return FileUtil::GetUserPath(D_CACHE_IDX) + Common::StringFromFormat("code_%016llX.bin", program_id);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // AppLoader_NCCH class
 
@@ -113,8 +167,23 @@ ResultStatus AppLoader_NCCH::LoadExec() const {
     if (!is_loaded)
         return ResultStatus::ErrorNotLoaded;
 
+    // Reading and decompressing the code takes the longest, so do it on a worker thread while the
+    // RomFS archive is set up here. Both only use positional reads and mappings of the file, which
+    // don't interfere. The archive is only registered once the code loaded successfully.
     std::vector<u8> code;
-    if (ResultStatus::Success == ReadCode(code)) {
+    std::future<ResultStatus> code_result = std::async(std::launch::async, [this, &code] {
+        const auto start = std::chrono::steady_clock::now();
+        ResultStatus result = ReadCode(code);
+        g_boot_timings.code_us = Common::MicrosecondsSince(start);
+        return result;
+    });
+
+    const auto romfs_start = std::chrono::steady_clock::now();
+    auto romfs_factory = Common::make_unique<FileSys::ArchiveFactory_RomFS>(*this);
+    g_boot_timings.romfs_us = Common::MicrosecondsSince(romfs_start);
+
+    if (ResultStatus::Success == code_result.get()) {
+        Service::FS::RegisterArchiveType(std::move(romfs_factory), Service::FS::ArchiveIdCode::RomFS);
         Memory::WriteBlock(entry_point, &code[0], code.size());
         Kernel::LoadExec(entry_point);
         return ResultStatus::Success;
@@ -136,10 +205,24 @@ ResultStatus AppLoader_NCCH::LoadSectionExeFS(const char* name, std::vector<u8>&
             LOG_DEBUG(Loader, "%d - offset: 0x%08X, size: 0x%08X, name: %s", section_number,
                       section.offset, section.size, section.name);
 
-            s64 section_offset = (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
-            file->Seek(section_offset, SEEK_SET);
+            u64 section_offset = (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
 
             if (is_compressed) {
+                // Decompressing takes a while, so try the decompressed code cache first
+                CodeCacheKey key = {};
+                key.program_id = GetProgramId();
+                std::memcpy(key.section_hash, exefs_header.hashes[kMaxSections - 1 - section_number],
+                            sizeof(key.section_hash));
+
+                FileUtil::CreateFullPath(FileUtil::GetUserPath(D_CACHE_IDX));
+                LinearDiskCache<CodeCacheKey, u8> code_cache;
+                CodeCacheReader cache_reader(key, buffer);
+                code_cache.OpenAndRead(GetCodeCachePath(key.program_id).c_str(), cache_reader);
+                if (cache_reader.found) {
+                    LOG_DEBUG(Loader, "Loaded decompressed %s from the code cache", name);
+                    return ResultStatus::Success;
+                }
+
                 // Section is compressed, read compressed .code section...
                 std::unique_ptr<u8[]> temp_buffer;
                 try {
@@ -148,18 +231,24 @@ ResultStatus AppLoader_NCCH::LoadSectionExeFS(const char* name, std::vector<u8>&
                     return ResultStatus::ErrorMemoryAllocationFailed;
                 }
 
-                if (file->ReadBytes(&temp_buffer[0], section.size) != section.size)
+                if (file->ReadAt(&temp_buffer[0], section.size, section_offset) != section.size)
                     return ResultStatus::Error;
 
+                if (section.size < 8)
+                    return ResultStatus::ErrorInvalidFormat;
+
                 // Decompress .code section...
                 u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
                 buffer.resize(decompressed_size);
                 if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
                     return ResultStatus::ErrorInvalidFormat;
+
+                code_cache.Append(key, &buffer[0], decompressed_size);
+                code_cache.Close();
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
-                if (file->ReadBytes(&buffer[0], section.size) != section.size)
+                if (file->ReadAt(&buffer[0], section.size, section_offset) != section.size)
                     return ResultStatus::Error;
             }
             return ResultStatus::Success;
@@ -175,27 +264,25 @@ ResultStatus AppLoader_NCCH::Load() {
     if (!file->IsOpen())
         return ResultStatus::Error;
 
-    // Reset read pointer in case this file has been read before.
-    file->Seek(0, SEEK_SET);
+    const auto headers_start = std::chrono::steady_clock::now();
 
-    if (file->ReadBytes(&ncch_header, sizeof(NCCH_Header)) != sizeof(NCCH_Header))
+    if (file->ReadAt(&ncch_header, sizeof(NCCH_Header), 0) != sizeof(NCCH_Header))
         return ResultStatus::Error;
 
     // Skip NCSD header and load first NCCH (NCSD is just a container of NCCH files)...
     if (MakeMagic('N', 'C', 'S', 'D') == ncch_header.magic) {
         LOG_WARNING(Loader, "Only loading the first (bootable) NCCH within the NCSD file!");
         ncch_offset = 0x4000;
-        file->Seek(ncch_offset, SEEK_SET);
-        file->ReadBytes(&ncch_header, sizeof(NCCH_Header));
+        file->ReadAt(&ncch_header, sizeof(NCCH_Header), ncch_offset);
     }
 
     // Verify we are loading the correct file type...
     if (MakeMagic('N', 'C', 'C', 'H') != ncch_header.magic)
         return ResultStatus::ErrorInvalidFormat;
 
-    // Read ExHeader...
+    // Read ExHeader, which directly follows the NCCH header...
 
-    if (file->ReadBytes(&exheader_header, sizeof(ExHeader_Header)) != sizeof(ExHeader_Header))
+    if (file->ReadAt(&exheader_header, sizeof(ExHeader_Header), ncch_offset + sizeof(NCCH_Header)) != sizeof(ExHeader_Header))
         return ResultStatus::Error;
 
     is_compressed = (exheader_header.codeset_info.flags.flag & 1) == 1;
@@ -213,11 +300,11 @@ ResultStatus AppLoader_NCCH::Load() {
     LOG_DEBUG(Loader, "ExeFS offset:    0x%08X", exefs_offset);
     LOG_DEBUG(Loader, "ExeFS size:      0x%08X", exefs_size);
 
-    file->Seek(exefs_offset + ncch_offset, SEEK_SET);
-    if (file->ReadBytes(&exefs_header, sizeof(ExeFs_Header)) != sizeof(ExeFs_Header))
+    if (file->ReadAt(&exefs_header, sizeof(ExeFs_Header), exefs_offset + ncch_offset) != sizeof(ExeFs_Header))
         return ResultStatus::Error;
 
     is_loaded = true; // Set state to loaded
+    g_boot_timings.headers_us = Common::MicrosecondsSince(headers_start);
 
     return LoadExec(); // Load the executable into memory for booting
 }
@@ -238,28 +325,49 @@ ResultStatus AppLoader_NCCH::ReadLogo(std::vector<u8>& buffer) const {
     return LoadSectionExeFS("logo", buffer);
 }
 
+bool AppLoader_NCCH::GetRomFSLocation(u32& offset, u32& size) const {
+    // Check if the NCCH has a RomFS...
+    if (ncch_header.romfs_offset == 0 || ncch_header.romfs_size == 0) {
+        LOG_DEBUG(Loader, "NCCH has no RomFS");
+        return false;
+    }
+
+    offset = ncch_offset + (ncch_header.romfs_offset * kBlockSize) + 0x1000;
+    size = (ncch_header.romfs_size * kBlockSize) - 0x1000;
+
+    LOG_DEBUG(Loader, "RomFS offset:    0x%08X", offset);
+    LOG_DEBUG(Loader, "RomFS size:      0x%08X", size);
+    return true;
+}
+
 ResultStatus AppLoader_NCCH::ReadRomFS(std::vector<u8>& buffer) const {
     if (!file->IsOpen())
         return ResultStatus::Error;
 
-    // Check if the NCCH has a RomFS...
-    if (ncch_header.romfs_offset != 0 && ncch_header.romfs_size != 0) {
-        u32 romfs_offset = ncch_offset + (ncch_header.romfs_offset * kBlockSize) + 0x1000;
-        u32 romfs_size = (ncch_header.romfs_size * kBlockSize) - 0x1000;
+    u32 romfs_offset, romfs_size;
+    if (!GetRomFSLocation(romfs_offset, romfs_size))
+        return ResultStatus::ErrorNotUsed;
 
-        LOG_DEBUG(Loader, "RomFS offset:    0x%08X", romfs_offset);
-        LOG_DEBUG(Loader, "RomFS size:      0x%08X", romfs_size);
+    buffer.resize(romfs_size);
 
-        buffer.resize(romfs_size);
+    if (file->ReadAt(&buffer[0], romfs_size, romfs_offset) != romfs_size)
+        return ResultStatus::Error;
 
-        file->Seek(romfs_offset, SEEK_SET);
-        if (file->ReadBytes(&buffer[0], romfs_size) != romfs_size)
-            return ResultStatus::Error;
+    return ResultStatus::Success;
+}
 
-        return ResultStatus::Success;
-    }
-    LOG_DEBUG(Loader, "NCCH has no RomFS");
-    return ResultStatus::ErrorNotUsed;
+ResultStatus AppLoader_NCCH::MapRomFS(FileUtil::MappedFileView& view) const {
+    if (!file->IsOpen())
+        return ResultStatus::Error;
+
+    u32 romfs_offset, romfs_size;
+    if (!GetRomFSLocation(romfs_offset, romfs_size))
+        return ResultStatus::ErrorNotUsed;
+
+    if (!view.Map(*file, romfs_offset, romfs_size))
+        return ResultStatus::Error;
+
+    return ResultStatus::Success;
 }
 
 u64 AppLoader_NCCH::GetProgramId() const {
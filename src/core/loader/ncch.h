@@ -196,6 +196,13 @@ public:
      */
     ResultStatus ReadRomFS(std::vector<u8>& buffer) const override;
 
+    /**
+     * Map the RomFS of the application into memory, so that it's only read as it's accessed
+     * @param view Reference to the mapping to set up
+     * @return ResultStatus result of function
+     */
+    ResultStatus MapRomFS(FileUtil::MappedFileView& view) const override;
+
     /*
      * Gets the program id from the NCCH header
      * @return u64 Program id
@@ -213,11 +220,19 @@ private:
     ResultStatus LoadSectionExeFS(const char* name, std::vector<u8>& buffer) const;
 
     /**
-     * Loads .code section into memory for booting
+     * Loads .code section into memory for booting and registers the RomFS archive
      * @return ResultStatus result of function
      */
     ResultStatus LoadExec() const;
 
+    /**
+     * Gets the location of the RomFS within the file
+     * @param offset Reference to store the offset of the RomFS
+     * @param size Reference to store the size of the RomFS
+     * @return True if the NCCH has a RomFS
+     */
+    bool GetRomFSLocation(u32& offset, u32& size) const;
+
     bool            is_compressed = false;
 
     u32             entry_point = 0;
@@ -78,6 +78,13 @@ void Init() {
         physical_fcram);
 }
 
+std::vector<MemoryRegion> GetMemoryRegions() {
+    std::vector<MemoryRegion> regions;
+    for (const MemoryView& view : g_views)
+        regions.push_back({ view.virtual_address, view.size, *view.out_ptr_low });
+    return regions;
+}
+
 void Shutdown() {
     u32 flags = 0;
     MemoryMap_Shutdown(g_views, kNumMemViews, flags, &arena);
@@ -4,16 +4,22 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/common.h"
 #include "common/common_types.h"
 
 #include "core/hle/kernel/kernel.h"
 
+class PointerWrap;
+
 namespace Memory {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 enum : u32 {
+    PAGE_BITS                   = 12,           ///< Granularity of memory write tracking
+    PAGE_SIZE                   = (1 << PAGE_BITS),
     BOOTROM_SIZE                = 0x00010000,   ///< Bootrom (super secret code/data @ 0x8000) size
     BOOTROM_PADDR               = 0x00000000,   ///< Bootrom physical address
     BOOTROM_PADDR_END           = (BOOTROM_PADDR + BOOTROM_SIZE),
@@ -110,6 +116,15 @@ struct MemoryBlock {
     const u32 GetVirtualAddress() const{
         return base_address + address;
     }
+
+    void DoState(PointerWrap& p);
+};
+
+/// A region of the emulated address space which is backed by host memory
+struct MemoryRegion {
+    VAddr vaddr;
+    u32 size;
+    u8* pointer; ///< Host memory backing the region
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -138,6 +153,15 @@ extern u8* g_exefs_code;    ///< ExeFS:/.code is loaded here
 void Init();
 void Shutdown();
 
+/// Returns the regions of emulated memory which are backed by host memory, e.g. for savestates.
+std::vector<MemoryRegion> GetMemoryRegions();
+
+/**
+ * Saves or loads the memory block mappings, for savestates. The contents of memory are not
+ * included, see GetMemoryRegions. Loading marks all of memory as written.
+ */
+void DoState(PointerWrap& p);
+
 template <typename T>
 inline void Read(T &var, VAddr addr);
 
@@ -160,6 +184,31 @@ void WriteBlock(VAddr addr, const u8* data, size_t size);
 
 u8* GetPointer(VAddr virtual_address);
 
+/**
+ * Marks a range of emulated memory as written. The Write* functions do this automatically, but
+ * code writing to emulated memory through a pointer returned by GetPointer (e.g. the GPU or DMA
+ * engines) needs to call this explicitly so that write tracking notices the change.
+ * @param addr Virtual address of the first written byte
+ * @param size Number of written bytes
+ */
+void MarkRegionWritten(VAddr addr, u32 size);
+
+/**
+ * Starts a new write tracking epoch. Any write happening after this call will be visible to
+ * IsRegionWrittenSince when passing the returned epoch.
+ * @return Identifier of the newly started epoch
+ */
+u32 BeginWriteEpoch();
+
+/**
+ * Checks whether any page of the given memory range has been written since the given epoch began.
+ * @param addr Virtual address of the first byte of the range
+ * @param size Size of the range in bytes
+ * @param epoch Epoch identifier as returned by BeginWriteEpoch. Passing 0 always returns true.
+ * @return True if the range may have been modified
+ */
+bool IsRegionWrittenSince(VAddr addr, u32 size, u32 epoch);
+
 /**
  * Maps a block of memory on the heap
  * @param size Size of block in bytes
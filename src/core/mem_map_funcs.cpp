@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <map>
 
+#include "common/chunk_file.h"
 #include "common/common.h"
 
 #include "core/mem_map.h"
@@ -17,6 +21,20 @@ static std::map<u32, MemoryBlock> heap_map;
 static std::map<u32, MemoryBlock> heap_linear_map;
 static std::map<u32, MemoryBlock> shared_map;
 
+// Both cores write to memory concurrently in multi-core mode, so the write tracking state is
+// atomic. Relaxed ordering suffices, epochs are only compared while neither core is running.
+
+/// Write tracking epoch each page of the virtual address space has last been written in
+static std::array<std::atomic<u32>, (1ull << 32) / PAGE_SIZE> page_write_epochs;
+/// Epoch that writes are currently tagged with. Pages start out in epoch 0.
+static std::atomic<u32> current_write_epoch(1);
+
+/// Tags a page as written in the current epoch
+static inline void TagPageWritten(u32 page) {
+    page_write_epochs[page].store(current_write_epoch.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+}
+
 /// Convert a physical address to virtual address
 VAddr PhysicalToVirtualAddress(const PAddr addr) {
     // Our memory interface read/write functions assume virtual addresses. Put any physical address
@@ -102,6 +120,9 @@ inline void Read(T &var, const VAddr vaddr) {
 
 template <typename T>
 inline void Write(const VAddr vaddr, const T data) {
+    // Tag both the first and last page touched, since unaligned writes may cross a page boundary
+    TagPageWritten(vaddr >> PAGE_BITS);
+    TagPageWritten((VAddr)(vaddr + sizeof(T) - 1) >> PAGE_BITS);
 
     // Kernel memory command buffer
     if (vaddr >= KERNEL_MEMORY_VADDR && vaddr < KERNEL_MEMORY_VADDR_END) {
@@ -181,6 +202,55 @@ u8 *GetPointer(const VAddr vaddr) {
     }
 }
 
+void MarkRegionWritten(const VAddr addr, const u32 size) {
+    if (size == 0)
+        return;
+
+    const u32 first_page = addr >> PAGE_BITS;
+    const u32 last_page = (addr + size - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page)
+        TagPageWritten(page);
+}
+
+u32 BeginWriteEpoch() {
+    return current_write_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool IsRegionWrittenSince(const VAddr addr, const u32 size, const u32 epoch) {
+    if (size == 0)
+        return false;
+
+    const u32 first_page = addr >> PAGE_BITS;
+    const u32 last_page = (addr + size - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        if (page_write_epochs[page].load(std::memory_order_relaxed) >= epoch)
+            return true;
+    }
+    return false;
+}
+
+void MemoryBlock::DoState(PointerWrap& p) {
+    p.Do(handle);
+    p.Do(base_address);
+    p.Do(address);
+    p.Do(size);
+    p.Do(operation);
+    p.Do(permissions);
+}
+
+void DoState(PointerWrap& p) {
+    p.Do(heap_map);
+    p.Do(heap_linear_map);
+    p.Do(shared_map);
+
+    // Anything tracking writes has to assume that all of memory changed
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        const u32 epoch = BeginWriteEpoch();
+        for (auto& page_epoch : page_write_epochs)
+            page_epoch.store(epoch, std::memory_order_relaxed);
+    }
+}
+
 /**
  * Maps a block of memory on the heap
  * @param size Size of block in bytes
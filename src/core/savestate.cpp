@@ -0,0 +1,676 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#include "common/chunk_file.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/scm_rev.h"
+#include "common/string_util.h"
+#include "common/thread_pool.h"
+
+#include "core/arm/arm_interface.h"
+#include "core/arm/dyncom/arm_dyncom_interpreter.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/hle.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/hle/service/service.h"
+#include "core/hw/gpu.h"
+#include "core/mem_map.h"
+#include "core/savestate.h"
+#include "core/settings.h"
+
+#include "video_core/command_processor.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// SaveState namespace
+
+namespace SaveState {
+
+namespace {
+
+const u32 STATE_VERSION = 2;
+
+struct StateHeader {
+    char magic[4];
+    u32 version;
+    u64 program_id;
+    char scm_rev[48];     ///< Revision of the build which saved the state, states aren't portable
+    u64 state_size;       ///< Size of the PointerWrap serialized state following the header
+    u32 state_checksum;   ///< Adler32 of the serialized state
+    u32 num_chunks;       ///< Number of memory chunks, whose table follows the serialized state
+    u64 memory_size;      ///< Total size of all memory regions
+};
+static_assert(sizeof(StateHeader) == 88, "StateHeader has incorrect size");
+
+/**
+ * Memory regions are stored in chunks of this size, which are compressed independently. Chunks
+ * are also the unit in which checkpoints share unchanged memory, so they're kept small.
+ */
+const u32 CHUNK_SIZE = 4 * Memory::PAGE_SIZE;
+
+enum class ChunkType : u32 {
+    Zero = 0, ///< The chunk only contains zeroes and has no stored data
+    Raw = 1,  ///< The chunk is stored uncompressed
+    LZ4 = 2,  ///< The chunk is compressed with LZ4
+};
+
+struct ChunkHeader {
+    ChunkType type;
+    u32 stored_size; ///< Size of the stored data of the chunk
+};
+static_assert(sizeof(ChunkHeader) == 8, "ChunkHeader has incorrect size");
+
+/// A chunk of emulated memory, located in the host memory backing a memory region
+struct Chunk {
+    VAddr vaddr;
+    u8* data;
+    u32 size;
+};
+
+/// Contents of a memory chunk at the time a checkpoint was captured
+struct StoredChunk {
+    ChunkType type;
+    u64 hash;             ///< Hash of the uncompressed contents
+    std::vector<u8> data; ///< Raw or compressed contents, empty for zero chunks
+};
+
+/**
+ * A captured state of the system. Memory chunks which didn't change between two checkpoints are
+ * shared by them, so that each checkpoint only adds the memory which was written since the one
+ * before it.
+ */
+struct Checkpoint {
+    std::vector<u8> state; ///< State of everything but memory contents, serialized by PointerWrap
+    std::vector<std::shared_ptr<StoredChunk>> chunks;
+};
+
+/**
+ * Compresses captured checkpoints and writes them to files, so that the emulation thread only has
+ * to wait for memory to be copied. Tasks run in the order they were pushed, which guarantees that
+ * the chunks a checkpoint shares with earlier ones are final by the time it's written.
+ */
+std::unique_ptr<Common::ThreadPool> worker;
+
+/// Threads copying, hashing and decompressing memory chunks in parallel, kept across captures
+std::unique_ptr<Common::ThreadPool> chunk_pool;
+
+/**
+ * The checkpoint captured or loaded last, which the next capture shares unchanged chunks with.
+ * Only kept while automatic checkpoints are enabled, otherwise it would hold a copy of all of
+ * emulated memory just to speed up the occasional savestate.
+ */
+std::shared_ptr<Checkpoint> base_checkpoint;
+/// Write epoch which began right after base_checkpoint was captured or loaded
+u32 base_epoch;
+
+/// Automatic checkpoints which can be rewound to, oldest first
+std::deque<std::shared_ptr<Checkpoint>> rewind_checkpoints;
+/// Emulated time at which the next automatic checkpoint is due
+u64 next_checkpoint_ticks;
+
+std::mutex request_mutex;
+std::atomic<bool> request_pending(false);
+std::string save_request_path;
+std::string load_request_path;
+bool rewind_requested = false;
+
+StateHeader MakeHeader() {
+    StateHeader header = {};
+    std::memcpy(header.magic, "CST\x1A", sizeof(header.magic));
+    header.version = STATE_VERSION;
+    header.program_id = Kernel::g_program_id;
+    std::strncpy(header.scm_rev, Common::g_scm_rev, sizeof(header.scm_rev) - 1);
+    return header;
+}
+
+/// Splits all memory regions into chunks, in a stable order
+std::vector<Chunk> GetMemoryChunks(u64& memory_size) {
+    std::vector<Chunk> chunks;
+    memory_size = 0;
+    for (const Memory::MemoryRegion& region : Memory::GetMemoryRegions()) {
+        for (u32 offset = 0; offset < region.size; offset += CHUNK_SIZE) {
+            Chunk chunk = { region.vaddr + offset, region.pointer + offset,
+                            std::min(CHUNK_SIZE, region.size - offset) };
+            chunks.push_back(chunk);
+        }
+        memory_size += region.size;
+    }
+    return chunks;
+}
+
+bool IsZero(const u8* data, size_t size) {
+    // Chunk sizes are multiples of the page size, so they can be checked a word at a time
+    const u64* words = reinterpret_cast<const u64*>(data);
+    for (size_t i = 0; i < size / sizeof(u64); ++i) {
+        if (words[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+u64 HashChunk(const u8* data, u32 size) {
+    return GetHash64(data, static_cast<int>(size), 0);
+}
+
+bool IsRewindEnabled() {
+    return Settings::values.checkpoint_interval > 0;
+}
+
+/// Makes a checkpoint the base of the next capture if rewinding is enabled, drops the base if not
+void SetBaseCheckpoint(const std::shared_ptr<Checkpoint>& checkpoint) {
+    if (IsRewindEnabled()) {
+        base_checkpoint = checkpoint;
+        base_epoch = Memory::BeginWriteEpoch();
+    } else {
+        base_checkpoint = nullptr;
+    }
+}
+
+Common::ThreadPool& GetChunkPool() {
+    if (chunk_pool == nullptr)
+        chunk_pool.reset(new Common::ThreadPool(std::max(1u, std::thread::hardware_concurrency()),
+                                                "SaveState chunks"));
+    return *chunk_pool;
+}
+
+/**
+ * Runs a function for every index in [0, count) on the chunk pool, handing out indices in batches
+ * so that chunks of different compressibility balance out.
+ */
+template <typename Func>
+void ParallelFor(size_t count, Func func) {
+    const size_t batch_size = 64;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<size_t> next_index(0);
+
+    Common::ThreadPool& pool = GetChunkPool();
+    for (size_t i = 0; i < num_threads; ++i) {
+        pool.Push([&] {
+            size_t begin;
+            while ((begin = next_index.fetch_add(batch_size)) < count) {
+                const size_t end = std::min(begin + batch_size, count);
+                for (size_t index = begin; index < end; ++index)
+                    func(index);
+            }
+        });
+    }
+    pool.WaitForIdle();
+}
+
+Common::ThreadPool& GetWorker() {
+    if (worker == nullptr)
+        worker.reset(new Common::ThreadPool(1, "SaveState worker"));
+    return *worker;
+}
+
+void WaitForWorker() {
+    if (worker != nullptr)
+        worker->WaitForIdle();
+}
+
+/// Serializes a part of the system in its own section, so that mismatches are caught early on
+void DoSection(PointerWrap& p, const char* title, void (*do_state)(PointerWrap& p)) {
+    auto section = p.Section(title, 1);
+    if (section)
+        do_state(p);
+}
+
+void DoState(PointerWrap& p) {
+    // Objects are identified by their index in the object table while serializing
+    Kernel::ClearObjectTable();
+
+    DoSection(p, "CoreTiming", CoreTiming::DoState);
+    DoSection(p, "AppCore", [](PointerWrap& wrap) { Core::g_app_core->DoState(wrap); });
+    DoSection(p, "SysCore", [](PointerWrap& wrap) { Core::g_sys_core->DoState(wrap); });
+    DoSection(p, "Memory", Memory::DoState);
+    // Archives have to be reopened before the files in them are loaded by the kernel
+    DoSection(p, "FS", Service::FS::ArchiveDoState);
+    DoSection(p, "Kernel", Kernel::DoState);
+    DoSection(p, "Service", Service::DoState);
+    DoSection(p, "HLE", HLE::DoState);
+    DoSection(p, "GPU", GPU::DoState);
+    DoSection(p, "Pica", Pica::CommandProcessor::DoState);
+
+    Kernel::ClearObjectTable();
+}
+
+/**
+ * Captures the state of the system. Only memory chunks which were written since the base
+ * checkpoint are hashed and copied, the others are shared with it. The copies are compressed
+ * later on by the worker.
+ * @param new_chunks Receives the chunks which were copied
+ * @return The checkpoint, or nullptr if the state couldn't be serialized
+ */
+std::shared_ptr<Checkpoint> Capture(std::vector<std::shared_ptr<StoredChunk>>& new_chunks) {
+    // Asynchronous FS requests must not access emulated memory while it is being captured
+    Service::FS::WaitForAsyncTransfers();
+
+    auto checkpoint = std::make_shared<Checkpoint>();
+
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    DoState(measure);
+    checkpoint->state.resize(reinterpret_cast<size_t>(ptr));
+
+    ptr = checkpoint->state.data();
+    PointerWrap write(&ptr, PointerWrap::MODE_WRITE);
+    DoState(write);
+    if (write.error != PointerWrap::ERROR_NONE) {
+        LOG_ERROR(Core, "Failed to serialize the system state");
+        return nullptr;
+    }
+
+    u64 memory_size;
+    const std::vector<Chunk> chunks = GetMemoryChunks(memory_size);
+    const bool incremental = IsRewindEnabled() && base_checkpoint != nullptr &&
+                             base_checkpoint->chunks.size() == chunks.size();
+    checkpoint->chunks.resize(chunks.size());
+
+    ParallelFor(chunks.size(), [&](size_t index) {
+        const Chunk& chunk = chunks[index];
+        if (incremental && !Memory::IsRegionWrittenSince(chunk.vaddr, chunk.size, base_epoch)) {
+            checkpoint->chunks[index] = base_checkpoint->chunks[index];
+            return;
+        }
+
+        // Written chunks are often written back with the same contents, e.g. by memory fills
+        const u64 hash = HashChunk(chunk.data, chunk.size);
+        if (incremental && base_checkpoint->chunks[index]->hash == hash) {
+            checkpoint->chunks[index] = base_checkpoint->chunks[index];
+            return;
+        }
+
+        auto stored_chunk = std::make_shared<StoredChunk>();
+        stored_chunk->hash = hash;
+        if (IsZero(chunk.data, chunk.size)) {
+            stored_chunk->type = ChunkType::Zero;
+        } else {
+            stored_chunk->type = ChunkType::Raw;
+            stored_chunk->data.assign(chunk.data, chunk.data + chunk.size);
+        }
+        checkpoint->chunks[index] = std::move(stored_chunk);
+    });
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (!incremental || checkpoint->chunks[i] != base_checkpoint->chunks[i])
+            new_chunks.push_back(checkpoint->chunks[i]);
+    }
+
+    SetBaseCheckpoint(checkpoint);
+    return checkpoint;
+}
+
+/// Compresses chunks copied by Capture. Runs on the worker.
+void CompressChunks(const std::vector<std::shared_ptr<StoredChunk>>& chunks) {
+#ifdef HAVE_LZ4
+    std::vector<u8> buffer(LZ4_compressBound(CHUNK_SIZE));
+    for (const auto& chunk : chunks) {
+        if (chunk->type != ChunkType::Raw)
+            continue;
+
+        const int compressed_size = LZ4_compress_default(reinterpret_cast<const char*>(chunk->data.data()),
+                                                         reinterpret_cast<char*>(buffer.data()),
+                                                         static_cast<int>(chunk->data.size()),
+                                                         static_cast<int>(buffer.size()));
+        if (compressed_size > 0 && static_cast<size_t>(compressed_size) < chunk->data.size()) {
+            chunk->type = ChunkType::LZ4;
+            chunk->data.assign(buffer.begin(), buffer.begin() + compressed_size);
+        }
+    }
+#endif
+}
+
+/// Writes a checkpoint whose chunks have been compressed to a file. Runs on the worker.
+bool WriteCheckpoint(const std::string& path, const Checkpoint& checkpoint) {
+    u64 memory_size;
+    const std::vector<Chunk> chunks = GetMemoryChunks(memory_size);
+
+    StateHeader header = MakeHeader();
+    header.state_size = checkpoint.state.size();
+    header.state_checksum = HashAdler32(checkpoint.state.data(), checkpoint.state.size());
+    header.num_chunks = static_cast<u32>(checkpoint.chunks.size());
+    header.memory_size = memory_size;
+
+    std::vector<ChunkHeader> chunk_headers;
+    chunk_headers.reserve(checkpoint.chunks.size());
+    for (const auto& chunk : checkpoint.chunks) {
+        ChunkHeader chunk_header = { chunk->type, static_cast<u32>(chunk->data.size()) };
+        chunk_headers.push_back(chunk_header);
+    }
+
+    FileUtil::CreateFullPath(path);
+    FileUtil::IOFile file(path, "wb");
+    bool success = file.IsOpen() &&
+                   file.WriteBytes(&header, sizeof(header)) == sizeof(header) &&
+                   file.WriteBytes(checkpoint.state.data(), checkpoint.state.size()) == checkpoint.state.size() &&
+                   file.WriteArray(chunk_headers.data(), chunk_headers.size()) == chunk_headers.size();
+    for (size_t i = 0; success && i < checkpoint.chunks.size(); ++i) {
+        const std::vector<u8>& data = checkpoint.chunks[i]->data;
+        success = data.empty() || file.WriteBytes(data.data(), data.size()) == data.size();
+    }
+    success = file.Close() && success;
+
+    if (!success) {
+        LOG_ERROR(Core, "Failed to write savestate %s", path.c_str());
+        FileUtil::Delete(path);
+    }
+    return success;
+}
+
+/**
+ * Reads a savestate file into a checkpoint, validating everything before the running system is
+ * modified.
+ */
+std::shared_ptr<Checkpoint> ReadCheckpoint(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    FileUtil::MappedFileView view;
+    if (!file.IsOpen() || file.GetSize() < sizeof(StateHeader) || !view.Map(file, 0, file.GetSize())) {
+        LOG_ERROR(Core, "Failed to open savestate %s", path.c_str());
+        return nullptr;
+    }
+
+    StateHeader header;
+    std::memcpy(&header, view.GetData(), sizeof(header));
+    const StateHeader expected = MakeHeader();
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version) {
+        LOG_ERROR(Core, "%s is not a savestate of a supported version", path.c_str());
+        return nullptr;
+    }
+    if (std::strncmp(header.scm_rev, expected.scm_rev, sizeof(header.scm_rev)) != 0) {
+        LOG_ERROR(Core, "%s was saved by a different build (%.48s)", path.c_str(), header.scm_rev);
+        return nullptr;
+    }
+    if (header.program_id != expected.program_id) {
+        LOG_ERROR(Core, "%s was saved by a different application (%016llX)", path.c_str(),
+                  static_cast<unsigned long long>(header.program_id));
+        return nullptr;
+    }
+
+    u64 memory_size;
+    const std::vector<Chunk> chunks = GetMemoryChunks(memory_size);
+    const u64 chunks_offset = sizeof(header) + header.state_size;
+    const u64 data_offset = chunks_offset + chunks.size() * sizeof(ChunkHeader);
+    if (header.num_chunks != chunks.size() || header.memory_size != memory_size ||
+        data_offset > view.GetSize()) {
+        LOG_ERROR(Core, "Savestate %s is corrupted or has a different memory layout", path.c_str());
+        return nullptr;
+    }
+
+    const u8* state = view.GetData() + sizeof(header);
+    if (HashAdler32(state, static_cast<size_t>(header.state_size)) != header.state_checksum) {
+        LOG_ERROR(Core, "Savestate %s is corrupted", path.c_str());
+        return nullptr;
+    }
+
+    auto checkpoint = std::make_shared<Checkpoint>();
+    checkpoint->state.assign(state, state + header.state_size);
+
+    std::vector<ChunkHeader> chunk_headers(chunks.size());
+    std::memcpy(chunk_headers.data(), view.GetData() + chunks_offset, chunks.size() * sizeof(ChunkHeader));
+    u64 offset = data_offset;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const ChunkHeader& chunk_header = chunk_headers[i];
+        bool valid = (chunk_header.type == ChunkType::Zero && chunk_header.stored_size == 0) ||
+                     (chunk_header.type == ChunkType::Raw && chunk_header.stored_size == chunks[i].size);
+#ifdef HAVE_LZ4
+        valid = valid || chunk_header.type == ChunkType::LZ4;
+#endif
+        if (!valid || offset + chunk_header.stored_size > view.GetSize()) {
+            LOG_ERROR(Core, "Savestate %s is corrupted or uses unsupported compression", path.c_str());
+            return nullptr;
+        }
+
+        // Hashes are filled in once the chunks are decompressed
+        auto stored_chunk = std::make_shared<StoredChunk>();
+        stored_chunk->type = chunk_header.type;
+        stored_chunk->hash = 0;
+        stored_chunk->data.assign(view.GetData() + offset, view.GetData() + offset + chunk_header.stored_size);
+        checkpoint->chunks.push_back(std::move(stored_chunk));
+        offset += chunk_header.stored_size;
+    }
+    return checkpoint;
+}
+
+/**
+ * Restores the system to a checkpoint, which becomes the base of the next capture.
+ * @return False if the checkpoint couldn't be loaded. The system is in an undefined state then.
+ */
+bool LoadCheckpoint(const std::shared_ptr<Checkpoint>& checkpoint) {
+    // Chunks may still be compressed or written by the worker
+    WaitForWorker();
+    Service::FS::WaitForAsyncTransfers();
+
+    u64 memory_size;
+    const std::vector<Chunk> chunks = GetMemoryChunks(memory_size);
+    std::atomic<bool> memory_valid(chunks.size() == checkpoint->chunks.size());
+    if (memory_valid) {
+        ParallelFor(chunks.size(), [&](size_t index) {
+            const Chunk& chunk = chunks[index];
+            StoredChunk& stored_chunk = *checkpoint->chunks[index];
+            switch (stored_chunk.type) {
+            case ChunkType::Zero:
+                // Avoid touching untouched memory, so that the host doesn't have to back it
+                if (!IsZero(chunk.data, chunk.size))
+                    std::memset(chunk.data, 0, chunk.size);
+                break;
+            case ChunkType::Raw:
+                std::memcpy(chunk.data, stored_chunk.data.data(), chunk.size);
+                break;
+            case ChunkType::LZ4:
+#ifdef HAVE_LZ4
+                if (LZ4_decompress_safe(reinterpret_cast<const char*>(stored_chunk.data.data()),
+                                        reinterpret_cast<char*>(chunk.data),
+                                        static_cast<int>(stored_chunk.data.size()),
+                                        chunk.size) != static_cast<int>(chunk.size))
+                    memory_valid = false;
+#endif
+                break;
+            }
+            stored_chunk.hash = HashChunk(chunk.data, chunk.size);
+        });
+    }
+
+    u8* ptr = checkpoint->state.data();
+    PointerWrap read(&ptr, PointerWrap::MODE_READ);
+    if (memory_valid)
+        DoState(read);
+
+    // The memory contents and parts of the system have been replaced at this point already
+    if (!memory_valid || read.error != PointerWrap::ERROR_NONE ||
+        ptr != checkpoint->state.data() + checkpoint->state.size()) {
+        base_checkpoint = nullptr;
+        Core::Halt("Failed to load savestate");
+        return false;
+    }
+
+    // Code in memory was replaced, translated blocks of it are stale
+    InterpreterClearCache();
+
+    // Loading marked all of memory as written, now it matches the checkpoint again
+    SetBaseCheckpoint(checkpoint);
+    next_checkpoint_ticks = CoreTiming::GetTicks() + msToCycles(Settings::values.checkpoint_interval);
+    return true;
+}
+
+long long MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Captures a checkpoint and queues writing it to a file on the worker
+ * @param result If not nullptr, receives whether the file was written successfully
+ * @return False if the state couldn't be captured
+ */
+bool CaptureToFile(const std::string& path, std::shared_ptr<std::atomic<bool>> result) {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::shared_ptr<StoredChunk>> new_chunks;
+    std::shared_ptr<Checkpoint> checkpoint = Capture(new_chunks);
+    if (checkpoint == nullptr)
+        return false;
+
+    LOG_DEBUG(Core, "Captured state for %s in %lld ms, %u changed chunks", path.c_str(),
+              MillisecondsSince(start), static_cast<unsigned>(new_chunks.size()));
+
+    GetWorker().Push([path, checkpoint, new_chunks, result, start] {
+        CompressChunks(new_chunks);
+        const bool success = WriteCheckpoint(path, *checkpoint);
+        if (success)
+            LOG_INFO(Core, "Saved state to %s in %lld ms", path.c_str(), MillisecondsSince(start));
+        if (result != nullptr)
+            *result = success;
+    });
+    return true;
+}
+
+/// Captures an automatic checkpoint for rewinding
+void CaptureRewindCheckpoint() {
+    std::vector<std::shared_ptr<StoredChunk>> new_chunks;
+    std::shared_ptr<Checkpoint> checkpoint = Capture(new_chunks);
+    next_checkpoint_ticks = CoreTiming::GetTicks() + msToCycles(Settings::values.checkpoint_interval);
+    if (checkpoint == nullptr)
+        return;
+
+    GetWorker().Push([new_chunks] {
+        CompressChunks(new_chunks);
+    });
+
+    rewind_checkpoints.push_back(std::move(checkpoint));
+    while (rewind_checkpoints.size() > static_cast<size_t>(std::max(Settings::values.max_checkpoints, 1)))
+        rewind_checkpoints.pop_front();
+}
+
+} // anonymous namespace
+
+bool Save(const std::string& path) {
+    auto result = std::make_shared<std::atomic<bool>>(false);
+    if (!CaptureToFile(path, result))
+        return false;
+
+    WaitForWorker();
+    return *result;
+}
+
+bool Load(const std::string& path) {
+    const auto start = std::chrono::steady_clock::now();
+
+    WaitForWorker();
+    std::shared_ptr<Checkpoint> checkpoint = ReadCheckpoint(path);
+    if (checkpoint == nullptr)
+        return false;
+
+    if (!LoadCheckpoint(checkpoint)) {
+        LOG_CRITICAL(Core, "Failed to load savestate %s, the emulated system is in an undefined state",
+                     path.c_str());
+        return false;
+    }
+
+    LOG_INFO(Core, "Loaded state from %s in %lld ms", path.c_str(), MillisecondsSince(start));
+    return true;
+}
+
+bool Rewind() {
+    if (rewind_checkpoints.empty()) {
+        LOG_WARNING(Core, "No checkpoint to rewind to");
+        return false;
+    }
+
+    std::shared_ptr<Checkpoint> checkpoint = std::move(rewind_checkpoints.back());
+    rewind_checkpoints.pop_back();
+    if (!LoadCheckpoint(checkpoint)) {
+        LOG_CRITICAL(Core, "Failed to rewind, the emulated system is in an undefined state");
+        return false;
+    }
+
+    LOG_INFO(Core, "Rewound to a checkpoint, %u remaining", static_cast<unsigned>(rewind_checkpoints.size()));
+    return true;
+}
+
+void RequestSave(const std::string& path) {
+    std::lock_guard<std::mutex> lock(request_mutex);
+    save_request_path = path;
+    request_pending = true;
+}
+
+void RequestLoad(const std::string& path) {
+    std::lock_guard<std::mutex> lock(request_mutex);
+    load_request_path = path;
+    request_pending = true;
+}
+
+void RequestRewind() {
+    std::lock_guard<std::mutex> lock(request_mutex);
+    rewind_requested = true;
+    request_pending = true;
+}
+
+void ProcessRequests() {
+    const bool checkpoint_due = Settings::values.checkpoint_interval > 0 &&
+                                CoreTiming::GetTicks() >= next_checkpoint_ticks;
+    if (!checkpoint_due && !request_pending.load(std::memory_order_relaxed))
+        return;
+
+    std::string save_path, load_path;
+    bool rewind;
+    {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        save_path.swap(save_request_path);
+        load_path.swap(load_request_path);
+        rewind = rewind_requested;
+        rewind_requested = false;
+        request_pending = false;
+    }
+
+    Core::KernelLock lock;
+    if (!save_path.empty())
+        CaptureToFile(save_path, nullptr);
+    if (!load_path.empty())
+        Load(load_path);
+    else if (rewind)
+        Rewind();
+    else if (checkpoint_due)
+        CaptureRewindCheckpoint();
+}
+
+std::string GetDefaultPath() {
+    return FileUtil::GetUserPath(D_STATESAVES_IDX) +
+           Common::StringFromFormat("%016llX.cst", Kernel::g_program_id);
+}
+
+void Shutdown() {
+    // Lets pending writes finish
+    worker.reset();
+    chunk_pool.reset();
+
+    base_checkpoint = nullptr;
+    rewind_checkpoints.clear();
+    next_checkpoint_ticks = 0;
+
+    std::lock_guard<std::mutex> lock(request_mutex);
+    save_request_path.clear();
+    load_request_path.clear();
+    rewind_requested = false;
+    request_pending = false;
+}
+
+} // namespace
@@ -0,0 +1,74 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// SaveState namespace
+
+/**
+ * Savestates capture the complete emulated system: The contents of all memory regions, which are
+ * split into chunks and compressed independently, followed by the state of the CPU cores,
+ * CoreTiming, the kernel objects, HLE services and the GPU, which is serialized through PointerWrap.
+ *
+ * States are captured incrementally: Memory chunks which weren't written since the previous
+ * capture are shared with it instead of being copied again, and the copied chunks are compressed
+ * and written to disk on a worker thread while emulation continues. This makes it cheap to take
+ * automatic checkpoints in memory at a fixed interval, which can be rewound to.
+ *
+ * Host resources are not part of a savestate. Files opened by the application are reopened from
+ * their archives when loading, but the contents of save data and the SD card are not rolled back.
+ */
+namespace SaveState {
+
+/**
+ * Saves the state of the emulated system and waits until it has been written. Must be called from
+ * the emulation thread between two iterations of Core::RunLoop, see RequestSave for use from other
+ * threads, which doesn't wait for the file to be written.
+ * @param path Path of the file to write
+ * @return True on success
+ */
+bool Save(const std::string& path);
+
+/**
+ * Loads a state saved by Save. Must be called from the emulation thread between two iterations of
+ * Core::RunLoop, see RequestLoad for use from other threads. States of other applications or
+ * other Citra builds are rejected without touching the running system.
+ * @param path Path of the file to read
+ * @return True on success
+ */
+bool Load(const std::string& path);
+
+/**
+ * Returns to the most recent automatic checkpoint, which is removed so that rewinding again goes
+ * further back. Checkpoints are only taken if Settings::values.checkpoint_interval is set. Must be
+ * called from the emulation thread between two iterations of Core::RunLoop.
+ * @return True on success, false if there's no checkpoint left
+ */
+bool Rewind();
+
+/// Requests a savestate to be saved to the given path at the start of the next Core::RunLoop
+void RequestSave(const std::string& path);
+
+/// Requests a savestate to be loaded from the given path at the start of the next Core::RunLoop
+void RequestLoad(const std::string& path);
+
+/// Requests a rewind to the most recent checkpoint at the start of the next Core::RunLoop
+void RequestRewind();
+
+/**
+ * Performs pending requests and takes automatic checkpoints when they're due. Called by
+ * Core::RunLoop on the emulation thread.
+ */
+void ProcessRequests();
+
+/// Returns the default savestate path of the running application, in the state_saves directory
+std::string GetDefaultPath();
+
+/// Waits for pending savestate writes and drops all checkpoints
+void Shutdown();
+
+} // namespace
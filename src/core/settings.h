@@ -31,6 +31,14 @@ struct Values {
     // Core
     int gpu_refresh_rate;
     int frame_skip;
+    bool use_auto_frame_skip;
+    int max_auto_frame_skip;
+    bool skip_idle_loops;
+    int speed_limit;
+    bool use_multi_core;
+    bool use_async_fs;
+    int checkpoint_interval;
+    int max_checkpoints;
 
     // Data Storage
     bool use_virtual_sd;
@@ -39,6 +47,8 @@ struct Values {
     int region_value;
 
     std::string log_filter;
+    bool log_binary;
+    bool dump_gpu_data;
 } extern values;
 
 }
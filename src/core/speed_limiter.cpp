@@ -0,0 +1,131 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "common/logging/log.h"
+
+#include "core/core_timing.h"
+#include "core/settings.h"
+#include "core/speed_limiter.h"
+
+namespace SpeedLimiter {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::microseconds;
+
+/// Don't bother sleeping if emulation is ahead of real time by less than this
+static const microseconds kMinSleep(1000);
+/// The last part of a wait is spent spinning, since sleeps tend to overshoot
+static const microseconds kSpinThreshold(500);
+/// If emulation falls behind by more than this, resynchronize instead of catching up
+static const microseconds kMaxLag(100000);
+/// Length of the window over which the emulation speed is measured
+static const microseconds kSpeedWindow(1000000);
+
+/// Host time and emulated ticks at the current synchronization point
+static Clock::time_point sync_time;
+static u64 sync_ticks;
+
+/// Start of the current speed measurement window
+static Clock::time_point window_time;
+static u64 window_ticks;
+
+/// Emulation speed measured over the last window, in percent of real time (as raw double bits)
+static std::atomic<u64> speed_percent_bits(0);
+/// Total host time spent throttled, in microseconds
+static std::atomic<u64> throttled_time_us(0);
+
+/// Converts emulated ticks into host microseconds at the given percentage of real time
+static microseconds TicksToHostTime(u64 ticks, int speed_limit) {
+    return microseconds(static_cast<s64>(cyclesToUs(ticks) * 100 / speed_limit));
+}
+
+static void StoreSpeedPercent(double value) {
+    u64 bits;
+    static_assert(sizeof(bits) == sizeof(value), "Unexpected size of double");
+    std::memcpy(&bits, &value, sizeof(bits));
+    speed_percent_bits = bits;
+}
+
+static void Resynchronize(Clock::time_point now, u64 ticks) {
+    sync_time = now;
+    sync_ticks = ticks;
+}
+
+static void UpdateSpeed(Clock::time_point now, u64 ticks) {
+    const auto elapsed = std::chrono::duration_cast<microseconds>(now - window_time);
+    if (elapsed < kSpeedWindow)
+        return;
+
+    const double speed = cyclesToUs(ticks - window_ticks) * 100.0 / elapsed.count();
+    StoreSpeedPercent(speed);
+    LOG_TRACE(Core, "Emulation speed: %.1f%%", speed);
+
+    window_time = now;
+    window_ticks = ticks;
+}
+
+/// Called by CoreTiming at the end of every slice
+static void OnSliceEnd(int cycles_executed) {
+    const u64 ticks = CoreTiming::GetTicks();
+    Clock::time_point now = Clock::now();
+
+    const int speed_limit = Settings::values.speed_limit;
+    if (speed_limit <= 0) {
+        Resynchronize(now, ticks);
+        UpdateSpeed(now, ticks);
+        return;
+    }
+
+    const Clock::time_point target = sync_time + TicksToHostTime(ticks - sync_ticks, speed_limit);
+    if (target < now - kMaxLag) {
+        // Emulation can't keep up (or was paused), don't try to make up for the lost time later
+        Resynchronize(now, ticks);
+    } else if (target > now + kMinSleep) {
+        const Clock::time_point throttle_start = now;
+
+        if (target - now > kSpinThreshold)
+            std::this_thread::sleep_for(target - now - kSpinThreshold);
+        while ((now = Clock::now()) < target)
+            std::this_thread::yield();
+
+        throttled_time_us += std::chrono::duration_cast<microseconds>(now - throttle_start).count();
+    }
+
+    UpdateSpeed(now, ticks);
+}
+
+void Init() {
+    const Clock::time_point now = Clock::now();
+    const u64 ticks = CoreTiming::GetTicks();
+
+    Resynchronize(now, ticks);
+    window_time = now;
+    window_ticks = ticks;
+    StoreSpeedPercent(0.0);
+    throttled_time_us = 0;
+
+    CoreTiming::RegisterAdvanceCallback(&OnSliceEnd);
+}
+
+void Shutdown() {
+    CoreTiming::RegisterAdvanceCallback(nullptr);
+}
+
+double GetSpeedPercent() {
+    const u64 bits = speed_percent_bits;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+u64 GetThrottledTimeUs() {
+    return throttled_time_us;
+}
+
+} // namespace
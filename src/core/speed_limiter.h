@@ -0,0 +1,37 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+/**
+ * Keeps emulated time in line with host wall clock time.
+ *
+ * At the end of every CoreTiming slice, the emulated time elapsed since the last synchronization
+ * point is compared to the host time elapsed in the same period. If emulation is ahead of the
+ * configured speed limit (Settings::values.speed_limit, in percent of real time), the emulation
+ * thread sleeps until the host catches up. If emulation falls too far behind (e.g. because it
+ * was paused), the synchronization point is reset instead of trying to catch up.
+ */
+namespace SpeedLimiter {
+
+/// Starts a new synchronization period and hooks into CoreTiming. Call after CoreTiming::Init.
+void Init();
+
+void Shutdown();
+
+/**
+ * Returns the emulation speed in percent of real time, measured over the last completed
+ * measurement window (thread-safe).
+ */
+double GetSpeedPercent();
+
+/**
+ * Returns the total host time in microseconds the emulation thread spent throttled. Host time
+ * measurements which are meant to reflect the cost of emulation should subtract this (thread-safe).
+ */
+u64 GetThrottledTimeUs();
+
+} // namespace
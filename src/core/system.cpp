@@ -5,6 +5,8 @@
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/mem_map.h"
+#include "core/savestate.h"
+#include "core/speed_limiter.h"
 #include "core/system.h"
 #include "core/hw/hw.h"
 #include "core/hle/hle.h"
@@ -22,6 +24,7 @@ void UpdateState(State state) {
 void Init(EmuWindow* emu_window) {
     Core::Init();
     CoreTiming::Init();
+    SpeedLimiter::Init();
     Memory::Init();
     HW::Init();
     Kernel::Init();
@@ -37,11 +40,13 @@ void RunLoopUntil(u64 global_cycles) {
 }
 
 void Shutdown() {
+    SaveState::Shutdown();
     VideoCore::Shutdown();
     HLE::Shutdown();
     Kernel::Shutdown();
     HW::Shutdown();
     Memory::Shutdown();
+    SpeedLimiter::Shutdown();
     CoreTiming::Shutdown();
     Core::Shutdown();
 }
@@ -0,0 +1,71 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/common.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/filter.h"
+#include "common/logging/text_formatter.h"
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr, "Usage: %s [-f <filter>] <log file>...\n"
+                    "Decodes binary log files and prints the messages passing the filter.\n"
+                    "  -f <filter>  Log filter, e.g. \"*:Info Service.FS:Trace\" (default: *:Trace)\n"
+                    "Rotated files should be passed oldest first, e.g. citra_log.bin.1 citra_log.bin\n",
+            program);
+}
+
+/// Application entry point
+int __cdecl main(int argc, char** argv) {
+    std::string filter_string = "*:Trace";
+    std::vector<std::string> filenames;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter_string = argv[++i];
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return -1;
+        } else {
+            filenames.push_back(argv[i]);
+        }
+    }
+
+    if (filenames.empty()) {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    Log::Filter filter(Log::Level::Trace);
+    filter.ParseFilterString(filter_string);
+
+    std::array<char, 4 * 1024> format_buffer;
+    int result = 0;
+    for (const auto& filename : filenames) {
+        Log::BinaryLogReader reader;
+        if (!reader.Open(filename)) {
+            fprintf(stderr, "Failed to open log file %s\n", filename.c_str());
+            result = -1;
+            continue;
+        }
+
+        Log::Entry entry;
+        while (reader.ReadEntry(entry)) {
+            if (!filter.CheckMessage(entry.log_class, entry.log_level))
+                continue;
+
+            Log::FormatLogMessage(entry, format_buffer.data(), format_buffer.size());
+            fputs(format_buffer.data(), stdout);
+            fputc('\n', stdout);
+        }
+    }
+
+    return result;
+}
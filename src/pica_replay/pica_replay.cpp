@@ -0,0 +1,171 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common.h"
+#include "common/logging/text_formatter.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/scope_exit.h"
+
+#include "core/mem_map.h"
+
+#include "video_core/command_processor.h"
+#include "video_core/pica.h"
+#include "video_core/debug_utils/pica_trace_file.h"
+
+using Pica::DebugUtils::PicaTraceFile::RecordType;
+using Clock = std::chrono::high_resolution_clock;
+
+/// A trace record which needs to be processed during replay
+struct ReplayCommand {
+    RecordType type;
+    u32 args[3];
+};
+
+/// Fully decoded trace contents
+struct Trace {
+    std::vector<ReplayCommand> commands;
+    std::vector<std::vector<u8>> blobs; ///< Memory blobs, indexed by blob id
+};
+
+static bool LoadTrace(const std::string& filename, Trace& trace) {
+    Pica::DebugUtils::PicaTraceReader reader;
+    if (!reader.Open(filename))
+        return false;
+
+    Pica::DebugUtils::PicaTraceReader::Record record;
+    while (reader.ReadRecord(record)) {
+        if (record.type == RecordType::MemoryBlob) {
+            const u32 blob_id = record.args[0];
+            if (blob_id >= trace.blobs.size())
+                trace.blobs.resize(blob_id + 1);
+            trace.blobs[blob_id] = std::move(record.data);
+            continue;
+        }
+
+        if (record.type == RecordType::MemoryUpdate && record.args[1] >= trace.blobs.size()) {
+            LOG_ERROR(Frontend, "Memory update references unknown blob %u", record.args[1]);
+            return false;
+        }
+
+        ReplayCommand command;
+        command.type = record.type;
+        std::copy(std::begin(record.args), std::end(record.args), command.args);
+        trace.commands.push_back(command);
+    }
+    return true;
+}
+
+/// Application entry point
+int __cdecl main(int argc, char** argv) {
+    std::shared_ptr<Log::Logger> logger = Log::InitGlobalLogger();
+    Log::Filter log_filter(Log::Level::Info);
+    // GSP isn't running during replay, so don't complain about interrupts not being delivered
+    log_filter.ParseFilterString("*:Info Service.GSP:Error");
+    Log::SetGlobalFilter(&log_filter);
+    std::thread logging_thread(Log::TextLoggingLoop, logger, &log_filter);
+    SCOPE_EXIT({
+        Log::SetGlobalFilter(nullptr);
+        logger->Close();
+        logging_thread.join();
+    });
+
+    if (argc < 2) {
+        LOG_CRITICAL(Frontend, "Usage: %s <trace file> [iterations]", argv[0]);
+        return -1;
+    }
+
+    const std::string trace_filename = argv[1];
+    const int iterations = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 1;
+
+    // Decode everything upfront so that file I/O and decompression don't affect the measurements
+    Trace trace;
+    if (!LoadTrace(trace_filename, trace)) {
+        LOG_CRITICAL(Frontend, "Failed to load PICA trace %s", trace_filename.c_str());
+        return -1;
+    }
+
+    Memory::Init();
+    SCOPE_EXIT({ Memory::Shutdown(); });
+
+    u64 register_writes = 0;
+    u64 draw_calls = 0;
+    u64 command_lists = 0;
+    std::vector<double> frame_times_ms;
+
+    const auto replay_start = Clock::now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        auto frame_start = Clock::now();
+
+        for (const auto& command : trace.commands) {
+            switch (command.type) {
+            case RecordType::RegisterWrite:
+                if (command.args[0] == PICA_REG_INDEX(trigger_draw) ||
+                    command.args[0] == PICA_REG_INDEX(trigger_draw_indexed))
+                    ++draw_calls;
+
+                ++register_writes;
+                Pica::CommandProcessor::WritePicaReg(command.args[0], command.args[1], command.args[2]);
+                break;
+
+            case RecordType::MemoryUpdate:
+            {
+                const std::vector<u8>& blob = trace.blobs[command.args[1]];
+                const VAddr address = Pica::PAddrToVAddr(command.args[0]);
+                u8* dest = Memory::GetPointer(address);
+                if (dest == nullptr || blob.empty())
+                    break;
+
+                std::memcpy(dest, blob.data(), blob.size());
+                Memory::MarkRegionWritten(address, static_cast<u32>(blob.size()));
+                break;
+            }
+
+            case RecordType::CommandList:
+                ++command_lists;
+                break;
+
+            case RecordType::FrameEnd:
+            {
+                const auto now = Clock::now();
+                frame_times_ms.push_back(std::chrono::duration<double, std::milli>(now - frame_start).count());
+                frame_start = now;
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+    }
+    const double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - replay_start).count();
+
+    LOG_INFO(Frontend, "%s: %d iteration(s)", trace_filename.c_str(), iterations);
+    LOG_INFO(Frontend, "%llu register writes, %llu command lists, %llu draw calls, %zu memory blobs",
+             static_cast<unsigned long long>(register_writes), static_cast<unsigned long long>(command_lists),
+             static_cast<unsigned long long>(draw_calls), trace.blobs.size());
+    LOG_INFO(Frontend, "total: %.3f ms (%.0f register writes/s)",
+             total_ms, register_writes * 1000.0 / std::max(total_ms, 1e-3));
+
+    if (!frame_times_ms.empty()) {
+        std::sort(frame_times_ms.begin(), frame_times_ms.end());
+        double sum = 0.0;
+        for (double time : frame_times_ms)
+            sum += time;
+
+        LOG_INFO(Frontend, "frames: %zu, avg %.3f ms, min %.3f ms, median %.3f ms, max %.3f ms",
+                 frame_times_ms.size(), sum / frame_times_ms.size(), frame_times_ms.front(),
+                 frame_times_ms[frame_times_ms.size() / 2], frame_times_ms.back());
+    }
+
+    return 0;
+}
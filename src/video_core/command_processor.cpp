@@ -4,6 +4,8 @@
 
 #include <boost/range/algorithm/fill.hpp>
 
+#include "common/chunk_file.h"
+
 #include "clipper.h"
 #include "command_processor.h"
 #include "math.h"
@@ -14,6 +16,7 @@
 #include "core/hw/gpu.h"
 
 #include "debug_utils/debug_utils.h"
+#include "debug_utils/pica_trace_file.h"
 
 namespace Pica {
 
@@ -25,20 +28,24 @@ static int float_regs_counter = 0;
 
 static u32 uniform_write_buffer[4];
 
-static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
+void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     if (id >= registers.NumIds())
         return;
 
-    // If we're skipping this frame, only allow trigger IRQ
-    if (GPU::g_skip_frame && id != PICA_REG_INDEX(trigger_irq))
+    DebugUtils::RecordPicaRegWrite(id, value, mask);
+
+    // If we're skipping this frame, don't draw anything. All other register writes still need to
+    // be processed, since the state they set up may be used by subsequent (non-skipped) frames.
+    if (GPU::g_skip_frame &&
+        (id == PICA_REG_INDEX(trigger_draw) || id == PICA_REG_INDEX(trigger_draw_indexed)))
         return;
 
     // TODO: Figure out how register masking acts on e.g. vs_uniform_setup.set_value
     u32 old_value = registers[id];
     registers[id] = (old_value & ~mask) | (value & mask);
 
-    if (g_debug_context)
+    if (DebugUtils::DebugHooks::IsContextAttached())
         g_debug_context->OnEvent(DebugContext::Event::CommandLoaded, reinterpret_cast<void*>(&id));
 
     DebugUtils::OnPicaRegWrite(id, registers[id]);
@@ -53,9 +60,16 @@ static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
         case PICA_REG_INDEX(trigger_draw):
         case PICA_REG_INDEX(trigger_draw_indexed):
         {
-            DebugUtils::DumpTevStageConfig(registers.GetTevStages());
+            if (DebugUtils::DebugHooks::IsDumpingEnabled()) {
+                DebugUtils::DumpTevStageConfig(registers.GetTevStages());
+                for (const auto& texture : registers.GetTextures()) {
+                    if (texture.enabled)
+                        DebugUtils::DumpTexture(texture.config, texture.format,
+                                                Memory::GetPointer(PAddrToVAddr(texture.config.GetPhysicalAddress())));
+                }
+            }
 
-            if (g_debug_context)
+            if (DebugUtils::DebugHooks::IsContextAttached())
                 g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
             const auto& attribute_config = registers.vertex_attributes;
@@ -99,6 +113,7 @@ static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
             const u16* index_address_16 = (u16*)index_address_8;
             bool index_u16 = index_info.format != 0;
 
+            const bool dump_geometry = DebugUtils::DebugHooks::IsDumpingEnabled();
             DebugUtils::GeometryDumper geometry_dumper;
             PrimitiveAssembler<VertexShader::OutputVertex> clipper_primitive_assembler(registers.triangle_topology.Value());
             PrimitiveAssembler<DebugUtils::GeometryDumper::Vertex> dumping_primitive_assembler(registers.triangle_topology.Value());
@@ -153,18 +168,20 @@ static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
                 if (input.attr[0].w == debug_token)
                     input.attr[0].w = float24::FromFloat32(1.0);
 
-                if (g_debug_context)
+                if (DebugUtils::DebugHooks::IsContextAttached())
                     g_debug_context->OnEvent(DebugContext::Event::VertexLoaded, (void*)&input);
 
-                // NOTE: When dumping geometry, we simply assume that the first input attribute
-                //       corresponds to the position for now.
-                DebugUtils::GeometryDumper::Vertex dumped_vertex = {
-                    input.attr[0][0].ToFloat32(), input.attr[0][1].ToFloat32(), input.attr[0][2].ToFloat32()
-                };
-                using namespace std::placeholders;
-                dumping_primitive_assembler.SubmitVertex(dumped_vertex,
-                                                         std::bind(&DebugUtils::GeometryDumper::AddTriangle,
-                                                                   &geometry_dumper, _1, _2, _3));
+                if (dump_geometry) {
+                    // NOTE: When dumping geometry, we simply assume that the first input attribute
+                    //       corresponds to the position for now.
+                    DebugUtils::GeometryDumper::Vertex dumped_vertex = {
+                        input.attr[0][0].ToFloat32(), input.attr[0][1].ToFloat32(), input.attr[0][2].ToFloat32()
+                    };
+                    using namespace std::placeholders;
+                    dumping_primitive_assembler.SubmitVertex(dumped_vertex,
+                                                             std::bind(&DebugUtils::GeometryDumper::AddTriangle,
+                                                                       &geometry_dumper, _1, _2, _3));
+                }
 
                 // Send to vertex shader
                 VertexShader::OutputVertex output = VertexShader::RunShader(input, attribute_config.GetNumTotalAttributes());
@@ -176,9 +193,19 @@ static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
                 // Send to triangle clipper
                 clipper_primitive_assembler.SubmitVertex(output, Clipper::ProcessTriangle);
             }
-            geometry_dumper.Dump();
-
-            if (g_debug_context)
+            if (dump_geometry)
+                geometry_dumper.Dump();
+
+            // The rasterizer writes to the color and depth buffers through host pointers, so
+            // let memory write tracking know about the (potentially) modified framebuffer.
+            const auto& framebuffer = registers.framebuffer;
+            const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+            Memory::MarkRegionWritten(PAddrToVAddr(framebuffer.GetColorBufferPhysicalAddress()),
+                                      num_pixels * framebuffer.BytesPerColorPixel());
+            Memory::MarkRegionWritten(PAddrToVAddr(framebuffer.GetDepthBufferPhysicalAddress()),
+                                      num_pixels * framebuffer.BytesPerDepthPixel());
+
+            if (DebugUtils::DebugHooks::IsContextAttached())
                 g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
 
             break;
@@ -288,7 +315,7 @@ static inline void WritePicaReg(u32 id, u32 value, u32 mask) {
             break;
     }
 
-    if (g_debug_context)
+    if (DebugUtils::DebugHooks::IsContextAttached())
         g_debug_context->OnEvent(DebugContext::Event::CommandProcessed, reinterpret_cast<void*>(&id));
 }
 
@@ -327,6 +354,13 @@ void ProcessCommandList(const u32* list, u32 size) {
     }
 }
 
+void DoState(PointerWrap& p) {
+    p.DoVoid(&registers, sizeof(registers));
+    p.Do(float_regs_counter);
+    p.DoArray(uniform_write_buffer, ARRAY_SIZE(uniform_write_buffer));
+    VertexShader::DoState(p);
+}
+
 } // namespace
 
 } // namespace
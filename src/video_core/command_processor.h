@@ -9,6 +9,8 @@
 
 #include "pica.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 namespace CommandProcessor {
@@ -35,8 +37,19 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/**
+ * Applies a single write to a PICA register, performing any actions triggered by it.
+ * @param id Register index
+ * @param value Value to write
+ * @param mask Bits of the register which should be updated
+ */
+void WritePicaReg(u32 id, u32 value, u32 mask);
+
 void ProcessCommandList(const u32* list, u32 size);
 
+/// Saves or loads the PICA registers and the vertex shader setup, for savestates
+void DoState(PointerWrap& p);
+
 } // namespace
 
 } // namespace
@@ -9,6 +9,7 @@
 #include <fstream>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 
 #ifdef HAVE_PNG
 #include <png.h>
@@ -18,7 +19,9 @@
 
 #include "common/assert.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/math_util.h"
+#include "common/string_util.h"
 
 #include "video_core/color.h"
 #include "video_core/math.h"
@@ -74,6 +77,22 @@ std::shared_ptr<DebugContext> g_debug_context; // TODO: Get rid of this global
 
 namespace DebugUtils {
 
+bool DebugHooks::dumping_enabled = false;
+
+static std::mutex dumped_hashes_mutex;
+
+/**
+ * Remembers which data has been dumped already, so that a texture, shader or mesh used over and
+ * over again is only written to disk once.
+ * @param dumped_hashes Hashes of the data of one kind dumped so far
+ * @param hash Hash of the data about to be dumped
+ * @return True if the data hasn't been dumped before
+ */
+static bool IsNewDump(std::unordered_set<u64>& dumped_hashes, u64 hash) {
+    std::lock_guard<std::mutex> lock(dumped_hashes_mutex);
+    return dumped_hashes.insert(hash).second;
+}
+
 void GeometryDumper::AddTriangle(Vertex& v0, Vertex& v1, Vertex& v2) {
     vertices.push_back(v0);
     vertices.push_back(v1);
@@ -85,11 +104,17 @@ void GeometryDumper::AddTriangle(Vertex& v0, Vertex& v1, Vertex& v2) {
 
 void GeometryDumper::Dump() {
     // NOTE: Permanently enabling this just trashes the hard disk for no reason.
-    //       Hence, this is currently disabled.
-    return;
+    //       Hence, this is disabled unless dumping has been requested explicitly.
+    if (!DebugHooks::IsDumpingEnabled() || vertices.empty())
+        return;
+
+    static std::unordered_set<u64> dumped_hashes;
+    const u64 hash = GetHash64(reinterpret_cast<const u8*>(vertices.data()),
+                               static_cast<int>(vertices.size() * sizeof(Vertex)), 0);
+    if (!IsNewDump(dumped_hashes, hash))
+        return;
 
-    static int index = 0;
-    std::string filename = std::string("geometry_dump") + std::to_string(++index) + ".obj";
+    std::string filename = Common::StringFromFormat("geometry_dump_%016llX.obj", static_cast<unsigned long long>(hash));
 
     std::ofstream file(filename);
 
@@ -111,8 +136,17 @@ void DumpShader(const u32* binary_data, u32 binary_size, const u32* swizzle_data
                 u32 main_offset, const Regs::VSOutputAttributes* output_attributes)
 {
     // NOTE: Permanently enabling this just trashes hard disks for no reason.
-    //       Hence, this is currently disabled.
-    return;
+    //       Hence, this is disabled unless dumping has been requested explicitly.
+    if (!DebugHooks::IsDumpingEnabled())
+        return;
+
+    static std::unordered_set<u64> dumped_hashes;
+    const u64 hash = GetHash64(reinterpret_cast<const u8*>(binary_data),
+                               static_cast<int>(binary_size * sizeof(u32)), 0) ^
+                     GetHash64(reinterpret_cast<const u8*>(swizzle_data),
+                               static_cast<int>(swizzle_size * sizeof(u32)), 0) ^ main_offset;
+    if (!IsNewDump(dumped_hashes, hash))
+        return;
 
     struct StuffToWrite {
         u8* pointer;
@@ -242,8 +276,7 @@ void DumpShader(const u32* binary_data, u32 binary_size, const u32* swizzle_data
 
 
     // Write data to file
-    static int dump_index = 0;
-    std::string filename = std::string("shader_dump") + std::to_string(++dump_index) + std::string(".shbin");
+    std::string filename = Common::StringFromFormat("shader_dump_%016llX.shbin", static_cast<unsigned long long>(hash));
     std::ofstream file(filename, std::ios_base::out | std::ios_base::binary);
 
     for (auto& chunk : writing_queue) {
@@ -588,10 +621,12 @@ TextureInfo TextureInfo::FromPicaRegister(const Regs::TextureConfig& config,
     return info;
 }
 
-void DumpTexture(const Pica::Regs::TextureConfig& texture_config, u8* data) {
+void DumpTexture(const Pica::Regs::TextureConfig& texture_config, Pica::Regs::TextureFormat format,
+                 u8* data) {
     // NOTE: Permanently enabling this just trashes hard disks for no reason.
-    //       Hence, this is currently disabled.
-    return;
+    //       Hence, this is disabled unless dumping has been requested explicitly.
+    if (!DebugHooks::IsDumpingEnabled())
+        return;
 
 #ifndef HAVE_PNG
     return;
@@ -599,9 +634,16 @@ void DumpTexture(const Pica::Regs::TextureConfig& texture_config, u8* data) {
     if (!data)
         return;
 
+    const TextureInfo info = TextureInfo::FromPicaRegister(texture_config, format);
+    static std::unordered_set<u64> dumped_hashes;
+    const u64 hash = GetHash64(data, info.stride * info.height, 0) ^
+                     (static_cast<u64>(info.width) << 48) ^ (static_cast<u64>(info.height) << 32) ^
+                     static_cast<u64>(format);
+    if (!IsNewDump(dumped_hashes, hash))
+        return;
+
     // Write data to file
-    static int dump_index = 0;
-    std::string filename = std::string("texture_dump") + std::to_string(++dump_index) + std::string(".png");
+    std::string filename = Common::StringFromFormat("texture_dump_%016llX.png", static_cast<unsigned long long>(hash));
     u32 row_stride = texture_config.width * 3;
 
     u8* buf;
@@ -653,11 +695,6 @@ void DumpTexture(const Pica::Regs::TextureConfig& texture_config, u8* data) {
     buf = new u8[row_stride * texture_config.height];
     for (unsigned y = 0; y < texture_config.height; ++y) {
         for (unsigned x = 0; x < texture_config.width; ++x) {
-            TextureInfo info;
-            info.width = texture_config.width;
-            info.height = texture_config.height;
-            info.stride = row_stride;
-            info.format = registers.texture0_format;
             Math::Vec4<u8> texture_color = LookupTexture(data, x, y, info);
             buf[3 * x + y * row_stride    ] = texture_color.r();
             buf[3 * x + y * row_stride + 1] = texture_color.g();
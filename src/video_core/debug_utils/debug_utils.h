@@ -149,7 +149,31 @@ extern std::shared_ptr<DebugContext> g_debug_context; // TODO: Get rid of this g
 
 namespace DebugUtils {
 
-// Simple utility class for dumping geometry data to an OBJ file
+/**
+ * Policy deciding whether the debugging hooks in the PICA hot paths (debugger events and dumping
+ * of shaders, textures, geometry and TEV configurations) need to run. Call sites check it before
+ * evaluating any of the hooks' arguments. When building with DISABLE_PICA_DEBUG_HOOKS, all checks
+ * are constant and the hooks get compiled out entirely.
+ */
+struct DebugHooks {
+#ifdef DISABLE_PICA_DEBUG_HOOKS
+    static bool IsContextAttached() { return false; }
+    static bool IsDumpingEnabled() { return false; }
+#else
+    /// Returns true if a debugger is attached and needs to be notified about PICA events
+    static bool IsContextAttached() { return g_debug_context != nullptr; }
+    /// Returns true if GPU data should be dumped to disk
+    static bool IsDumpingEnabled() { return dumping_enabled; }
+#endif
+
+    /// Enables or disables dumping GPU data to disk. Dumping is disabled by default.
+    static void SetDumpingEnabled(bool enabled) { dumping_enabled = enabled; }
+
+private:
+    static bool dumping_enabled;
+};
+
+// Simple utility class for dumping geometry data to an OBJ file, each distinct mesh only once
 class GeometryDumper {
 public:
     struct Vertex {
@@ -169,6 +193,7 @@ private:
     std::vector<Face> faces;
 };
 
+/// Writes a vertex shader to a SHBIN file, unless the same shader has been dumped before
 void DumpShader(const u32* binary_data, u32 binary_size, const u32* swizzle_data, u32 swizzle_size,
                 u32 main_offset, const Regs::VSOutputAttributes* output_attributes);
 
@@ -214,7 +239,9 @@ struct TextureInfo {
 const Math::Vec4<u8> LookupTexture(const u8* source, int s, int t, const TextureInfo& info,
                                    bool disable_alpha = false);
 
-void DumpTexture(const Pica::Regs::TextureConfig& texture_config, u8* data);
+/// Writes a texture to a PNG file, unless the same texture has been dumped before
+void DumpTexture(const Pica::Regs::TextureConfig& texture_config, Pica::Regs::TextureFormat format,
+                 u8* data);
 
 void DumpTevStageConfig(const std::array<Pica::Regs::TevStageConfig,6>& stages);
 
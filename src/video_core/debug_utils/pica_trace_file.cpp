@@ -0,0 +1,364 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "common/hash.h"
+#include "common/logging/log.h"
+
+#include "core/mem_map.h"
+
+#include "video_core/pica.h"
+
+#include "pica_trace_file.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+
+using namespace PicaTraceFile;
+
+PicaTraceWriter::~PicaTraceWriter() {
+    Close();
+}
+
+bool PicaTraceWriter::Open(const std::string& filename) {
+    if (!file.Open(filename, "wb"))
+        return false;
+
+    Header header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+#ifdef HAVE_ZLIB
+    header.flags = FlagCompressed;
+#endif
+    file.WriteBytes(&header, sizeof(header));
+
+    chunk.reserve(kChunkSize);
+    regions.clear();
+    blobs.clear();
+    next_blob_id = 0;
+    return file.IsGood();
+}
+
+void PicaTraceWriter::Close() {
+    if (!file.IsOpen())
+        return;
+
+    FlushChunk();
+    file.Close();
+}
+
+void PicaTraceWriter::WriteRegister(u32 id, u32 value, u32 mask) {
+    PutRecordType(RecordType::RegisterWrite);
+    Put(id);
+    Put(value);
+    Put(mask);
+}
+
+void PicaTraceWriter::WriteMemory(PAddr address, u32 size) {
+    const VAddr virtual_address = PAddrToVAddr(address);
+    const u8* data = Memory::GetPointer(virtual_address);
+    if (size == 0 || data == nullptr)
+        return;
+
+    // Cheap path: Memory write tracking tells us if the range is still the way we recorded it
+    auto region = regions.find(address);
+    if (region != regions.end() && region->second.size == size &&
+        !Memory::IsRegionWrittenSince(virtual_address, size, region->second.write_epoch))
+        return;
+
+    const u32 write_epoch = Memory::BeginWriteEpoch();
+
+    // Only store the data itself if we haven't seen the exact same contents before
+    const u64 hash = GetHash64(data, static_cast<int>(size), 0);
+    auto blob = blobs.find(hash);
+    u32 blob_id;
+    if (blob != blobs.end() && blob->second.size == size) {
+        blob_id = blob->second.blob_id;
+    } else {
+        blob_id = next_blob_id++;
+        blobs[hash] = { size, blob_id };
+
+        PutRecordType(RecordType::MemoryBlob);
+        Put(blob_id);
+        Put(size);
+        Put(data, size);
+    }
+
+    PutRecordType(RecordType::MemoryUpdate);
+    Put(address);
+    Put(blob_id);
+
+    regions[address] = { size, blob_id, write_epoch };
+}
+
+void PicaTraceWriter::WriteCommandList(PAddr address, u32 size) {
+    WriteMemory(address, size);
+
+    PutRecordType(RecordType::CommandList);
+    Put(address);
+    Put(size);
+}
+
+void PicaTraceWriter::WriteFrameEnd() {
+    PutRecordType(RecordType::FrameEnd);
+}
+
+void PicaTraceWriter::Put(const void* data, size_t size) {
+    const u8* bytes = static_cast<const u8*>(data);
+    chunk.insert(chunk.end(), bytes, bytes + size);
+
+    if (chunk.size() >= kChunkSize)
+        FlushChunk();
+}
+
+void PicaTraceWriter::FlushChunk() {
+    if (chunk.empty())
+        return;
+
+    ChunkHeader header;
+    header.raw_size = static_cast<u32>(chunk.size());
+    header.stored_size = header.raw_size;
+    const u8* payload = chunk.data();
+
+#ifdef HAVE_ZLIB
+    uLongf compressed_size = compressBound(static_cast<uLong>(chunk.size()));
+    compressed_chunk.resize(compressed_size);
+    if (compress2(compressed_chunk.data(), &compressed_size, chunk.data(), static_cast<uLong>(chunk.size()),
+                  Z_BEST_SPEED) == Z_OK && compressed_size < chunk.size()) {
+        header.stored_size = static_cast<u32>(compressed_size);
+        payload = compressed_chunk.data();
+    }
+#endif
+
+    file.WriteBytes(&header, sizeof(header));
+    file.WriteBytes(payload, header.stored_size);
+    chunk.clear();
+}
+
+bool PicaTraceReader::Open(const std::string& filename) {
+    if (!file.Open(filename, "rb"))
+        return false;
+
+    Header header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) || header.magic != kMagic) {
+        LOG_ERROR(HW_GPU, "%s is not a PICA trace file", filename.c_str());
+        return false;
+    }
+
+    if (header.version != kVersion) {
+        LOG_ERROR(HW_GPU, "Unsupported PICA trace version %u (expected %u)", header.version, kVersion);
+        return false;
+    }
+
+    chunk.clear();
+    chunk_offset = 0;
+    return true;
+}
+
+bool PicaTraceReader::ReadRecord(Record& record) {
+    u8 type;
+    if (!Get(type))
+        return false;
+
+    record.type = static_cast<RecordType>(type);
+    switch (record.type) {
+    case RecordType::RegisterWrite:
+        return Get(record.args[0]) && Get(record.args[1]) && Get(record.args[2]);
+
+    case RecordType::MemoryBlob:
+        if (!Get(record.args[0]) || !Get(record.args[1]))
+            return false;
+
+        record.data.resize(record.args[1]);
+        return Get(record.data.data(), record.data.size());
+
+    case RecordType::MemoryUpdate:
+    case RecordType::CommandList:
+        return Get(record.args[0]) && Get(record.args[1]);
+
+    case RecordType::FrameEnd:
+        return true;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown PICA trace record type %u", type);
+        return false;
+    }
+}
+
+bool PicaTraceReader::Get(void* data, size_t size) {
+    u8* dest = static_cast<u8*>(data);
+
+    while (size > 0) {
+        if (chunk_offset == chunk.size() && !ReadChunk())
+            return false;
+
+        const size_t bytes = std::min(size, chunk.size() - chunk_offset);
+        std::memcpy(dest, &chunk[chunk_offset], bytes);
+        chunk_offset += bytes;
+        dest += bytes;
+        size -= bytes;
+    }
+    return true;
+}
+
+bool PicaTraceReader::ReadChunk() {
+    ChunkHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header))
+        return false;
+
+    chunk.resize(header.raw_size);
+    chunk_offset = 0;
+
+    if (header.stored_size == header.raw_size)
+        return file.ReadBytes(chunk.data(), chunk.size()) == chunk.size();
+
+#ifdef HAVE_ZLIB
+    compressed_chunk.resize(header.stored_size);
+    if (file.ReadBytes(compressed_chunk.data(), compressed_chunk.size()) != compressed_chunk.size())
+        return false;
+
+    uLongf raw_size = header.raw_size;
+    if (uncompress(chunk.data(), &raw_size, compressed_chunk.data(), header.stored_size) != Z_OK ||
+        raw_size != header.raw_size) {
+        LOG_ERROR(HW_GPU, "Failed to decompress PICA trace chunk");
+        return false;
+    }
+    return true;
+#else
+    LOG_ERROR(HW_GPU, "PICA trace is compressed, but zlib support was not compiled in");
+    return false;
+#endif
+}
+
+static std::unique_ptr<PicaTraceWriter> trace_writer;
+static std::mutex trace_writer_mutex;
+static std::atomic<bool> is_trace_recording(false);
+
+bool StartPicaTraceRecording(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    if (trace_writer) {
+        LOG_WARNING(HW_GPU, "StartPicaTraceRecording called even though recording already running!");
+        return false;
+    }
+
+    std::unique_ptr<PicaTraceWriter> writer(new PicaTraceWriter);
+    if (!writer->Open(filename)) {
+        LOG_ERROR(HW_GPU, "Failed to open %s for PICA trace recording", filename.c_str());
+        return false;
+    }
+
+    trace_writer = std::move(writer);
+    is_trace_recording = true;
+    return true;
+}
+
+bool IsPicaTraceRecording() {
+    return is_trace_recording;
+}
+
+void StopPicaTraceRecording() {
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    is_trace_recording = false;
+    trace_writer.reset();
+}
+
+/// Records all memory the draw call about to be triggered is going to read.
+static void RecordDrawMemory(PicaTraceWriter& writer, bool is_indexed) {
+    const u32 num_vertices = registers.num_vertices;
+    if (num_vertices == 0)
+        return;
+
+    const auto& attribute_config = registers.vertex_attributes;
+    const u32 base_address = attribute_config.GetPhysicalBaseAddress();
+
+    u32 max_vertex = num_vertices - 1;
+    if (is_indexed) {
+        const auto& index_info = registers.index_array;
+        const PAddr index_address = base_address + index_info.offset;
+        const bool index_u16 = index_info.format != 0;
+        const u8* index_address_8 = Memory::GetPointer(PAddrToVAddr(index_address));
+        const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
+        if (index_address_8 == nullptr)
+            return;
+
+        writer.WriteMemory(index_address, num_vertices * (index_u16 ? 2 : 1));
+
+        max_vertex = 0;
+        for (u32 index = 0; index < num_vertices; ++index)
+            max_vertex = std::max<u32>(max_vertex, index_u16 ? index_address_16[index] : index_address_8[index]);
+    }
+
+    for (const auto& loader_config : attribute_config.attribute_loaders) {
+        if (loader_config.component_count == 0)
+            continue;
+
+        writer.WriteMemory(base_address + loader_config.data_offset,
+                           loader_config.byte_count * (max_vertex + 1));
+    }
+
+    for (const auto& texture : registers.GetTextures()) {
+        if (!texture.enabled)
+            continue;
+
+        const u32 size = texture.config.width * texture.config.height *
+                         Regs::NibblesPerPixel(texture.format) / 2;
+        writer.WriteMemory(texture.config.GetPhysicalAddress(), size);
+    }
+}
+
+void RecordPicaRegWrite(u32 id, u32 value, u32 mask) {
+    // Double check to avoid pointless locking overhead
+    if (!is_trace_recording)
+        return;
+
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    if (!trace_writer)
+        return;
+
+    if (id == PICA_REG_INDEX(trigger_draw) || id == PICA_REG_INDEX(trigger_draw_indexed))
+        RecordDrawMemory(*trace_writer, id == PICA_REG_INDEX(trigger_draw_indexed));
+
+    trace_writer->WriteRegister(id, value, mask);
+}
+
+void RecordPicaCommandList(PAddr address, u32 size) {
+    if (!is_trace_recording)
+        return;
+
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    if (trace_writer)
+        trace_writer->WriteCommandList(address, size);
+}
+
+void RecordPicaFrameEnd() {
+    if (!is_trace_recording)
+        return;
+
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    if (trace_writer)
+        trace_writer->WriteFrameEnd();
+}
+
+void RecordPicaMemoryWrite(PAddr address, u32 size) {
+    if (!is_trace_recording)
+        return;
+
+    std::lock_guard<std::mutex> lock(trace_writer_mutex);
+    if (trace_writer)
+        trace_writer->WriteMemory(address, size);
+}
+
+} // namespace
+
+} // namespace
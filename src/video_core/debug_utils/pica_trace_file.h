@@ -0,0 +1,192 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+#include "core/mem_map.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+
+/**
+ * On-disk PICA trace format.
+ *
+ * A trace file starts with a Header, followed by a sequence of chunks. Each chunk consists of a
+ * ChunkHeader and its payload, which is zlib-compressed unless stored_size equals raw_size.
+ * The concatenated raw chunk payloads form a stream of records, each of which starts with a
+ * RecordType byte followed by its type-specific payload (all values little endian). Records may
+ * cross chunk boundaries.
+ *
+ * Memory contents are deduplicated: each distinct piece of data is stored only once in a
+ * MemoryBlob record and then referenced by MemoryUpdate records. Memory written by memory fills
+ * and display transfers is recorded the same way, right after the GPU wrote it.
+ */
+namespace PicaTraceFile {
+
+static const u32 kMagic = 0x43525450; // "PTRC"
+static const u32 kVersion = 1;
+
+/// Size of the raw record stream after which the writer emits a new chunk
+static const u32 kChunkSize = 1024 * 1024;
+
+struct Header {
+    u32 magic;
+    u32 version;
+    u32 flags;
+    u32 reserved;
+};
+static_assert(sizeof(Header) == 16, "Header has incorrect size!");
+
+enum HeaderFlags : u32 {
+    FlagCompressed = 1 << 0, ///< At least some chunks of this file are zlib-compressed
+};
+
+struct ChunkHeader {
+    u32 raw_size;    ///< Size of the chunk payload after decompression
+    u32 stored_size; ///< Size of the chunk payload in the file
+};
+static_assert(sizeof(ChunkHeader) == 8, "ChunkHeader has incorrect size!");
+
+enum class RecordType : u8 {
+    RegisterWrite = 0, ///< u32 id, u32 value, u32 mask
+    MemoryBlob    = 1, ///< u32 blob_id, u32 size, u8 data[size]
+    MemoryUpdate  = 2, ///< u32 physical_address, u32 blob_id
+    CommandList   = 3, ///< u32 physical_address, u32 size
+    FrameEnd      = 4, ///< (no payload)
+};
+
+} // namespace
+
+/// Streams a PICA trace to a file. Memory must be recorded before the register writes using it.
+class PicaTraceWriter {
+public:
+    ~PicaTraceWriter();
+
+    /**
+     * Opens the given file and writes the file header.
+     * @return True on success
+     */
+    bool Open(const std::string& filename);
+
+    /// Flushes all pending records and closes the file.
+    void Close();
+
+    void WriteRegister(u32 id, u32 value, u32 mask);
+
+    /**
+     * Records the current contents of the given physical memory range, unless the range has
+     * been recorded before and hasn't been modified since.
+     */
+    void WriteMemory(PAddr address, u32 size);
+
+    void WriteCommandList(PAddr address, u32 size);
+
+    void WriteFrameEnd();
+
+private:
+    /// State of a previously recorded memory range
+    struct RegionInfo {
+        u32 size;
+        u32 blob_id;
+        u32 write_epoch; ///< Memory write epoch started when the range was last recorded
+    };
+
+    /// Location of a previously recorded blob
+    struct BlobInfo {
+        u32 size;
+        u32 blob_id;
+    };
+
+    void Put(const void* data, size_t size);
+
+    template <typename T>
+    void Put(const T& value) {
+        Put(&value, sizeof(value));
+    }
+
+    void PutRecordType(PicaTraceFile::RecordType type) {
+        Put(static_cast<u8>(type));
+    }
+
+    /// Compresses and writes the pending record stream as a single chunk.
+    void FlushChunk();
+
+    FileUtil::IOFile file;
+    std::vector<u8> chunk;
+    std::vector<u8> compressed_chunk;
+
+    std::unordered_map<PAddr, RegionInfo> regions;
+    std::unordered_map<u64, BlobInfo> blobs; ///< Keyed by content hash
+    u32 next_blob_id = 0;
+};
+
+/// Reads a PICA trace from a file, one record at a time.
+class PicaTraceReader {
+public:
+    struct Record {
+        PicaTraceFile::RecordType type;
+        u32 args[3];
+        std::vector<u8> data; ///< Only used by MemoryBlob records
+    };
+
+    /**
+     * Opens the given file and validates its header.
+     * @return True on success
+     */
+    bool Open(const std::string& filename);
+
+    /**
+     * Reads the next record from the file.
+     * @return False if the end of the trace has been reached or the file is corrupt
+     */
+    bool ReadRecord(Record& record);
+
+private:
+    bool Get(void* data, size_t size);
+
+    template <typename T>
+    bool Get(T& value) {
+        return Get(&value, sizeof(value));
+    }
+
+    /// Reads and decompresses the next chunk from the file.
+    bool ReadChunk();
+
+    FileUtil::IOFile file;
+    std::vector<u8> chunk;
+    std::vector<u8> compressed_chunk;
+    size_t chunk_offset = 0;
+};
+
+/**
+ * Starts streaming all PICA register writes and the memory they reference to the given file.
+ * @return True on success
+ */
+bool StartPicaTraceRecording(const std::string& filename);
+bool IsPicaTraceRecording();
+void StopPicaTraceRecording();
+
+/// Records a register write. Called before the command processor applies the write.
+void RecordPicaRegWrite(u32 id, u32 value, u32 mask);
+/// Records a command list about to be submitted to the command processor.
+void RecordPicaCommandList(PAddr address, u32 size);
+/// Records the end of an emulated frame.
+void RecordPicaFrameEnd();
+/**
+ * Records the contents of memory the GPU wrote outside of the command processor, i.e. by memory
+ * fills and display transfers. Called after the write, so that replaying the trace reproduces it.
+ */
+void RecordPicaMemoryWrite(PAddr address, u32 size);
+
+} // namespace
+
+} // namespace
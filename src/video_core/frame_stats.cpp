@@ -0,0 +1,103 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "common/logging/log.h"
+#include "common/string_util.h"
+
+#include "video_core/frame_stats.h"
+
+namespace VideoCore {
+
+void FrameStats::RateCounter::Reset(Clock::time_point now) {
+    window_start = now;
+    frames_in_window = 0;
+    rate = 0.0;
+}
+
+void FrameStats::RateCounter::Count(Clock::time_point now) {
+    ++frames_in_window;
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - window_start);
+    if (elapsed >= std::chrono::milliseconds(kRateWindowMs)) {
+        rate = frames_in_window * 1000000.0 / elapsed.count();
+        window_start = now;
+        frames_in_window = 0;
+    }
+}
+
+FrameStats::FrameStats() {
+    Reset();
+}
+
+void FrameStats::Reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+
+    results = {};
+    emulated_rate.Reset(now);
+    presented_rate.Reset(now);
+    last_emulated_frame = now;
+    reset_time = now;
+}
+
+void FrameStats::OnFrameEmulated(u64 idle_us) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+
+    const s64 elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - last_emulated_frame).count();
+    const s64 frame_time_us = std::max<s64>(0, elapsed_us - static_cast<s64>(idle_us));
+    last_emulated_frame = now;
+
+    results.last_frame_time_ms = frame_time_us / 1000.0;
+    const size_t bucket = std::min<size_t>(static_cast<size_t>(frame_time_us / (kHistogramBucketMs * 1000)),
+                                           kHistogramBuckets - 1);
+    ++results.frame_time_histogram[bucket];
+
+    ++results.frames_emulated;
+
+    emulated_rate.Count(now);
+    results.emulated_fps = emulated_rate.rate;
+}
+
+void FrameStats::OnFrameDropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++results.frames_dropped;
+}
+
+void FrameStats::OnFramePresented() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+
+    ++results.frames_presented;
+
+    if (results.frames_presented == 1) {
+        const auto time_to_first_frame = std::chrono::duration_cast<std::chrono::microseconds>(now - reset_time);
+        LOG_INFO(Render, "First frame presented %.1f ms after startup", time_to_first_frame.count() / 1000.0);
+    }
+
+    const unsigned frames_before = presented_rate.frames_in_window;
+    presented_rate.Count(now);
+    results.presented_fps = presented_rate.rate;
+
+    // Log once per rate window, i.e. whenever the counter got reset
+    if (presented_rate.frames_in_window < frames_before) {
+        LOG_TRACE(Render, "Emulated %.2f FPS, presented %.2f FPS (%llu frames dropped)",
+                  results.emulated_fps, results.presented_fps, results.frames_dropped);
+    }
+}
+
+std::string FrameStats::Results::GetSummary() const {
+    return Common::StringFromFormat("%.1f FPS (%.1f emulated, %.1f ms/frame, %llu dropped)",
+                                    presented_fps, emulated_fps, last_frame_time_ms,
+                                    static_cast<unsigned long long>(frames_dropped));
+}
+
+FrameStats::Results FrameStats::GetResults() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return results;
+}
+
+} // namespace
@@ -0,0 +1,92 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Frame pacing statistics measured in host time. Frames are counted both when the emulator
+ * finishes them and when they are actually presented on the host display, which may happen at a
+ * different rate since presentation is decoupled from emulation.
+ * @note All member functions are thread-safe.
+ */
+class FrameStats {
+public:
+    /// Number of buckets in the emulated frame time histogram
+    static const size_t kHistogramBuckets = 16;
+    /// Width of a single histogram bucket in milliseconds. The last bucket collects all outliers.
+    static const unsigned kHistogramBucketMs = 4;
+
+    struct Results {
+        double emulated_fps;        ///< Frames finished by emulation per second of host time
+        double presented_fps;       ///< Frames presented on the host display per second
+        double last_frame_time_ms;  ///< Host time it took to emulate the last frame, excluding idle time
+
+        u64 frames_emulated;        ///< Total number of frames finished by emulation, including skipped ones
+        u64 frames_presented;       ///< Total number of frames presented on the host display
+        u64 frames_dropped;         ///< Frames replaced by a newer one before being presented
+
+        /// Distribution of host time per emulated frame
+        std::array<u64, kHistogramBuckets> frame_time_histogram;
+
+        /// Returns a one-line summary of the frame rates, for displaying in frontends
+        std::string GetSummary() const;
+    };
+
+    FrameStats();
+
+    /// Clears all statistics.
+    void Reset();
+
+    /**
+     * Records that emulation finished a frame. Called on every emulated VBlank, regardless of
+     * whether the frame was skipped.
+     * @param idle_us Host time in microseconds during the frame that wasn't spent emulating it
+     *                (e.g. sleeping in the speed limiter)
+     */
+    void OnFrameEmulated(u64 idle_us);
+
+    /// Records that a finished frame replaced a previous one which was never presented.
+    void OnFrameDropped();
+
+    /// Records that a frame was presented on the host display.
+    void OnFramePresented();
+
+    /// Returns a consistent snapshot of the current statistics.
+    Results GetResults() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Length of the window over which frame rates are averaged
+    static const unsigned kRateWindowMs = 1000;
+
+    /// Frame counter for a sliding rate measurement window
+    struct RateCounter {
+        Clock::time_point window_start;
+        unsigned frames_in_window = 0;
+        double rate = 0.0;
+
+        void Reset(Clock::time_point now);
+        void Count(Clock::time_point now);
+    };
+
+    mutable std::mutex mutex;
+
+    Results results;
+    RateCounter emulated_rate;
+    RateCounter presented_rate;
+    Clock::time_point last_emulated_frame;
+    Clock::time_point reset_time; ///< Used to log the time it took until the first frame showed up
+};
+
+} // namespace
@@ -459,6 +459,35 @@ struct Regs {
         inline u32 GetHeight() const {
             return height + 1;
         }
+
+        /// Returns the number of bytes per pixel of the color buffer
+        inline u32 BytesPerColorPixel() const {
+            switch (color_format) {
+            case RGBA8:
+                return 4;
+            case RGB8:
+                return 3;
+            case RGBA5551:
+            case RGB565:
+            case RGBA4:
+                return 2;
+            default:
+                // Unknown formats are assumed to be as large as the largest known one
+                return 4;
+            }
+        }
+
+        /// Returns the number of bytes per pixel of the depth buffer
+        inline u32 BytesPerDepthPixel() const {
+            switch (depth_format) {
+            case 0: // D16
+                return 2;
+            case 2: // D24
+                return 3;
+            default: // D24S8, or unknown
+                return 4;
+            }
+        }
     } framebuffer;
 
     INSERT_PADDING_WORDS(0xe0);
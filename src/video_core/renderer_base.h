@@ -6,6 +6,8 @@
 
 #include "common/common.h"
 
+#include "video_core/frame_stats.h"
+
 class RendererBase : NonCopyable {
 public:
 
@@ -48,8 +50,14 @@ public:
         return m_current_frame;
     }
 
+    /// Returns frame pacing statistics of the emulated and presented frames
+    VideoCore::FrameStats& GetFrameStats() {
+        return frame_stats;
+    }
+
 protected:
     f32 m_current_fps;              ///< Current framerate, should be set by the renderer
     int m_current_frame;            ///< Current frame, should be set by the renderer
+    VideoCore::FrameStats frame_stats; ///< Frame pacing statistics, updated by the GPU and the renderer
 
 };
@@ -5,12 +5,14 @@
 #include "core/hw/gpu.h"
 #include "core/mem_map.h"
 #include "common/emu_window.h"
+#include "common/thread.h"
 #include "video_core/video_core.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
 #include "video_core/renderer_opengl/gl_shaders.h"
 
 #include <algorithm>
+#include <cstring>
 
 /**
  * Vertex structure that the drawn screen rectangles are composed of.
@@ -56,56 +58,127 @@ RendererOpenGL::~RendererOpenGL() {
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers() {
-    render_window->MakeCurrent();
-
-    for(int i : {0, 1}) {
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[i];
-
-        if (textures[i].width != (GLsizei)framebuffer.width ||
-            textures[i].height != (GLsizei)framebuffer.height ||
-            textures[i].format != framebuffer.color_format) {
-            // Reallocate texture if the framebuffer size has changed.
-            // This is expected to not happen very often and hence should not be a
-            // performance problem.
-            ConfigureFramebufferTexture(textures[i], framebuffer);
-        }
+    Frame& frame = frame_mailbox.GetWriteBuffer();
 
-        LoadFBToActiveGLTexture(GPU::g_regs.framebuffer_config[i], textures[i]);
+    for (int i : {0, 1}) {
+        CaptureFramebuffer(GPU::g_regs.framebuffer_config[i], screen_sources[i], frame.screens[i]);
     }
 
-    DrawScreens();
+    if (frame_mailbox.Publish())
+        frame_stats.OnFrameDropped();
 
-    // Swap buffers
+    // Window events still need to be processed on the emulation thread, since some frontends
+    // (e.g. GLFW) require this to happen on the thread that created the window.
     render_window->PollEvents();
-    render_window->SwapBuffers();
 }
 
 /**
- * Loads framebuffer from emulated memory into the active OpenGL texture.
+ * Captures an emulated framebuffer so that it can be presented asynchronously.
+ *
+ * The framebuffer is only copied if its memory was written since the last capture, or if this
+ * frame of the mailbox still holds older contents. The pixels go straight into the pixel buffer
+ * mapped by the presentation thread if possible.
  */
-void RendererOpenGL::LoadFBToActiveGLTexture(const GPU::Regs::FramebufferConfig& framebuffer,
-                                             const TextureInfo& texture) {
+void RendererOpenGL::CaptureFramebuffer(const GPU::Regs::FramebufferConfig& framebuffer,
+                                        ScreenSource& source, ScreenFrame& screen) {
 
     const VAddr framebuffer_vaddr = Memory::PhysicalToVirtualAddress(
         framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2);
-
-    LOG_TRACE(Render_OpenGL, "0x%08x bytes from 0x%08x(%dx%d), fmt %x",
-        framebuffer.stride * framebuffer.height,
-        framebuffer_vaddr, (int)framebuffer.width,
-        (int)framebuffer.height, (int)framebuffer.format);
+    const u32 framebuffer_size = framebuffer.stride * framebuffer.height;
 
     const u8* framebuffer_data = Memory::GetPointer(framebuffer_vaddr);
+    if (framebuffer_data == nullptr)
+        return;
+
+    if (source.version == 0 ||
+        source.address != framebuffer_vaddr ||
+        source.width != framebuffer.width ||
+        source.height != framebuffer.height ||
+        source.stride != framebuffer.stride ||
+        source.format != framebuffer.color_format ||
+        Memory::IsRegionWrittenSince(framebuffer_vaddr, framebuffer_size, source.write_epoch)) {
+
+        LOG_TRACE(Render_OpenGL, "0x%08x bytes from 0x%08x(%dx%d), fmt %x",
+            framebuffer_size, framebuffer_vaddr, (int)framebuffer.width,
+            (int)framebuffer.height, (int)framebuffer.format);
+
+        // Start a new write tracking epoch before copying so that writes racing with the copy are
+        // picked up on the next frame.
+        source.write_epoch = Memory::BeginWriteEpoch();
+
+        source.address = framebuffer_vaddr;
+        source.width = framebuffer.width;
+        source.height = framebuffer.height;
+        source.stride = framebuffer.stride;
+        source.format = framebuffer.color_format;
+        ++source.version;
+    }
 
-    int bpp = GPU::Regs::BytesPerPixel(framebuffer.color_format);
-    size_t pixel_stride = framebuffer.stride / bpp;
+    // Since the mailbox rotates through several frames, this one might hold outdated contents even
+    // if the framebuffer itself did not change since the last capture. Emulated memory still holds
+    // the same contents in that case, so it can just be copied again.
+    if (screen.version == source.version)
+        return;
+
+    screen.width = source.width;
+    screen.height = source.height;
+    screen.stride = source.stride;
+    screen.format = source.format;
+    screen.version = source.version;
+
+    if (screen.mapped_data != nullptr && screen.buffer_size >= (GLsizeiptr)framebuffer_size) {
+        std::memcpy(screen.mapped_data, framebuffer_data, framebuffer_size);
+        screen.in_buffer = true;
+    } else {
+        screen.fallback_data.assign(framebuffer_data, framebuffer_data + framebuffer_size);
+        screen.in_buffer = false;
+    }
+}
+
+/**
+ * Loads a captured framebuffer into the active OpenGL texture.
+ *
+ * The upload is skipped if the texture already holds the given screen contents. Otherwise, the GL
+ * transfers the pixels from the frame's pixel buffer object to the texture asynchronously.
+ */
+void RendererOpenGL::LoadFBToActiveGLTexture(ScreenFrame& screen, TextureInfo& texture) {
+    if (screen.version == texture.version) {
+        // Texture is still up to date
+        return;
+    }
+
+    if (texture.width != (GLsizei)screen.width ||
+        texture.height != (GLsizei)screen.height ||
+        texture.format != screen.format) {
+        // Reallocate texture if the framebuffer size has changed.
+        // This is expected to not happen very often and hence should not be a
+        // performance problem.
+        ConfigureFramebufferTexture(texture, screen);
+    }
+
+    int bpp = GPU::Regs::BytesPerPixel(screen.format);
+    size_t pixel_stride = screen.stride / bpp;
 
     // OpenGL only supports specifying a stride in units of pixels, not bytes, unfortunately
-    ASSERT(pixel_stride * bpp == framebuffer.stride);
+    ASSERT(pixel_stride * bpp == screen.stride);
 
     // Ensure no bad interactions with GL_UNPACK_ALIGNMENT, which by default
     // only allows rows to have a memory alignement of 4.
     ASSERT(pixel_stride % 4 == 0);
 
+    texture.version = screen.version;
+
+    // Upload from the pixel buffer (offset 0) if the pixels were captured into it. Otherwise, fall
+    // back to a synchronous upload from client memory.
+    const GLvoid* pixels = nullptr;
+    if (screen.in_buffer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, screen.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        screen.mapped_data = nullptr;
+    } else {
+        pixels = screen.fallback_data.data();
+    }
+
     glBindTexture(GL_TEXTURE_2D, texture.handle);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)pixel_stride);
 
@@ -114,12 +187,70 @@ void RendererOpenGL::LoadFBToActiveGLTexture(const GPU::Regs::FramebufferConfig&
     //       differ from the LCD resolution.
     // TODO: Applications could theoretically crash Citra here by specifying too large
     //       framebuffer sizes. We should make sure that this cannot happen.
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
-        texture.gl_format, texture.gl_type, framebuffer_data);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, screen.width, screen.height,
+        texture.gl_format, texture.gl_type, pixels);
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
     glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/**
+ * Maps the pixel buffer of a screen frame, so that the emulation thread can capture into it the
+ * next time it gets hold of the frame.
+ *
+ * The buffer is left alone if it is still mapped and large enough for the current screen size.
+ * Otherwise, its storage is orphaned before mapping, so that the GL doesn't need to wait for
+ * pending uploads from the previous contents.
+ */
+void RendererOpenGL::MapScreenBuffer(ScreenFrame& screen) {
+    const GLsizeiptr size = (GLsizeiptr)screen.stride * screen.height;
+    if (screen.version == 0 || (screen.mapped_data != nullptr && screen.buffer_size >= size))
+        return;
+
+    if (screen.buffer == 0)
+        glGenBuffers(1, &screen.buffer);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, screen.buffer);
+    if (screen.mapped_data != nullptr)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    screen.buffer_size = size;
+    screen.mapped_data = static_cast<u8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/**
+ * Main loop of the presentation thread. Waits for frames finished by the emulation thread and
+ * presents the most recent one, so that neither thread ever blocks on the other.
+ */
+void RendererOpenGL::PresentationLoop() {
+    Common::SetCurrentThreadName("Presentation");
+    render_window->MakeCurrent();
+
+    while (Frame* frame = frame_mailbox.WaitForRead()) {
+        for (int i : {0, 1}) {
+            if (frame->screens[i].version != 0)
+                LoadFBToActiveGLTexture(frame->screens[i], textures[i]);
+        }
+
+        DrawScreens();
+
+        // Hand the frame back with mapped buffers. Mapping only happens after drawing, so that the
+        // upload isn't waited for when orphaning the buffer storage.
+        for (ScreenFrame& screen : frame->screens)
+            MapScreenBuffer(screen);
+
+        // Swap buffers
+        render_window->SwapBuffers();
+        frame_stats.OnFramePresented();
+    }
+
+    ShutDownOpenGLObjects();
+    render_window->DoneCurrent();
 }
 
 /**
@@ -154,6 +285,9 @@ void RendererOpenGL::InitOpenGLObjects() {
     // Allocate textures for each screen
     for (auto& texture : textures) {
         glGenTextures(1, &texture.handle);
+        texture.width = 0;
+        texture.height = 0;
+        texture.version = 0;
 
         // Allocation of storage is deferred until the first frame, when we
         // know the framebuffer size.
@@ -168,14 +302,34 @@ void RendererOpenGL::InitOpenGLObjects() {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
-                                                 const GPU::Regs::FramebufferConfig& framebuffer) {
-    GPU::Regs::PixelFormat format = framebuffer.color_format;
+/**
+ * Releases the OpenGL objects created by InitOpenGLObjects.
+ */
+void RendererOpenGL::ShutDownOpenGLObjects() {
+    // The emulation thread is shutting down the renderer, so it doesn't hold any frame anymore
+    frame_mailbox.ForEach([](Frame& frame) {
+        for (ScreenFrame& screen : frame.screens) {
+            if (screen.buffer != 0)
+                glDeleteBuffers(1, &screen.buffer);
+        }
+    });
+
+    for (auto& texture : textures) {
+        glDeleteTextures(1, &texture.handle);
+    }
+
+    glDeleteBuffers(1, &vertex_buffer_handle);
+    glDeleteVertexArrays(1, &vertex_array_handle);
+    glDeleteProgram(program_id);
+}
+
+void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture, const ScreenFrame& screen) {
+    GPU::Regs::PixelFormat format = screen.format;
     GLint internal_format;
 
     texture.format = format;
-    texture.width = framebuffer.width;
-    texture.height = framebuffer.height;
+    texture.width = screen.width;
+    texture.height = screen.height;
 
     switch (format) {
     case GPU::Regs::PixelFormat::RGBA8:
@@ -320,8 +474,25 @@ void RendererOpenGL::Init() {
 
     LOG_INFO(Render_OpenGL, "GL_VERSION: %s", glGetString(GL_VERSION));
     InitOpenGLObjects();
+
+    for (auto& source : screen_sources) {
+        source.version = 0;
+    }
+    // Pixel buffers are created and mapped by the presentation thread once it sees the frames
+    frame_mailbox.ForEach([](Frame& frame) {
+        frame = Frame();
+    });
+
+    // From now on, the GL context is exclusively used by the presentation thread
+    render_window->DoneCurrent();
+    frame_stats.Reset();
+    frame_mailbox.Reset();
+    presentation_thread = render_window->StartRenderThread([this] { PresentationLoop(); });
 }
 
 /// Shutdown the renderer
 void RendererOpenGL::ShutDown() {
+    frame_mailbox.Close();
+    if (presentation_thread.joinable())
+        presentation_thread.join();
 }
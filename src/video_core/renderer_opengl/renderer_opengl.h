@@ -5,10 +5,13 @@
 #pragma once
 
 #include <array>
+#include <thread>
+#include <vector>
 
 #include "generated/gl_3_2_core.h"
 
 #include "common/math_util.h"
+#include "common/triple_buffer.h"
 
 #include "core/hw/gpu.h"
 
@@ -22,7 +25,10 @@ public:
     RendererOpenGL();
     ~RendererOpenGL() override;
 
-    /// Swap buffers (render frame)
+    /**
+     * Swap buffers (render frame). This only captures the emulated framebuffers and hands them to
+     * the presentation thread, which takes care of actually drawing them.
+     */
     void SwapBuffers() override;
 
     /**
@@ -38,6 +44,42 @@ public:
     void ShutDown() override;
 
 private:
+    /**
+     * Copy of an emulated screen's framebuffer, captured on the emulation thread. The pixels are
+     * written straight into a pixel buffer object mapped by the presentation thread, which then
+     * uploads them to the screen texture without any intermediate copy.
+     */
+    struct ScreenFrame {
+        u32 width;
+        u32 height;
+        u32 stride;
+        GPU::Regs::PixelFormat format;
+        u64 version = 0;            ///< Version of the screen contents captured (0: none)
+
+        GLuint buffer = 0;          ///< Pixel buffer object, created by the presentation thread
+        GLsizeiptr buffer_size = 0; ///< Currently allocated buffer size in bytes
+        u8* mapped_data = nullptr;  ///< Write-only mapping of the buffer, or nullptr if unmapped
+        bool in_buffer = false;     ///< True if the pixels were written to mapped_data
+        /// Pixels captured while the buffer wasn't mapped or too small
+        std::vector<u8> fallback_data;
+    };
+
+    /// Frame handed from the emulation thread to the presentation thread
+    struct Frame {
+        std::array<ScreenFrame, 2> screens;
+    };
+
+    /// Emulation thread state tracking changes to an emulated screen
+    struct ScreenSource {
+        VAddr address;              ///< Emulated address the screen was last captured from
+        u32 width;
+        u32 height;
+        u32 stride;
+        GPU::Regs::PixelFormat format;
+        u32 write_epoch;            ///< Memory write tracking epoch started by the last capture
+        u64 version;                ///< Incremented whenever the screen contents change
+    };
+
     /// Structure used for storing information about the textures for each 3DS screen
     struct TextureInfo {
         GLuint handle;
@@ -46,18 +88,28 @@ private:
         GPU::Regs::PixelFormat format;
         GLenum gl_format;
         GLenum gl_type;
+        u64 version;                ///< Version of the screen contents last uploaded (0: none)
     };
 
     void InitOpenGLObjects();
-    static void ConfigureFramebufferTexture(TextureInfo& texture,
-                                            const GPU::Regs::FramebufferConfig& framebuffer);
+    void ShutDownOpenGLObjects();
+    static void ConfigureFramebufferTexture(TextureInfo& texture, const ScreenFrame& screen);
     void DrawScreens();
     void DrawSingleScreenRotated(const TextureInfo& texture, float x, float y, float w, float h);
     void UpdateFramerate();
 
-    // Loads framebuffer from emulated memory into the active OpenGL texture.
-    static void LoadFBToActiveGLTexture(const GPU::Regs::FramebufferConfig& framebuffer,
-                                        const TextureInfo& texture);
+    /// Main loop of the presentation thread
+    void PresentationLoop();
+
+    // Captures an emulated framebuffer into the given screen frame, if it changed.
+    static void CaptureFramebuffer(const GPU::Regs::FramebufferConfig& framebuffer,
+                                   ScreenSource& source, ScreenFrame& screen);
+
+    // Loads a captured framebuffer into the active OpenGL texture.
+    static void LoadFBToActiveGLTexture(ScreenFrame& screen, TextureInfo& texture);
+
+    // Maps the pixel buffer of a screen frame for the next capture into it.
+    static void MapScreenBuffer(ScreenFrame& screen);
 
     /// Computes the viewport rectangle
     MathUtil::Rectangle<unsigned> GetViewportExtent();
@@ -73,6 +125,13 @@ private:
     GLuint vertex_buffer_handle;
     GLuint program_id;
     std::array<TextureInfo, 2> textures;
+    std::array<ScreenSource, 2> screen_sources;
+
+    /// Mailbox passing finished frames to the presentation thread
+    Common::TripleBuffer<Frame> frame_mailbox;
+    /// Thread owning the GL context, drawing and presenting frames
+    std::thread presentation_thread;
+
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
     GLuint uniform_color_texture;
@@ -6,6 +6,7 @@
 
 #include <boost/range/algorithm.hpp>
 
+#include <common/chunk_file.h>
 #include <common/file_util.h>
 
 #include <core/mem_map.h>
@@ -39,6 +40,12 @@ static struct {
 static std::array<u32, 1024> shader_memory;
 static std::array<u32, 1024> swizzle_data;
 
+void DoState(PointerWrap& p) {
+    p.DoVoid(&shader_uniforms, sizeof(shader_uniforms));
+    p.DoVoid(shader_memory.data(), sizeof(shader_memory));
+    p.DoVoid(swizzle_data.data(), sizeof(swizzle_data));
+}
+
 void SubmitShaderMemoryChange(u32 addr, u32 value) {
     shader_memory[addr] = value;
 }
@@ -605,9 +612,10 @@ OutputVertex RunShader(const InputVertex& input, int num_attributes) {
     state.conditional_code[1] = false;
 
     ProcessShaderCode(state);
-    DebugUtils::DumpShader(shader_memory.data(), state.debug.max_offset, swizzle_data.data(),
-                           state.debug.max_opdesc_id, registers.vs_main_offset,
-                           registers.vs_output_attributes);
+    if (DebugUtils::DebugHooks::IsDumpingEnabled())
+        DebugUtils::DumpShader(shader_memory.data(), state.debug.max_offset, swizzle_data.data(),
+                               state.debug.max_opdesc_id, registers.vs_main_offset,
+                               registers.vs_output_attributes);
 
     LOG_TRACE(Render_Software, "Output vertex: pos (%.2f, %.2f, %.2f, %.2f), col(%.2f, %.2f, %.2f, %.2f), tc0(%.2f, %.2f)",
         ret.pos.x.ToFloat32(), ret.pos.y.ToFloat32(), ret.pos.z.ToFloat32(), ret.pos.w.ToFloat32(),
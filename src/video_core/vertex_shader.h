@@ -11,6 +11,8 @@
 #include "math.h"
 #include "pica.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 namespace VertexShader {
@@ -78,6 +80,9 @@ Math::Vec4<u8>& GetIntUniform(u32 index);
 const std::array<u32, 1024>& GetShaderBinary();
 const std::array<u32, 1024>& GetSwizzlePatterns();
 
+/// Saves or loads the shader uniforms, binary and swizzle patterns, for savestates
+void DoState(PointerWrap& p);
+
 } // namespace
 
 } // namespace
@@ -34,6 +34,7 @@ void Init(EmuWindow* emu_window) {
 
 /// Shutdown the video core
 void Shutdown() {
+    g_renderer->ShutDown();
     delete g_renderer;
     LOG_DEBUG(Render, "shutdown OK");
 }